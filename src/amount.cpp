@@ -31,3 +31,187 @@ std::string CFeeRate::ToString() const
 {
     return strprintf("%d.%08d %s/KB", nSatoshisPerK / COIN, nSatoshisPerK % COIN, CURRENCY_UNIT);
 }
+
+CAssetAmount CAssetAmount::Negated() const
+{
+    uint64_t nLowNeg = ~nLow + 1;
+    return CAssetAmount(~nHigh + (nLowNeg == 0 ? 1 : 0), nLowNeg);
+}
+
+bool CAssetAmount::Add(const CAssetAmount& a)
+{
+    uint64_t nLowSum = nLow + a.nLow;
+    uint64_t nHighSum = nHigh + a.nHigh + (nLowSum < nLow ? 1 : 0);
+    CAssetAmount sum(nHighSum, nLowSum);
+
+    // operands of the same sign must give a result of that sign
+    if (IsNegative() == a.IsNegative() && sum.IsNegative() != IsNegative())
+        return false;
+
+    *this = sum;
+    return true;
+}
+
+bool CAssetAmount::Sub(const CAssetAmount& a)
+{
+    if (a.nHigh == ((uint64_t)1 << 63) && a.nLow == 0)
+        return false; // the minimum value cannot be negated
+
+    return Add(a.Negated());
+}
+
+/** Multiply the 128-bit magnitude nHigh:nLow by n, fails if the product needs more than 127 bits */
+static bool MulMagnitude(uint64_t& nHigh, uint64_t& nLow, const uint64_t n)
+{
+    const uint64_t nMask = 0xffffffff;
+    uint64_t vIn[4] = {nLow & nMask, nLow >> 32, nHigh & nMask, nHigh >> 32};
+    uint64_t vOut[4];
+    uint64_t nCarry = 0;
+    for (int i = 0; i < 4; i++) {
+        // two 64x32 bit products per limb keep every partial sum within 64 bits
+        uint64_t nLo = vIn[i] * (n & nMask) + (nCarry & nMask);
+        uint64_t nHi = vIn[i] * (n >> 32) + (nLo >> 32) + (nCarry >> 32);
+        vOut[i] = nLo & nMask;
+        nCarry = nHi;
+    }
+    if (nCarry != 0 || (vOut[3] >> 31) != 0)
+        return false;
+
+    nHigh = (vOut[3] << 32) | vOut[2];
+    nLow = (vOut[1] << 32) | vOut[0];
+    return true;
+}
+
+/** Divide the 128-bit magnitude nHigh:nLow by n, returning the remainder */
+static uint64_t DivMagnitude(uint64_t& nHigh, uint64_t& nLow, const uint64_t n)
+{
+    uint64_t nRem = 0;
+    for (int i = 127; i >= 0; i--) {
+        uint64_t nBit = (i >= 64 ? nHigh >> (i - 64) : nLow >> i) & 1;
+        bool fOver = (nRem >> 63) != 0;
+        nRem = (nRem << 1) | nBit;
+        if (fOver || nRem >= n) {
+            nRem -= n;
+            if (i >= 64)
+                nHigh |= (uint64_t)1 << (i - 64);
+            else
+                nLow |= (uint64_t)1 << i;
+        } else {
+            if (i >= 64)
+                nHigh &= ~((uint64_t)1 << (i - 64));
+            else
+                nLow &= ~((uint64_t)1 << i);
+        }
+    }
+    return nRem;
+}
+
+bool CAssetAmount::Mul(const CAmount& n)
+{
+    bool fNegative = IsNegative() != (n < 0);
+    CAssetAmount magnitude = IsNegative() ? Negated() : *this;
+    if (magnitude.IsNegative())
+        return false; // the minimum value has no positive magnitude
+
+    uint64_t nAbs = n < 0 ? ~(uint64_t)n + 1 : (uint64_t)n;
+    if (!MulMagnitude(magnitude.nHigh, magnitude.nLow, nAbs))
+        return false;
+
+    *this = fNegative ? magnitude.Negated() : magnitude;
+    return true;
+}
+
+bool CAssetAmount::Div(const CAmount& n)
+{
+    if (n == 0)
+        return false;
+
+    bool fNegative = IsNegative() != (n < 0);
+    CAssetAmount magnitude = IsNegative() ? Negated() : *this;
+    uint64_t nAbs = n < 0 ? ~(uint64_t)n + 1 : (uint64_t)n;
+    DivMagnitude(magnitude.nHigh, magnitude.nLow, nAbs);
+    if (!fNegative && magnitude.IsNegative())
+        return false; // the minimum value divided by -1
+
+    *this = fNegative ? magnitude.Negated() : magnitude;
+    return true;
+}
+
+bool CAssetAmount::GetAmount(CAmount& nAmount) const
+{
+    // in range when the high word is the sign extension of the low word
+    if (nHigh != ((nLow >> 63) != 0 ? ~(uint64_t)0 : 0))
+        return false;
+
+    nAmount = (CAmount)nLow;
+    return true;
+}
+
+std::string CAssetAmount::ToString(const uint8_t& nDecimals) const
+{
+    CAssetAmount magnitude = IsNegative() ? Negated() : *this;
+
+    std::string strDigits;
+    do {
+        strDigits.push_back('0' + DivMagnitude(magnitude.nHigh, magnitude.nLow, 10));
+    } while (magnitude.nHigh != 0 || magnitude.nLow != 0);
+
+    if (strDigits.size() <= nDecimals)
+        strDigits.resize(nDecimals + 1, '0');
+
+    std::string str;
+    if (IsNegative())
+        str.push_back('-');
+    str.append(strDigits.rbegin(), strDigits.rend() - nDecimals);
+    if (nDecimals > 0) {
+        str.push_back('.');
+        str.append(strDigits.rend() - nDecimals, strDigits.rend());
+    }
+    return str;
+}
+
+bool CAssetAmount::Parse(const std::string& str, const uint8_t& nDecimals, CAssetAmount& amount)
+{
+    std::string::size_type nPos = 0;
+    bool fNegative = false;
+    if (nPos < str.size() && (str[nPos] == '-' || str[nPos] == '+'))
+        fNegative = str[nPos++] == '-';
+
+    CAssetAmount result;
+    bool fPoint = false;
+    bool fDigit = false;
+    int nFraction = 0;
+    for (; nPos < str.size(); nPos++) {
+        char c = str[nPos];
+        if (c == '.' && !fPoint) {
+            fPoint = true;
+            continue;
+        }
+        if (c < '0' || c > '9')
+            return false;
+        fDigit = true;
+        if (fPoint && nFraction >= nDecimals)
+            continue;
+        if (!result.Mul(10) || !result.Add(CAmount(c - '0')))
+            return false;
+        if (fPoint)
+            nFraction++;
+    }
+    if (!fDigit)
+        return false;
+
+    for (; nFraction < nDecimals; nFraction++) {
+        if (!result.Mul(10))
+            return false;
+    }
+
+    amount = fNegative ? result.Negated() : result;
+    return true;
+}
+
+bool operator<(const CAssetAmount& a, const CAssetAmount& b)
+{
+    if (a.nHigh != b.nHigh)
+        return (int64_t)a.nHigh < (int64_t)b.nHigh;
+    return a.nLow < b.nLow;
+}
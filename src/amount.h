@@ -64,4 +64,55 @@ public:
     }
 };
 
+/** Signed 128-bit asset amount for sums which may exceed the CAmount range,
+ * such as the total received by an address over many transactions.
+ * Arithmetic is overflow checked: on overflow the value is left unchanged
+ * and false is returned.
+ */
+class CAssetAmount
+{
+private:
+    // two's complement, nHigh holds the sign
+    uint64_t nHigh;
+    uint64_t nLow;
+
+    CAssetAmount(const uint64_t nHighIn, const uint64_t nLowIn) : nHigh(nHighIn), nLow(nLowIn) { }
+
+    bool IsNegative() const { return (nHigh >> 63) != 0; }
+    CAssetAmount Negated() const;
+
+public:
+    CAssetAmount() : nHigh(0), nLow(0) { }
+    CAssetAmount(const CAmount& nAmount) : nHigh(nAmount < 0 ? ~(uint64_t)0 : 0), nLow((uint64_t)nAmount) { }
+
+    bool Add(const CAssetAmount& a);
+    bool Sub(const CAssetAmount& a);
+    bool Mul(const CAmount& n);
+    /** Divide by n, rounding toward zero */
+    bool Div(const CAmount& n);
+
+    /** Convert back to CAmount, fails if the value is outside the CAmount range */
+    bool GetAmount(CAmount& nAmount) const;
+
+    /** Format with nDecimals digits after the decimal point, e.g. 1234 with 2 decimals is "12.34" */
+    std::string ToString(const uint8_t& nDecimals) const;
+    /** Parse a decimal string such as "-12.34", digits beyond nDecimals are truncated */
+    static bool Parse(const std::string& str, const uint8_t& nDecimals, CAssetAmount& amount);
+
+    friend bool operator<(const CAssetAmount& a, const CAssetAmount& b);
+    friend bool operator==(const CAssetAmount& a, const CAssetAmount& b) { return a.nHigh == b.nHigh && a.nLow == b.nLow; }
+    friend bool operator!=(const CAssetAmount& a, const CAssetAmount& b) { return !(a == b); }
+    friend bool operator>(const CAssetAmount& a, const CAssetAmount& b) { return b < a; }
+    friend bool operator<=(const CAssetAmount& a, const CAssetAmount& b) { return !(b < a); }
+    friend bool operator>=(const CAssetAmount& a, const CAssetAmount& b) { return !(a < b); }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(nHigh);
+        READWRITE(nLow);
+    }
+};
+
 #endif //  BITCOIN_AMOUNT_H
@@ -3,8 +3,10 @@
 #include "main.h"
 #include "validation.h"
 #include "utilstrencodings.h"
+#include "sync.h"
 
 #include <algorithm>
+#include <deque>
 
 using namespace std;
 
@@ -304,7 +306,7 @@ vector<unsigned char> FillTransferSafeData(const CAppHeader& header, const CTran
     return vData;
 }
 
-static void ParseHeader(const vector<unsigned char>& vData, CAppHeader& header, unsigned int& nOffset)
+static void ParseHeader(const CTxOutReserve& vData, CAppHeader& header, unsigned int& nOffset)
 {
     nOffset = TXOUT_RESERVE_MIN_SIZE;
 
@@ -323,7 +325,7 @@ static void ParseHeader(const vector<unsigned char>& vData, CAppHeader& header,
     nOffset += sizeof(header.nAppCmd);
 }
 
-bool ParseReserve(const vector<unsigned char>& vReserve, CAppHeader& header, vector<unsigned char>& vData)
+bool ParseReserve(const CTxOutReserve& vReserve, CAppHeader& header, vector<unsigned char>& vData)
 {
     if(vReserve.size() <= TXOUT_RESERVE_MIN_SIZE + sizeof(uint16_t) + 32 + sizeof(uint32_t))
         return false;
@@ -482,6 +484,121 @@ bool ParseTransferSafeData(const vector<unsigned char>& vSafeData, CTransferSafe
     return true;
 }
 
+CAppPayload::CAppPayload(const CAppHeader& headerIn, const vector<unsigned char>& vDataIn)
+    : header(headerIn), vData(vDataIn), fBody(false)
+{
+    switch(header.nAppCmd)
+    {
+    case REGISTER_APP_CMD:
+    {
+        CAppData appData;
+        fBody = ParseRegisterData(vData, appData, &strAdminAddress);
+        body = appData;
+        break;
+    }
+    case ADD_AUTH_CMD:
+    case DELETE_AUTH_CMD:
+    {
+        CAuthData authData;
+        fBody = ParseAuthData(vData, authData, &strAdminAddress);
+        body = authData;
+        break;
+    }
+    case CREATE_EXTEND_TX_CMD:
+    {
+        CExtendData extendData;
+        fBody = ParseExtendData(vData, extendData);
+        body = extendData;
+        break;
+    }
+    case ISSUE_ASSET_CMD:
+    {
+        CAssetData assetData;
+        fBody = ParseIssueData(vData, assetData);
+        if(fBody)
+            assetId = assetData.GetHash();
+        body = assetData;
+        break;
+    }
+    case ADD_ASSET_CMD:
+    case TRANSFER_ASSET_CMD:
+    case DESTORY_ASSET_CMD:
+    case CHANGE_ASSET_CMD:
+    {
+        CCommonData commonData;
+        fBody = ParseCommonData(vData, commonData);
+        if(fBody)
+            assetId = commonData.assetId;
+        body = commonData;
+        break;
+    }
+    case PUT_CANDY_CMD:
+    {
+        CPutCandyData putCandyData;
+        fBody = ParsePutCandyData(vData, putCandyData);
+        if(fBody)
+            assetId = putCandyData.assetId;
+        body = putCandyData;
+        break;
+    }
+    case GET_CANDY_CMD:
+    {
+        CGetCandyData getCandyData;
+        fBody = ParseGetCandyData(vData, getCandyData);
+        if(fBody)
+            assetId = getCandyData.assetId;
+        body = getCandyData;
+        break;
+    }
+    case TRANSFER_SAFE_CMD:
+    {
+        CTransferSafeData transferSafeData;
+        fBody = ParseTransferSafeData(vData, transferSafeData);
+        body = transferSafeData;
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static CCriticalSection cs_appPayload;
+static map<uint256, CAppPayloadRef> mapAppPayload;
+static deque<uint256> dqAppPayload; // insertion order, oldest first
+
+CAppPayloadRef GetAppPayload(const CTxOutReserve& vReserve)
+{
+    if(vReserve.size() <= TXOUT_RESERVE_MIN_SIZE + sizeof(uint16_t) + 32 + sizeof(uint32_t))
+        return CAppPayloadRef();
+
+    uint256 hash = Hash(vReserve.begin(), vReserve.end());
+    {
+        LOCK(cs_appPayload);
+        map<uint256, CAppPayloadRef>::const_iterator it = mapAppPayload.find(hash);
+        if(it != mapAppPayload.end())
+            return it->second;
+    }
+
+    // decode outside the lock, a concurrent decode of the same reserve yields an equal payload
+    CAppHeader header;
+    vector<unsigned char> vData;
+    if(!ParseReserve(vReserve, header, vData))
+        return CAppPayloadRef();
+    CAppPayloadRef payload(new CAppPayload(header, vData));
+
+    LOCK(cs_appPayload);
+    if(mapAppPayload.insert(make_pair(hash, payload)).second)
+    {
+        dqAppPayload.push_back(hash);
+        while(dqAppPayload.size() > MAX_APP_PAYLOAD_CACHE_SIZE)
+        {
+            mapAppPayload.erase(dqAppPayload.front());
+            dqAppPayload.pop_front();
+        }
+    }
+    return payload;
+}
+
 bool ExistAppName(const string& strAppName, const bool fWithMempool)
 {
     uint256 appId;
@@ -5,6 +5,10 @@
 #include "uint256.h"
 #include "serialize.h"
 #include "amount.h"
+#include "primitives/transaction.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/variant.hpp>
 
 #define REGISTER_TXOUT          4
 #define ADD_AUTH_TXOUT          5
@@ -580,6 +584,61 @@ public:
     }
 };
 
+/**
+ * Decoded app payload of a txout reserve. The body matching header.nAppCmd is
+ * parsed once when the payload is built, fBody tells whether it was valid.
+ * Only that body is kept, the getters of the other bodies return an empty one.
+ * Payloads are shared through GetAppPayload and must not be modified.
+ */
+class CAppPayload
+{
+public:
+    CAppHeader header;
+    std::vector<unsigned char> vData;
+    bool fBody;
+    uint256 assetId; // asset commands only
+    std::string strAdminAddress; // register and auth commands only
+
+    CAppPayload(const CAppHeader& headerIn, const std::vector<unsigned char>& vDataIn);
+
+    /** Issue, add, transfer, destory, change, put candy and get candy carry an asset id */
+    bool IsAssetCmd() const { return header.nAppCmd >= ISSUE_ASSET_CMD && header.nAppCmd <= GET_CANDY_CMD; }
+
+    const CAppData& GetAppData() const { return GetBody<CAppData>(); }
+    const CAuthData& GetAuthData() const { return GetBody<CAuthData>(); }
+    const CExtendData& GetExtendData() const { return GetBody<CExtendData>(); }
+    const CAssetData& GetAssetData() const { return GetBody<CAssetData>(); }
+    const CCommonData& GetCommonData() const { return GetBody<CCommonData>(); }
+    const CPutCandyData& GetPutCandyData() const { return GetBody<CPutCandyData>(); }
+    const CGetCandyData& GetGetCandyData() const { return GetBody<CGetCandyData>(); }
+    const CTransferSafeData& GetTransferSafeData() const { return GetBody<CTransferSafeData>(); }
+
+private:
+    typedef boost::variant<boost::blank, CAppData, CAuthData, CExtendData, CAssetData, CCommonData,
+                           CPutCandyData, CGetCandyData, CTransferSafeData> body_t;
+    body_t body;
+
+    template<typename T>
+    const T& GetBody() const
+    {
+        static const T empty;
+        const T* pBody = boost::get<T>(&body);
+        return pBody ? *pBody : empty;
+    }
+};
+
+typedef boost::shared_ptr<const CAppPayload> CAppPayloadRef;
+
+/** Number of decoded payloads kept by GetAppPayload */
+static const size_t MAX_APP_PAYLOAD_CACHE_SIZE = 100000;
+
+/**
+ * Get the decoded payload of vReserve, or NULL if vReserve carries no app data.
+ * Payloads are cached by the hash of the reserve, so the wallet, mempool and
+ * block paths decode every distinct reserve only once.
+ */
+CAppPayloadRef GetAppPayload(const CTxOutReserve& vReserve);
+
 std::string TrimString(const std::string& strValue);
 std::string ToLower(const std::string& strValue);
 bool IsKeyWord(const std::string& strValue);
@@ -595,7 +654,7 @@ std::vector<unsigned char> FillPutCandyData(const CAppHeader& header, const CPut
 std::vector<unsigned char> FillGetCandyData(const CAppHeader& header, const CGetCandyData& candyData);
 std::vector<unsigned char> FillTransferSafeData(const CAppHeader& header, const CTransferSafeData& safeData);
 
-bool ParseReserve(const std::vector<unsigned char>& vReserve, CAppHeader& header, std::vector<unsigned char>& vData);
+bool ParseReserve(const CTxOutReserve& vReserve, CAppHeader& header, std::vector<unsigned char>& vData);
 bool ParseRegisterData(const std::vector<unsigned char>& vAppData, CAppData& appData, std::string* pAdminAddress = NULL);
 bool ParseAuthData(const std::vector<unsigned char>& vAuthData, CAuthData& authData, std::string* pAdminAddress = NULL);
 bool ParseExtendData(const std::vector<unsigned char>& vExtendData, CExtendData& extendData);
@@ -13,6 +13,7 @@
 #include "wallet/wallet.h"
 #include "main.h"
 #include "masternode-sync.h"
+#include <boost/bind.hpp>
 #include <boost/regex.hpp>
 
 
@@ -505,226 +506,157 @@ UniValue getextenddata(const UniValue& params, bool fHelp)
     return ret;
 }
 
+static bool IsAppCmdTx(const uint256& appId, const uint32_t& nAppCmd, const uint256& txid)
+{
+    CTransaction tx;
+    uint256 hashBlock;
+    if (!GetTransaction(txid, tx, Params().GetConsensus(), hashBlock, true))
+        return false;
+
+    BOOST_FOREACH(const CTxOut& txout, tx.vout)
+    {
+        if (!txout.IsApp())
+            continue;
+
+        CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+        if (payload && payload->header.nAppCmd == nAppCmd && payload->header.appId == appId)
+            return true;
+    }
+
+    return false;
+}
+
+static bool IsNoTx(const uint256& txid)
+{
+    return false;
+}
+
+/** Restrict page to the transactions of appOperType and setType, as given to the app txid rpcs */
+static void SetAppTxFilter(const uint256& appId, const int& appOperType, const int& setType, CTxIdPage& page)
+{
+    uint32_t nAppCmd = 0;
+    if (appOperType == 2)
+        nAppCmd = REGISTER_APP_CMD;
+    else if (appOperType == 3 && setType == 1)
+        nAppCmd = ADD_AUTH_CMD;
+    else if (appOperType == 3 && setType == 2)
+        nAppCmd = DELETE_AUTH_CMD;
+    else if (appOperType == 4)
+        nAppCmd = CREATE_EXTEND_TX_CMD;
+    else if (appOperType == 3)
+    {
+        page.fnFilter = IsNoTx;
+        return;
+    }
+    else
+        return;
+
+    page.fnFilter = boost::bind(&IsAppCmdTx, appId, nAppCmd, _1);
+}
+
+/** Read appOperType and setType from params[nIndex] and params[nIndex + 1] */
+static void ParseAppOperType(const UniValue& params, const unsigned int& nIndex, int& appOperType, int& setType)
+{
+    appOperType = -1;
+    setType = -1;
+
+    if (params.size() > nIndex)
+    {
+        appOperType = params[nIndex].get_int();
+        if (appOperType < 1 ||appOperType > 4)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid type of app transaction");
+    }
+
+    if (params.size() > nIndex + 1)
+    {
+        setType = params[nIndex + 1].get_int();
+        if (appOperType != 3)
+        {
+            if (setType != 0)
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid type of app transaction");
+            setType = -1;
+        }
+        else if(setType < MIN_SETTYPE_VALUE || setType > sporkManager.GetSporkValue(SPORK_102_SET_TYPE_MAX_VALUE))
+            throw JSONRPCError(INVALID_SETTYPE, "Invalid set auth type");
+    }
+}
+
 UniValue getapptxids(const UniValue& params, bool fHelp)
 {
-    if (fHelp || params.size() > 3 || params.size() < 1)
+    if (fHelp || params.size() > 5 || params.size() < 1)
         throw runtime_error(
-            "getapptxids \"appId\"\n"
+            "getapptxids \"appId\" ( appOperType setType count \"cursor\" )\n"
             "\nReturns list of transactions by specified app id.\n"
             "\nArguments:\n"
             "1. \"appId\"           (string, required) The app id for transaction lookup\n"
             "2. \"appOperType\"     (numeric, optional) The app operator type, 1=all, 2=register, 3=setauth, 4=createextendatatx \n"
-            "3. \"setType\"         (numeric, optional) The set auth type, it is valid when appOperType is 3\n"
+            "3. \"setType\"         (numeric, optional) The set auth type, it is valid when appOperType is 3, otherwise pass 0\n"
+            "4. count             (numeric, optional, default=0) The maximum number of transactions to return, 0 for all\n"
+            "5. \"cursor\"          (string, optional) The cursor returned by the previous call, to continue after it\n"
             "\nResult:\n"
             "{\n"
             "    \"txList\":\n"
             "    [\n"
             "        \"txId\"\n"
             "        ,...\n"
-            "    ]\n"
+            "    ],\n"
+            "    \"cursor\": \"xxx\"      (string, optional) Present when more transactions follow, pass it to the next call\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getapptxids", "\"d12271779b72ae64d338c0a9efb176f9eb7352af2ce0ac2c76ee8cd240d2596a\"")
             + HelpExampleRpc("getapptxids", "\"d12271779b72ae64d338c0a9efb176f9eb7352af2ce0ac2c76ee8cd240d2596a\"")
         );
 
-    LOCK(cs_main);
-
     uint256 appId = uint256S(TrimString(params[0].get_str()));
 
     int appOperType = -1;
     int setType = -1;
+    ParseAppOperType(params, 1, appOperType, setType);
 
-    if (params.size() == 2)
-    {
-        appOperType = params[1].get_int();
-        if (appOperType < 1 ||appOperType > 4)
-            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid type of app transaction");
-    }
-    else if (params.size() == 3)
-    {
-        appOperType = params[1].get_int();
-        if (appOperType != 3)
-            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid type of app transaction");
-
-        setType = params[2].get_int();
-        if(setType < MIN_SETTYPE_VALUE || setType > sporkManager.GetSporkValue(SPORK_102_SET_TYPE_MAX_VALUE))
-            throw JSONRPCError(INVALID_SETTYPE, "Invalid set auth type");
-    }
-
-    vector<COutPoint> vOut;
-    if (!GetTxInfoByAppId(appId, vOut))
-        throw JSONRPCError(GET_TXID_FAILED, "No transaction available about app");
+    CTxIdPage page;
+    ParseTxIdPage(params, 3, page);
+    SetAppTxFilter(appId, appOperType, setType, page);
 
     std::vector<uint256> vTx;
-    BOOST_FOREACH(const COutPoint& out, vOut)
-    {
-        if (find(vTx.begin(), vTx.end(), out.hash) == vTx.end())
-            vTx.push_back(out.hash);
-    }
+    CTxIdCursor cursorNext;
+    if (GetTxIdsByAppId(appId, "", page))
+        page.Get(vTx, cursorNext);
+    if (page.IsEmpty())
+        throw JSONRPCError(GET_TXID_FAILED, "No transaction available about app");
 
     UniValue ret(UniValue::VOBJ);
-    UniValue transactionList(UniValue::VARR);
-
-    if (params.size() == 1 || appOperType == 1)
-    {
-        for(unsigned int i = 0; i < vTx.size(); i++)
-            transactionList.push_back(vTx[i].GetHex());
-        ret.push_back(Pair("txList", transactionList));
-    }
-    else if (appOperType == 2)
-    {
-        std::vector<uint256>::iterator it = vTx.begin();
-        for (; it != vTx.end(); it++)
-        {
-            CTransaction tx;
-            uint256 hashBlock;
-            if (!GetTransaction(*it, tx, Params().GetConsensus(), hashBlock, true))
-                continue;
-
-            BOOST_FOREACH(const CTxOut& txout, tx.vout)
-            {
-                if (!txout.IsApp())
-                    continue;
-
-                CAppHeader header;
-                vector<unsigned char> vData;
-                if (!ParseReserve(txout.vReserve, header, vData))
-                    continue;
-
-                if (header.nAppCmd == REGISTER_APP_CMD && header.appId == appId)
-                {
-                    transactionList.push_back((*it).GetHex());
-                    break;
-                }
-            }
-        }
-
-        ret.push_back(Pair("txList", transactionList));
-    }
-    else if (appOperType == 3)
-    {
-        if (setType == 1)
-        {
-            std::vector<uint256>::iterator it = vTx.begin();
-            for (; it != vTx.end(); it++)
-            {
-                CTransaction tx;
-                uint256 hashBlock;
-                if (!GetTransaction(*it, tx, Params().GetConsensus(), hashBlock, true))
-                    continue;
-
-                BOOST_FOREACH(const CTxOut& txout, tx.vout)
-                {
-                    if (!txout.IsApp())
-                        continue;
-
-                    CAppHeader header;
-                    vector<unsigned char> vData;
-                    if (!ParseReserve(txout.vReserve, header, vData))
-                        continue;
-
-                    if (header.nAppCmd == ADD_AUTH_CMD && header.appId == appId)
-                    {
-                        transactionList.push_back((*it).GetHex());
-                        break;
-                    }
-                }
-            }
-
-            ret.push_back(Pair("txList", transactionList));
-        }
-        else if (setType == 2)
-        {
-            std::vector<uint256>::iterator it = vTx.begin();
-            for (; it != vTx.end(); it++)
-            {
-                CTransaction tx;
-                uint256 hashBlock;
-                if (!GetTransaction(*it, tx, Params().GetConsensus(), hashBlock, true))
-                    continue;
-
-                BOOST_FOREACH(const CTxOut& txout, tx.vout)
-                {
-                    if (!txout.IsApp())
-                        continue;
-
-                    CAppHeader header;
-                    vector<unsigned char> vData;
-                    if(!ParseReserve(txout.vReserve, header, vData))
-                        continue;
-
-                    if (header.nAppCmd == DELETE_AUTH_CMD && header.appId == appId)
-                    {
-                        transactionList.push_back((*it).GetHex());
-                        break;
-                    }
-                }
-            }
-
-            ret.push_back(Pair("txList", transactionList));
-        }
-    }
-    else if (appOperType == 4)
-    {
-        std::vector<uint256>::iterator it = vTx.begin();
-        for (; it != vTx.end(); it++)
-        {
-            CTransaction tx;
-            uint256 hashBlock;
-            if (!GetTransaction(*it, tx, Params().GetConsensus(), hashBlock, true))
-                continue;
-
-            BOOST_FOREACH(const CTxOut& txout, tx.vout)
-            {
-                if (!txout.IsApp())
-                    continue;
-
-                CAppHeader header;
-                vector<unsigned char> vData;
-                if(!ParseReserve(txout.vReserve, header, vData))
-                    continue;
-
-                if (header.nAppCmd == CREATE_EXTEND_TX_CMD && header.appId == appId)
-                {
-                    transactionList.push_back((*it).GetHex());
-                    break;
-                }
-            }
-        }
-
-        ret.push_back(Pair("txList", transactionList));
-    }
+    PushTxIdPage(vTx, cursorNext, ret);
 
     return ret;
 }
 
 UniValue getaddressapptxids(const UniValue& params, bool fHelp)
 {
-    if (fHelp || params.size() > 4 || params.size() < 2)
+    if (fHelp || params.size() > 6 || params.size() < 2)
         throw runtime_error(
-            "getaddressapptxids \"safeAddress\" \"appId\"\n"
+            "getaddressapptxids \"safeAddress\" \"appId\" ( appOperType setType count \"cursor\" )\n"
             "\nReturns list of transactions by specified address and app id.\n"
             "\nArguments:\n"
             "1. \"safeAddress\"     (string, required) The Safe address for transaction lookup\n"
             "2. \"appId\"           (string, required) The app id for transaction lookup\n"
             "3. \"appOperType\"     (numeric, optional) The app operator type, 1=all, 2=register, 3=setauth, 4=createextendatatx \n"
-            "4. \"setType\"         (numeric, optional) The set auth type, it is valid when appOperType is 3\n"
+            "4. \"setType\"         (numeric, optional) The set auth type, it is valid when appOperType is 3, otherwise pass 0\n"
+            "5. count             (numeric, optional, default=0) The maximum number of transactions to return, 0 for all\n"
+            "6. \"cursor\"          (string, optional) The cursor returned by the previous call, to continue after it\n"
             "\nResult:\n"
             "{\n"
             "    \"txList\":\n"
             "    [\n"
             "        \"txId\"\n"
             "        ,...\n"
-            "    ]\n"
+            "    ],\n"
+            "    \"cursor\": \"xxx\"      (string, optional) Present when more transactions follow, pass it to the next call\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddressapptxids", "\"Xg1wCDXKuv4rEfsR9Ldv2qmUHSS9Ds1VCL\" \"d12271779b72ae64d338c0a9efb176f9eb7352af2ce0ac2c76ee8cd240d2596a\"")
             + HelpExampleRpc("getaddressapptxids", "\"Xg1wCDXKuv4rEfsR9Ldv2qmUHSS9Ds1VCL\", \"d12271779b72ae64d338c0a9efb176f9eb7352af2ce0ac2c76ee8cd240d2596a\"")
         );
 
-    LOCK(cs_main);
-
     string strAddress = TrimString(params[0].get_str());
     CBitcoinAddress address(strAddress);
     if (!address.IsValid())
@@ -733,167 +665,21 @@ UniValue getaddressapptxids(const UniValue& params, bool fHelp)
 
     int appOperType = -1;
     int setType = -1;
+    ParseAppOperType(params, 2, appOperType, setType);
 
-    if (params.size() == 3)
-    {
-        appOperType = params[2].get_int();
-        if (appOperType < 1 ||appOperType > 4)
-            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid type of app transaction");
-    }
-    else if (params.size() == 4)
-    {
-        appOperType = params[2].get_int();
-        if (appOperType != 3)
-            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid type of app transaction");
-
-        setType = params[3].get_int();
-        if(setType < MIN_SETTYPE_VALUE || setType > sporkManager.GetSporkValue(SPORK_102_SET_TYPE_MAX_VALUE))
-            throw JSONRPCError(INVALID_SETTYPE, "Invalid set auth type");
-    }
-
-    vector<COutPoint> vOut;
-    if(!GetTxInfoByAppIdAddress(appId, strAddress, vOut))
-        throw JSONRPCError(GET_TXID_FAILED, "No transaction available about app with specified address");
+    CTxIdPage page;
+    ParseTxIdPage(params, 4, page);
+    SetAppTxFilter(appId, appOperType, setType, page);
 
     std::vector<uint256> vTx;
-    BOOST_FOREACH(const COutPoint& out, vOut)
-    {
-        if(find(vTx.begin(), vTx.end(), out.hash) == vTx.end())
-            vTx.push_back(out.hash);
-    }
+    CTxIdCursor cursorNext;
+    if (GetTxIdsByAppId(appId, strAddress, page))
+        page.Get(vTx, cursorNext);
+    if (page.IsEmpty())
+        throw JSONRPCError(GET_TXID_FAILED, "No transaction available about app with specified address");
 
     UniValue ret(UniValue::VOBJ);
-    UniValue transactionList(UniValue::VARR);
-
-    if (params.size() == 2 || appOperType == 1)
-    {
-        for(unsigned int i = 0; i < vTx.size(); i++)
-            transactionList.push_back(vTx[i].GetHex());
-        ret.push_back(Pair("txList", transactionList));
-    }
-    else if (appOperType == 2)
-    {
-        std::vector<uint256>::iterator it = vTx.begin();
-        for (; it != vTx.end(); it++)
-        {
-            CTransaction tx;
-            uint256 hashBlock;
-            if (!GetTransaction(*it, tx, Params().GetConsensus(), hashBlock, true))
-                continue;
-
-            BOOST_FOREACH(const CTxOut& txout, tx.vout)
-            {
-                if (!txout.IsApp())
-                    continue;
-
-                CAppHeader header;
-                vector<unsigned char> vData;
-                if (!ParseReserve(txout.vReserve, header, vData))
-                    continue;
-
-                if (header.nAppCmd == REGISTER_APP_CMD && header.appId == appId)
-                {
-                    transactionList.push_back((*it).GetHex());
-                    break;
-                }
-            }
-        }
-
-        ret.push_back(Pair("txList", transactionList));
-    }
-    else if (appOperType == 3)
-    {
-        if (setType == 1)
-        {
-            std::vector<uint256>::iterator it = vTx.begin();
-            for (; it != vTx.end(); it++)
-            {
-                CTransaction tx;
-                uint256 hashBlock;
-                if (!GetTransaction(*it, tx, Params().GetConsensus(), hashBlock, true))
-                    continue;
-
-                BOOST_FOREACH(const CTxOut& txout, tx.vout)
-                {
-                    if (!txout.IsApp())
-                        continue;
-
-                    CAppHeader header;
-                    vector<unsigned char> vData;
-                    if (!ParseReserve(txout.vReserve, header, vData))
-                        continue;
-
-                    if (header.nAppCmd == ADD_AUTH_CMD && header.appId == appId)
-                    {
-                        transactionList.push_back((*it).GetHex());
-                        break;
-                    }
-                }
-            }
-
-            ret.push_back(Pair("txList", transactionList));
-        }
-        else if (setType == 2)
-        {
-            std::vector<uint256>::iterator it = vTx.begin();
-            for (; it != vTx.end(); it++)
-            {
-                CTransaction tx;
-                uint256 hashBlock;
-                if (!GetTransaction(*it, tx, Params().GetConsensus(), hashBlock, true))
-                    continue;
-
-                BOOST_FOREACH(const CTxOut& txout, tx.vout)
-                {
-                    if (!txout.IsApp())
-                        continue;
-
-                    CAppHeader header;
-                    vector<unsigned char> vData;
-                    if(!ParseReserve(txout.vReserve, header, vData))
-                        continue;
-
-                    if (header.nAppCmd == DELETE_AUTH_CMD && header.appId == appId)
-                    {
-                        transactionList.push_back((*it).GetHex());
-                        break;
-                    }
-                }
-            }
-
-            ret.push_back(Pair("txList", transactionList));
-        }
-    }
-    else if (appOperType == 4)
-    {
-        std::vector<uint256>::iterator it = vTx.begin();
-        for (; it != vTx.end(); it++)
-        {
-            CTransaction tx;
-            uint256 hashBlock;
-            if (!GetTransaction(*it, tx, Params().GetConsensus(), hashBlock, true))
-                continue;
-
-            BOOST_FOREACH(const CTxOut& txout, tx.vout)
-            {
-                if (!txout.IsApp())
-                    continue;
-
-                CAppHeader header;
-                vector<unsigned char> vData;
-                if(!ParseReserve(txout.vReserve, header, vData))
-                    continue;
-
-                if (header.nAppCmd == CREATE_EXTEND_TX_CMD && header.appId == appId)
-                {
-                    transactionList.push_back((*it).GetHex());
-                    break;
-                }
-            }
-        }
-
-        ret.push_back(Pair("txList", transactionList));
-    }
+    PushTxIdPage(vTx, cursorNext, ret);
 
     return ret;
 }
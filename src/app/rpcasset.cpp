@@ -630,9 +630,10 @@ UniValue getcandy(const UniValue& params, bool fHelp)
     map<CKeyID, int64_t> mapKeyBirth;
     pwalletMain->GetKeyBirthTimes(mapKeyBirth);
 
-    vector<CKeyID> vKeyID;
+    vector<string> vAddress;
     for(map<CKeyID, int64_t>::const_iterator it = mapKeyBirth.begin(); it != mapKeyBirth.end(); it++)
-        vKeyID.push_back(it->first);
+        vAddress.push_back(CBitcoinAddress(it->first).ToString());
+    sort(vAddress.begin(), vAddress.end());
 
     int nCurrentHeight = g_nChainHeight;
 
@@ -716,10 +717,14 @@ UniValue getcandy(const UniValue& params, bool fHelp)
         CAmount nGetCandyAmount =  dbamount + memamount;
         CAmount nNowGetCandyTotalAmount = 0;
 
+        vector<CAmount> vSafe;
+        if(!GetAddressAmountsByHeight(nTxHeight, vAddress, vSafe))
+            continue;
+
         vector<CRecipient> vecSend;
-        for(unsigned int i = 0; i < vKeyID.size(); i++)
+        for(unsigned int i = 0; i < vAddress.size(); i++)
         {
-            string strAddress = CBitcoinAddress(vKeyID[i]).ToString();
+            const string& strAddress = vAddress[i];
 
             CAmount nTempAmount = 0;
             if(GetGetCandyAmount(assetId, out, strAddress, nTempAmount)) // got candy
@@ -727,10 +732,7 @@ UniValue getcandy(const UniValue& params, bool fHelp)
 
             CBitcoinAddress recvAddress(strAddress);
 
-            CAmount nSafe = 0;
-            if(!GetAddressAmountByHeight(nTxHeight, strAddress, nSafe))
-                continue;
-
+            const CAmount& nSafe = vSafe[i];
             if(nSafe < 1 * COIN || nSafe > nTotalSafe)
                 continue;
 
@@ -835,6 +837,7 @@ UniValue getcandy(const UniValue& params, bool fHelp)
         if(!found){
             LogPrintf("erase candy not found,height:%d,assetId:%s\n", nTxHeight,assetId.ToString());
         }
+        EraseCandyEligibility(assetIdCandyInfo.out);
     }
 
     return ret;
@@ -1112,106 +1115,143 @@ UniValue getlocalassetinfo(const UniValue& params, bool fHelp)
     return ret;
 }
 
+void ParseTxIdPage(const UniValue& params, const unsigned int& nIndex, CTxIdPage& page)
+{
+    unsigned int nCount = 0;
+    if(params.size() > nIndex)
+    {
+        int nValue = params[nIndex].get_int();
+        if(nValue < 0)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid count");
+        nCount = nValue;
+    }
+
+    CTxIdCursor cursor;
+    if(params.size() > nIndex + 1 && !CTxIdCursor::Parse(TrimString(params[nIndex + 1].get_str()), cursor))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+
+    page = CTxIdPage(cursor, nCount);
+}
+
+void PushTxIdPage(const std::vector<uint256>& vTxId, const CTxIdCursor& cursorNext, UniValue& ret)
+{
+    UniValue transactionList(UniValue::VARR);
+    for(unsigned int i = 0; i < vTxId.size(); i++)
+        transactionList.push_back(vTxId[i].GetHex());
+    ret.push_back(Pair("txList", transactionList));
+    if(!cursorNext.IsNull())
+        ret.push_back(Pair("cursor", cursorNext.ToString()));
+}
+
 UniValue getassetidtxids(const UniValue& params, bool fHelp)
 {
-    if (fHelp || params.size() != 2)
+    if (fHelp || params.size() < 2 || params.size() > 4)
         throw runtime_error(
-            "getassetidtxids \"assetId\" txClass\n"
+            "getassetidtxids \"assetId\" txClass ( count \"cursor\" )\n"
             "\nReturns list of transactions by specified asset id and transaction type.\n"
             "\nArguments:\n"
             "1. \"assetId\"             (string, required) The asset id for transaction lookup\n"
             "2. txClass                 (numeric, required) The transaction type (1=all, 2=normal, 3=locked)\n"
+            "3. count                   (numeric, optional, default=0) The maximum number of transactions to return, 0 for all\n"
+            "4. \"cursor\"              (string, optional) The cursor returned by the previous call, to continue after it\n"
             "\nResult:\n"
             "{\n"
             "    \"txList\":\n"
             "    [\n"
             "        \"txId\"\n"
             "        ,...\n"
-            "    ]\n"
+            "    ],\n"
+            "    \"cursor\": \"xxx\"      (string, optional) Present when more transactions follow, pass it to the next call\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getassetidtxids", "\"723468197263af02cdf836aa12033864df0de857780dcb7982262efface6afdd\" 1")
             + HelpExampleRpc("getassetidtxids", "\"723468197263af02cdf836aa12033864df0de857780dcb7982262efface6afdd\", 3")
         );
 
-    LOCK(cs_main);
-
     uint256 assetId = uint256S(TrimString(params[0].get_str()));
     uint8_t nTxClass = (uint8_t)params[1].get_int();
     if(nTxClass < 1 || nTxClass > sporkManager.GetSporkValue(SPORK_105_TX_CLASS_MAX_VALUE))
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid type of transaction");
 
-    vector<COutPoint> vOut;
-    if(!GetTxInfoByAssetIdTxClass(assetId, nTxClass, vOut))
-        throw JSONRPCError(GET_TXID_FAILED, "No transaction available about asset");
+    CTxIdPage page;
+    ParseTxIdPage(params, 2, page);
 
     std::vector<uint256> vTx;
-    BOOST_FOREACH(const COutPoint& out, vOut)
-    {
-        if(find(vTx.begin(), vTx.end(), out.hash) == vTx.end())
-            vTx.push_back(out.hash);
-    }
+    CTxIdCursor cursorNext;
+    if(GetTxIdsByAssetIdTxClass(assetId, "", nTxClass, page))
+        page.Get(vTx, cursorNext);
+    if(vTx.empty() && page.IsFirst())
+        throw JSONRPCError(GET_TXID_FAILED, "No transaction available about asset");
 
     UniValue ret(UniValue::VOBJ);
-    UniValue transactionList(UniValue::VARR);
-    for(unsigned int i = 0; i < vTx.size(); i++)
-        transactionList.push_back(vTx[i].GetHex());
-    ret.push_back(Pair("txList", transactionList));
+    PushTxIdPage(vTx, cursorNext, ret);
 
     return ret;
 }
 
 UniValue getaddrassettxids(const UniValue& params, bool fHelp)
 {
-    if (fHelp || params.size() != 3)
+    if (fHelp || params.size() < 3 || params.size() > 5)
         throw runtime_error(
-            "getaddrassettxids \"safeAddress\" \"assetId\" txClass\n"
+            "getaddrassettxids \"safeAddress\" \"assetId\" txClass ( count \"cursor\" )\n"
             "\nReturns list of transactions by specified address, asset id and transaction type.\n"
             "\nArguments:\n"
             "1. \"safeAddress\"         (string, required) The Safe address for transaction lookup\n"
             "2. \"assetId\"             (string, required) The asset id for transaction lookup\n"
             "3. txClass                 (numeric, required) The transaction type (1=all, 2=normal, 3=locked)\n"
+            "4. count                   (numeric, optional, default=0) The maximum number of transactions to return, 0 for all\n"
+            "5. \"cursor\"              (string, optional) The cursor returned by the previous call, to continue after it\n"
             "\nResult:\n"
             "{\n"
             "    \"txList\":\n"
             "    [\n"
             "        \"txId\"\n"
             "        ,...\n"
-            "    ]\n"
+            "    ],\n"
+            "    \"cursor\": \"xxx\"      (string, optional) Present when more transactions follow, pass it to the next call\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddrassettxids", "\"Xg1wCDXKuv4rEfsR9Ldv2qmUHSS9Ds1VCL\" \"723468197263af02cdf836aa12033864df0de857780dcb7982262efface6afdd\" 1")
             + HelpExampleRpc("getaddrassettxids", "\"Xg1wCDXKuv4rEfsR9Ldv2qmUHSS9Ds1VCL\", \"723468197263af02cdf836aa12033864df0de857780dcb7982262efface6afdd\", 3")
         );
 
-    LOCK(cs_main);
-
     string strAddress = TrimString(params[0].get_str());
+    if(strAddress.empty())
+        throw JSONRPCError(GET_TXID_FAILED, "No transaction available about asset with specified address");
     uint256 assetId = uint256S(TrimString(params[1].get_str()));
     uint8_t nTxClass = (uint8_t)params[2].get_int();
     if(nTxClass < 1 || nTxClass > sporkManager.GetSporkValue(SPORK_105_TX_CLASS_MAX_VALUE))
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid type of transaction");
 
-    vector<COutPoint> vOut;
-    if(!GetTxInfoByAssetIdAddressTxClass(assetId, strAddress, nTxClass, vOut))
+    CTxIdPage page;
+    ParseTxIdPage(params, 3, page);
+
+    std::vector<uint256> vTx;
+    CTxIdCursor cursorNext;
+    if(GetTxIdsByAssetIdTxClass(assetId, strAddress, nTxClass, page))
+        page.Get(vTx, cursorNext);
+    if(vTx.empty() && page.IsFirst())
         throw JSONRPCError(GET_TXID_FAILED, "No transaction available about asset with specified address");
 
     UniValue ret(UniValue::VOBJ);
-    UniValue transactionList(UniValue::VARR);
-
-    vector<uint256> vHash;
-    BOOST_FOREACH(const COutPoint& out, vOut)
-    {
-        if(find(vHash.begin(), vHash.end(), out.hash) == vHash.end())
-            vHash.push_back(out.hash);
-    }
-    for(unsigned int i = 0; i < vHash.size(); i++)
-        transactionList.push_back(vHash[i].GetHex());
-    ret.push_back(Pair("txList", transactionList));
+    PushTxIdPage(vTx, cursorNext, ret);
 
     return ret;
 }
 
+static bool IsAddressAssetTxOut(const CTxOut& txout, const std::string& strAddress, const uint256& assetId)
+{
+    if (!txout.IsAsset())
+        return false;
+
+    CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+    if (!payload || payload->assetId != assetId)
+        return false;
+
+    std::string strTxOutAddress;
+    return GetTxOutAddress(txout, &strTxOutAddress) && strTxOutAddress == strAddress;
+}
+
 UniValue getaddrassetbalance(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() != 2)
@@ -1233,8 +1273,6 @@ UniValue getaddrassetbalance(const UniValue& params, bool fHelp)
             + HelpExampleRpc("getaddrassetbalance", "\"Xg1wCDXKuv4rEfsR9Ldv2qmUHSS9Ds1VCL\", \"723468197263af02cdf836aa12033864df0de857780dcb7982262efface6afdd\"")
         );
 
-    LOCK(cs_main);
-
     string strAddress = TrimString(params[0].get_str());
     CBitcoinAddress address(strAddress);
     if (!address.IsValid())
@@ -1245,15 +1283,18 @@ UniValue getaddrassetbalance(const UniValue& params, bool fHelp)
     if (assetId.IsNull() || !GetAssetInfoByAssetId(assetId, assetInfo))
         throw JSONRPCError(NONEXISTENT_ASSETID, "Non-existent asset id");
 
+    CAssetAmount TotalSendAmount;
+    CAssetAmount TotalReceiveAmount;
+    CAssetAmount TotalLockingAmount;
+
+    // the balance index covers the confirmed transactions, only the mempool is scanned
     vector<COutPoint> vOut;
-    if (!GetTxInfoByAssetIdAddressTxClass(assetId, strAddress, 1, vOut))
+    bool fIndexed = GetAddressAssetBalance(strAddress, assetId, TotalReceiveAmount, TotalSendAmount, TotalLockingAmount);
+    if (fIndexed)
+        mempool.get_AssetTx_Index(assetId, strAddress, 1, vOut);
+    else if (!GetTxInfoByAssetIdAddressTxClass(assetId, strAddress, 1, vOut))
         throw JSONRPCError(GET_TXID_FAILED, "No transaction available about asset with specified address");
 
-    std::string TotalSendAmount = "";
-    std::string TotalReceiveAmount = "";
-    std::string TotalLockingAmount = "";
-    std::string Totalbalance = "";
-
     vector<uint256> vHash;
     BOOST_FOREACH(const COutPoint& out, vOut)
     {
@@ -1261,6 +1302,8 @@ UniValue getaddrassetbalance(const UniValue& params, bool fHelp)
             vHash.push_back(out.hash);
     }
 
+    LOCK(cs_main);
+
     vector<uint256>::iterator it = vHash.begin();
     for (; it != vHash.end(); it++)
     {
@@ -1270,26 +1313,14 @@ UniValue getaddrassetbalance(const UniValue& params, bool fHelp)
         {
             BOOST_FOREACH(const CTxOut& txout, tx.vout)
             {
-                if (!txout.IsAsset())
-                    continue;
-
-                CTxDestination tempdest;
-                if (!ExtractDestination(txout.scriptPubKey, tempdest))
-                    continue;
-
-                if (!CBitcoinAddress(tempdest).IsValid())
+                if (!IsAddressAssetTxOut(txout, strAddress, assetId))
                     continue;
 
-                std::string strtempAddress = CBitcoinAddress(tempdest).ToString();
-                if (strtempAddress == strAddress)
-                {
-                    char ctempdata[64] = {0};
-                    sprintf(ctempdata, "%" PRId64, txout.nValue);
-                    TotalReceiveAmount = plusstring(TotalReceiveAmount, ctempdata);
+                if (!TotalReceiveAmount.Add(txout.nValue))
+                    throw JSONRPCError(RPC_INTERNAL_ERROR, "Asset amount overflow");
 
-                    if (txout.nUnlockedHeight > chainActive.Height())
-                        TotalLockingAmount = plusstring(TotalLockingAmount, ctempdata);
-                }
+                if (txout.nUnlockedHeight > chainActive.Height() && !TotalLockingAmount.Add(txout.nValue))
+                    throw JSONRPCError(RPC_INTERNAL_ERROR, "Asset amount overflow");
             }
 
             if (!tx.IsCoinBase())
@@ -1302,52 +1333,22 @@ UniValue getaddrassetbalance(const UniValue& params, bool fHelp)
                         continue;
 
                     const CTxOut& txout = temptx.vout[txin.prevout.n];
-                    if (!txout.IsAsset())
-                        continue;
-
-                    CTxDestination tempdest;
-                    if (!ExtractDestination(txout.scriptPubKey, tempdest))
-                    {
-                        continue;
-                    }
-
-                    if (!CBitcoinAddress(tempdest).IsValid())
-                        continue;
-
-                    std::string strtempAddress = CBitcoinAddress(tempdest).ToString();
-                    if (strtempAddress == strAddress)
-                    {
-                        char ctempdata[64] = {0};
-                        sprintf(ctempdata, "%" PRId64, txout.nValue);
-                        TotalSendAmount = plusstring(TotalSendAmount, ctempdata);
-                    }
+                    if (IsAddressAssetTxOut(txout, strAddress, assetId) && !TotalSendAmount.Add(txout.nValue))
+                        throw JSONRPCError(RPC_INTERNAL_ERROR, "Asset amount overflow");
                 }
             }
         }
     }
 
-    Totalbalance = minusstring(TotalReceiveAmount, TotalSendAmount);
+    CAssetAmount Totalbalance = TotalReceiveAmount;
+    if (!Totalbalance.Sub(TotalSendAmount))
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Asset amount overflow");
 
     UniValue ret(UniValue::VOBJ);
-    if (TotalReceiveAmount.length() <= assetInfo.assetData.nDecimals)
-        ret.push_back(Pair("ReceiveAmount",  StrValueFromAmount(atol(TotalReceiveAmount.c_str()), assetInfo.assetData.nDecimals)));
-    else
-        ret.push_back(Pair("ReceiveAmount",  numtofloatstring(TotalReceiveAmount, assetInfo.assetData.nDecimals)));
-
-    if (TotalSendAmount.length() <= assetInfo.assetData.nDecimals)
-        ret.push_back(Pair("SendAmount",  StrValueFromAmount(atol(TotalSendAmount.c_str()), assetInfo.assetData.nDecimals)));
-    else
-        ret.push_back(Pair("SendAmount",  numtofloatstring(TotalSendAmount, assetInfo.assetData.nDecimals)));
-
-    if (Totalbalance.length() <= assetInfo.assetData.nDecimals)
-        ret.push_back(Pair("totalAmount",  StrValueFromAmount(atol(Totalbalance.c_str()), assetInfo.assetData.nDecimals)));
-    else
-         ret.push_back(Pair("totalAmount",  numtofloatstring(Totalbalance, assetInfo.assetData.nDecimals)));
-
-    if (TotalLockingAmount.length() <= assetInfo.assetData.nDecimals)
-        ret.push_back(Pair("lockAmount",  StrValueFromAmount(atol(TotalLockingAmount.c_str()), assetInfo.assetData.nDecimals)));
-    else
-        ret.push_back(Pair("lockAmount",  numtofloatstring(TotalLockingAmount, assetInfo.assetData.nDecimals)));
+    ret.push_back(Pair("ReceiveAmount",  StrValueFromAssetAmount(TotalReceiveAmount, assetInfo.assetData.nDecimals)));
+    ret.push_back(Pair("SendAmount",  StrValueFromAssetAmount(TotalSendAmount, assetInfo.assetData.nDecimals)));
+    ret.push_back(Pair("totalAmount",  StrValueFromAssetAmount(Totalbalance, assetInfo.assetData.nDecimals)));
+    ret.push_back(Pair("lockAmount",  StrValueFromAssetAmount(TotalLockingAmount, assetInfo.assetData.nDecimals)));
 
     return ret;
 }
@@ -2125,60 +2126,55 @@ UniValue transfermanyasset(const UniValue& params, bool fHelp)
     return ret;
 }
 
+static bool IsLocalTx(const uint256& txid)
+{
+    AssertLockHeld(pwalletMain->cs_wallet);
+    return pwalletMain->mapWallet.count(txid);
+}
+
 UniValue getassetlocaltxlist(const UniValue& params, bool fHelp)
 {
-    if (fHelp || params.size() != 2)
+    if (fHelp || params.size() < 2 || params.size() > 4)
         throw runtime_error(
-            "getassetlocaltxlist \"assetId\" txClass\n"
+            "getassetlocaltxlist \"assetId\" txClass ( count \"cursor\" )\n"
             "\nReturns list of local transactions by specified asset id and transaction type.\n"
             "\nArguments:\n"
             "1. \"assetId\"             (string, required) The asset id for transaction lookup\n"
             "2. txClass                 (numeric, required) The transaction type (1=all, 2=normal, 3=locked,4=issue,5=addissue,6=destory)\n"
+            "3. count                   (numeric, optional, default=0) The maximum number of transactions to return, 0 for all\n"
+            "4. \"cursor\"              (string, optional) The cursor returned by the previous call, to continue after it\n"
             "\nResult:\n"
             "{\n"
             "    \"txList\":\n"
             "    [\n"
             "        \"txId\"\n"
             "        ,...\n"
-            "    ]\n"
+            "    ],\n"
+            "    \"cursor\": \"xxx\"      (string, optional) Present when more transactions follow, pass it to the next call\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getassetlocaltxlist", "\"723468197263af02cdf836aa12033864df0de857780dcb7982262efface6afdd\" 1")
             + HelpExampleRpc("getassetlocaltxlist", "\"723468197263af02cdf836aa12033864df0de857780dcb7982262efface6afdd\", 3")
         );
 
-    LOCK2(cs_main, pwalletMain->cs_wallet);
+    LOCK(pwalletMain->cs_wallet);
 
     uint256 assetId = uint256S(TrimString(params[0].get_str()));
     uint8_t nTxClass = (uint8_t)params[1].get_int();
     if(nTxClass < 1 || nTxClass > sporkManager.GetSporkValue(SPORK_105_TX_CLASS_MAX_VALUE))
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid type of transaction");
 
-    vector<COutPoint> vOut;
-    if(!GetTxInfoByAssetIdTxClass(assetId, nTxClass, vOut))
-        throw JSONRPCError(GET_TXID_FAILED, "No transaction available about asset");
+    CTxIdPage page;
+    ParseTxIdPage(params, 2, page);
+    page.fnFilter = IsLocalTx;
 
     std::vector<uint256> vTx;
-    BOOST_FOREACH(const COutPoint& out, vOut)
-    {
-        if(find(vTx.begin(), vTx.end(), out.hash) == vTx.end())
-            vTx.push_back(out.hash);
-    }
-
-    std::vector<uint256> vlocalTx;
-    std::vector<uint256>::iterator it = vTx.begin();
-    for (; it != vTx.end(); it++)
-    {
-        std::map<uint256, CWalletTx>::iterator tempit = pwalletMain->mapWallet.find(*it);
-        if (tempit != pwalletMain->mapWallet.end())
-            vlocalTx.push_back(*it);
-    }
+    CTxIdCursor cursorNext;
+    if(GetTxIdsByAssetIdTxClass(assetId, "", nTxClass, page))
+        page.Get(vTx, cursorNext);
 
     UniValue ret(UniValue::VOBJ);
-    UniValue transactionList(UniValue::VARR);
-    for(unsigned int i = 0; i < vlocalTx.size(); i++)
-        transactionList.push_back(vlocalTx[i].GetHex());
-    ret.push_back(Pair("txList", transactionList));
+    PushTxIdPage(vTx, cursorNext, ret);
 
     return ret;
 }
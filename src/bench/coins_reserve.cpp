@@ -0,0 +1,84 @@
+// Copyright (c) 2018-2019 The Safe Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "coins.h"
+#include "core_memusage.h"
+#include "memusage.h"
+#include "primitives/transaction.h"
+#include "streams.h"
+
+#include <iostream>
+
+static CMutableTransaction CreatePlainTransaction(const uint32_t nLockTime)
+{
+    CMutableTransaction tx;
+    tx.nVersion = SAFE_TX_VERSION_1;
+    tx.nLockTime = nLockTime;
+    tx.vin.resize(1);
+    tx.vout.resize(10);
+    for (unsigned int i = 0; i < tx.vout.size(); i++) {
+        tx.vout[i].nValue = (i + 1) * COIN;
+        tx.vout[i].scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, i) << OP_EQUALVERIFY << OP_CHECKSIG;
+    }
+    return tx;
+}
+
+// Unserialize chainstate records of plain outputs, which carry only the
+// "safe" reserve marker, as done when loading the coins database.
+static void CoinsUnserialize(benchmark::State& state)
+{
+    CCoins coins(CreatePlainTransaction(0), 1);
+
+    CDataStream ss(SER_DISK, 0);
+    ss << coins;
+
+    while (state.KeepRunning()) {
+        for (int i = 0; i < 1000; i++) {
+            CDataStream ssRead(ss.begin(), ss.end(), SER_DISK, 0);
+            CCoins coinsRead;
+            ssRead >> coinsRead;
+        }
+    }
+}
+
+// Fill a coins cache with plain outputs, then report the -dbcache footprint and
+// the heap allocations per coin next to the figures of the former
+// std::vector<unsigned char> reserve.
+static void CoinsCacheReserveUsage(benchmark::State& state)
+{
+    std::vector<CTransaction> vTx;
+    for (int i = 0; i < 1000; i++)
+        vTx.push_back(CreatePlainTransaction(i));
+
+    CCoinsView viewDummy;
+    size_t nCacheUsage = 0;
+    while (state.KeepRunning()) {
+        CCoinsViewCache cache(&viewDummy);
+        for (unsigned int i = 0; i < vTx.size(); i++)
+            cache.ModifyNewCoins(vTx[i].GetHash())->FromTx(vTx[i], 1);
+        nCacheUsage = cache.DynamicMemoryUsage();
+    }
+
+    const CCoins coins(vTx[0], 1);
+    size_t nUsage = coins.DynamicMemoryUsage();
+    size_t nVectorUsage = memusage::MallocUsage(coins.vout.capacity() * (sizeof(CTxOut) - sizeof(CTxOutReserve) + sizeof(std::vector<unsigned char>)));
+    size_t nAllocs = 1, nVectorAllocs = 1;
+    for (unsigned int i = 0; i < coins.vout.size(); i++) {
+        const CTxOut& txout = coins.vout[i];
+        std::vector<unsigned char> vReserve(txout.vReserve.begin(), txout.vReserve.end());
+        nVectorUsage += RecursiveDynamicUsage(txout.scriptPubKey) + memusage::DynamicUsage(vReserve);
+        nAllocs += (RecursiveDynamicUsage(txout.scriptPubKey) > 0) + (RecursiveDynamicUsage(txout.vReserve) > 0);
+        nVectorAllocs += (RecursiveDynamicUsage(txout.scriptPubKey) > 0) + (memusage::DynamicUsage(vReserve) > 0);
+    }
+
+    // the cache map overhead per entry is the same for both layouts
+    size_t nEntryUsage = nCacheUsage / vTx.size() - nUsage;
+    std::cout << "# CoinsCacheReserveUsage: " << coins.vout.size() << " outputs per coin, "
+              << nEntryUsage + nUsage << " bytes and " << nAllocs << " allocations per coin, "
+              << "std::vector reserve " << nEntryUsage + nVectorUsage << " bytes and " << nVectorAllocs << " allocations per coin\n";
+}
+
+BENCHMARK(CoinsUnserialize);
+BENCHMARK(CoinsCacheReserveUsage);
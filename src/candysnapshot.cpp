@@ -0,0 +1,512 @@
+// Copyright (c) 2018-2019 The Safe Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "candysnapshot.h"
+
+#include "clientversion.h"
+#include "streams.h"
+#include "util.h"
+#include "utiltime.h"
+#include "validation.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <set>
+#include <stdexcept>
+#include <string.h>
+
+#include <boost/filesystem.hpp>
+
+CCandySnapshotStore candySnapshotStore;
+CCandyLedger candyLedger;
+
+static const size_t MERGE_BATCH_COUNT = 10000;
+
+/** Big-endian value of the first 8 address bytes, ordered like strcmp on the address */
+static uint64_t GetAddressPrefix(const char* szAddress, size_t nMaxLen)
+{
+    uint64_t nPrefix = 0;
+    bool fEnd = false;
+    for(size_t i = 0; i < 8; i++)
+    {
+        unsigned char ch = 0;
+        if(!fEnd && i < nMaxLen)
+        {
+            ch = (unsigned char)szAddress[i];
+            fEnd = (ch == 0);
+        }
+        nPrefix = (nPrefix << 8) | ch;
+    }
+    return nPrefix;
+}
+
+struct CompareAddressAmount
+{
+    bool operator()(const CAddressAmount& data, const char* szAddress) const
+    {
+        return strcmp(data.szAddress, szAddress) < 0;
+    }
+};
+
+CAddressAmountView::CAddressAmountView() : pRecords(NULL), nRecords(0)
+{
+}
+
+bool CAddressAmountView::Open(const boost::filesystem::path& path)
+{
+    pRecords = NULL;
+    nRecords = 0;
+    vFence.clear();
+
+    try {
+        if(!boost::filesystem::exists(path))
+            return true;
+
+        uintmax_t nFileLen = boost::filesystem::file_size(path);
+        if(nFileLen % sizeof(CAddressAmount) != 0)
+            return error("%s: %s has a truncated record", __func__, path.string());
+        if(nFileLen == 0)
+            return true;
+
+        boost::interprocess::file_mapping tempMapping(path.string().c_str(), boost::interprocess::read_only);
+        boost::interprocess::mapped_region tempRegion(tempMapping, boost::interprocess::read_only, 0, nFileLen);
+        mapping.swap(tempMapping);
+        region.swap(tempRegion);
+    } catch (const boost::interprocess::interprocess_exception& e) {
+        return error("%s: map %s failed: %s", __func__, path.string(), e.what());
+    } catch (const boost::filesystem::filesystem_error& e) {
+        return error("%s: stat %s failed: %s", __func__, path.string(), e.what());
+    }
+
+    region.advise(boost::interprocess::mapped_region::advice_random);
+
+    pRecords = static_cast<const CAddressAmount*>(region.get_address());
+    nRecords = region.get_size() / sizeof(CAddressAmount);
+
+    vFence.reserve(nRecords / CANDY_SNAPSHOT_FENCE_INTERVAL + 1);
+    for(size_t i = 0; i < nRecords; i += CANDY_SNAPSHOT_FENCE_INTERVAL)
+        vFence.push_back(GetAddressPrefix(pRecords[i].szAddress, sizeof(pRecords[i].szAddress)));
+
+    return true;
+}
+
+const CAddressAmount* CAddressAmountView::end() const
+{
+    return pRecords + nRecords;
+}
+
+int CAddressAmountView::Find(const std::string& strAddress, CAmount& nAmount, long* pPos) const
+{
+    const char* szAddress = strAddress.c_str();
+
+    // Narrow the search to the fence blocks which may hold the address prefix
+    const uint64_t nPrefix = GetAddressPrefix(szAddress, strAddress.size());
+    std::vector<uint64_t>::const_iterator itLow = std::lower_bound(vFence.begin(), vFence.end(), nPrefix);
+    std::vector<uint64_t>::const_iterator itHigh = std::upper_bound(itLow, vFence.end(), nPrefix);
+
+    size_t nLow = itLow == vFence.begin() ? 0 : (itLow - vFence.begin() - 1) * CANDY_SNAPSHOT_FENCE_INTERVAL;
+    size_t nHigh = std::min(nRecords, size_t(itHigh - vFence.begin()) * CANDY_SNAPSHOT_FENCE_INTERVAL);
+
+    const CAddressAmount* pFound = std::lower_bound(pRecords + nLow, pRecords + nHigh, szAddress, CompareAddressAmount());
+    long nPos = pFound - pRecords;
+    if(pPos)
+        *pPos = nPos;
+
+    if(pFound == end())
+        return 2;
+
+    if(strcmp(pFound->szAddress, szAddress) != 0)
+        return 1;
+
+    nAmount = pFound->nAmount;
+    return 0;
+}
+
+void CAddressAmountView::MergeAmounts(const std::vector<std::string>& vAddress, std::vector<CAmount>& vAmount, int nSign) const
+{
+    assert(vAddress.size() == vAmount.size());
+
+    const CAddressAmount* pCursor = begin();
+    for(size_t i = 0; i < vAddress.size() && pCursor != end(); i++)
+    {
+        const char* szAddress = vAddress[i].c_str();
+
+        // Gallop from the cursor, so dense and sparse address sets both stay cheap
+        size_t nRemain = end() - pCursor;
+        size_t nStep = 1;
+        while(nStep < nRemain && strcmp(pCursor[nStep - 1].szAddress, szAddress) < 0)
+            nStep *= 2;
+
+        pCursor = std::lower_bound(pCursor + nStep / 2, pCursor + std::min(nStep, nRemain), szAddress, CompareAddressAmount());
+        if(pCursor != end() && strcmp(pCursor->szAddress, szAddress) == 0)
+            vAmount[i] += nSign * pCursor->nAmount;
+    }
+}
+
+boost::shared_ptr<const CAddressAmountView> CCandySnapshotStore::Get(const std::string& strFile)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::map<std::string, boost::shared_ptr<const CAddressAmountView> >::iterator it = mapViews.find(strFile);
+    if(it != mapViews.end())
+        return it->second;
+
+    boost::shared_ptr<CAddressAmountView> pView(new CAddressAmountView());
+    if(!pView->Open(GetDataDir() / "height" / strFile))
+        return boost::shared_ptr<const CAddressAmountView>();
+
+    mapViews[strFile] = pView;
+    return pView;
+}
+
+void CCandySnapshotStore::Release(const std::string& strFile)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    mapViews.erase(strFile);
+}
+
+void CCandySnapshotStore::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    mapViews.clear();
+}
+
+static bool FlushAddressAmounts(FILE* pFile, std::vector<CAddressAmount>& vBatch)
+{
+    if(vBatch.empty())
+        return true;
+
+    bool fRet = fwrite(&vBatch[0], sizeof(CAddressAmount), vBatch.size(), pFile) == vBatch.size();
+    vBatch.clear();
+    return fRet;
+}
+
+bool MergeAddressAmountFile(const CAddressAmountView& src, const std::map<std::string, CAmount>& mapDelta, const boost::filesystem::path& dest)
+{
+    FILE* pFile = fopen(dest.string().c_str(), "wb");
+    if(!pFile)
+        return error("%s: open %s failed", __func__, dest.string());
+
+    std::vector<CAddressAmount> vBatch;
+    vBatch.reserve(MERGE_BATCH_COUNT);
+
+    const CAddressAmount* pCursor = src.begin();
+    std::map<std::string, CAmount>::const_iterator it = mapDelta.begin();
+    while(pCursor != src.end() || it != mapDelta.end())
+    {
+        int nCmp = 0;
+        if(pCursor == src.end())
+            nCmp = 1;
+        else if(it == mapDelta.end())
+            nCmp = -1;
+        else
+            nCmp = strcmp(pCursor->szAddress, it->first.c_str());
+
+        CAddressAmount data;
+        if(nCmp < 0)
+            data = *pCursor++;
+        else
+        {
+            if(nCmp == 0)
+                data = *pCursor++;
+            else
+                data = CAddressAmount(it->first, 0);
+            data.nAmount += it->second;
+            it++;
+        }
+
+        if(data.nAmount == 0)
+            continue;
+
+        vBatch.push_back(data);
+        if(vBatch.size() == MERGE_BATCH_COUNT && !FlushAddressAmounts(pFile, vBatch))
+        {
+            fclose(pFile);
+            return error("%s: write %s failed", __func__, dest.string());
+        }
+    }
+
+    if(!FlushAddressAmounts(pFile, vBatch))
+    {
+        fclose(pFile);
+        return error("%s: write %s failed", __func__, dest.string());
+    }
+
+    FileCommit(pFile);
+    fclose(pFile);
+    return true;
+}
+
+std::string CCandyDelta::GetFileName() const
+{
+    return strprintf("delta/%d.dat", nHeight);
+}
+
+CCandyLedger::CCandyLedger() : nLastCompactTime(0), nGeneration(0), fDeltaOpen(false)
+{
+}
+
+bool CCandyLedger::WriteManifest() const
+{
+    const boost::filesystem::path pathManifest = GetDataDir() / "height" / "manifest.dat";
+    const boost::filesystem::path pathTmp = GetDataDir() / "height" / "manifest.dat.temp";
+
+    FILE* pFile = fopen(pathTmp.string().c_str(), "wb");
+    CAutoFile fileout(pFile, SER_DISK, CLIENT_VERSION);
+    if(fileout.IsNull())
+        return error("%s: open %s failed", __func__, pathTmp.string());
+
+    try {
+        fileout << CLIENT_VERSION;
+        fileout << vPending;
+        fileout << vInstall;
+    } catch (const std::exception& e) {
+        return error("%s: serialize or I/O error - %s", __func__, e.what());
+    }
+    FileCommit(fileout.Get());
+    fileout.fclose();
+
+    if(!RenameOver(pathTmp, pathManifest))
+        return error("%s: rename %s failed", __func__, pathTmp.string());
+
+    return true;
+}
+
+bool CCandyLedger::InstallFiles()
+{
+    const boost::filesystem::path heightDir = GetDataDir() / "height";
+
+    for(std::vector<std::string>::const_iterator it = vInstall.begin(); it != vInstall.end(); it++)
+    {
+        candySnapshotStore.Release(*it);
+
+        // already renamed before an interruption
+        const boost::filesystem::path pathTmp = heightDir / (*it + ".temp");
+        if(!boost::filesystem::exists(pathTmp))
+            continue;
+
+        if(!RenameOver(pathTmp, heightDir / *it))
+            return error("%s: rename %s failed", __func__, pathTmp.string());
+    }
+
+    vInstall.clear();
+    return WriteManifest();
+}
+
+bool CCandyLedger::Load()
+{
+    vPending.clear();
+    vInstall.clear();
+    nLastCompactTime = GetTime();
+    nGeneration++;
+    candySnapshotStore.Clear();
+
+    const boost::filesystem::path heightDir = GetDataDir() / "height";
+    const boost::filesystem::path deltaDir = heightDir / "delta";
+    const boost::filesystem::path pathManifest = heightDir / "manifest.dat";
+
+    try {
+        if(!boost::filesystem::exists(deltaDir) && !TryCreateDirectory(deltaDir))
+            return error("%s: create %s failed", __func__, deltaDir.string());
+
+        if(boost::filesystem::exists(pathManifest))
+        {
+            FILE* pFile = fopen(pathManifest.string().c_str(), "rb");
+            CAutoFile filein(pFile, SER_DISK, CLIENT_VERSION);
+            if(filein.IsNull())
+                return error("%s: open %s failed", __func__, pathManifest.string());
+
+            int nVersion = 0;
+            filein >> nVersion;
+            filein >> vPending;
+            filein >> vInstall;
+        }
+
+        if(!vInstall.empty())
+        {
+            LogPrintf("%s: finish interrupted compaction of %u files\n", __func__, vInstall.size());
+            if(!InstallFiles())
+                return false;
+        }
+
+        // remove deltas which were compacted or never made it into the manifest
+        std::set<std::string> setPending;
+        for(std::vector<CCandyDelta>::const_iterator it = vPending.begin(); it != vPending.end(); it++)
+            setPending.insert(boost::filesystem::path(it->GetFileName()).filename().string());
+
+        boost::filesystem::directory_iterator end_iter;
+        for(boost::filesystem::directory_iterator iter(deltaDir); iter != end_iter; ++iter)
+        {
+            if(boost::filesystem::is_regular_file(iter->status()) && !setPending.count(iter->path().filename().string()))
+                boost::filesystem::remove(iter->path());
+        }
+    } catch (const std::exception& e) {
+        return error("%s: load candy ledger failed - %s", __func__, e.what());
+    }
+
+    // the rest of the change info of the last delta may not have been written before the
+    // restart, then its block is processed again and the delta replaced
+    fDeltaOpen = !vPending.empty();
+
+    LogPrintf("%s: %u pending candy deltas\n", __func__, vPending.size());
+    return true;
+}
+
+bool CCandyLedger::AppendDelta(const int& nHeight, const int& nLastCandyHeight, const std::map<std::string, CAmount>& mapAddressAmount)
+{
+    // a rewrite of a height drops the deltas from that height on
+    while(!vPending.empty() && vPending.back().nHeight >= nHeight)
+    {
+        candySnapshotStore.Release(vPending.back().GetFileName());
+        vPending.pop_back();
+        nGeneration++;
+    }
+
+    CCandyDelta delta(nHeight, nLastCandyHeight);
+    const boost::filesystem::path pathDelta = GetDataDir() / "height" / delta.GetFileName();
+
+    if(!MergeAddressAmountFile(CAddressAmountView(), mapAddressAmount, pathDelta))
+        return error("%s: write delta of %d failed", __func__, nHeight);
+
+    vPending.push_back(delta);
+    if(!WriteManifest())
+    {
+        vPending.pop_back();
+        return false;
+    }
+
+    fDeltaOpen = true;
+    return true;
+}
+
+bool CCandyLedger::NeedCompact() const
+{
+    if(vPending.empty() || fDeltaOpen)
+        return false;
+
+    return vPending.size() >= CANDY_DELTA_COMPACT_COUNT || GetTime() - nLastCompactTime >= CANDY_DELTA_COMPACT_INTERVAL;
+}
+
+bool CCandyLedger::Compact(std::mutex& mutexLedger)
+{
+    std::vector<CCandyDelta> vCompact;
+    uint64_t nCompactGeneration = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutexLedger);
+        nLastCompactTime = GetTime();
+        vCompact = vPending;
+        if(fDeltaOpen && !vCompact.empty())
+            vCompact.pop_back();
+        nCompactGeneration = nGeneration;
+    }
+    if(vCompact.empty())
+        return true;
+
+    int64_t nStart = GetTimeMillis();
+
+    // 1. sum the pending deltas per target file
+    std::map<std::string, CAmount> mapAll;
+    std::map<int, std::map<std::string, CAmount> > mapChange;
+    for(std::vector<CCandyDelta>::const_iterator it = vCompact.begin(); it != vCompact.end(); it++)
+    {
+        boost::shared_ptr<const CAddressAmountView> pView = candySnapshotStore.Get(it->GetFileName());
+        if(!pView)
+            return error("%s: map delta of %d failed", __func__, it->nHeight);
+
+        for(const CAddressAmount* pData = pView->begin(); pData != pView->end(); pData++)
+        {
+            mapAll[pData->szAddress] += pData->nAmount;
+            if(it->nLastCandyHeight > 0)
+                mapChange[it->nLastCandyHeight][pData->szAddress] += pData->nAmount;
+        }
+    }
+
+    // 2. rewrite each affected file once, readers keep using the current files meanwhile
+    std::vector<std::pair<std::string, const std::map<std::string, CAmount>*> > vTarget;
+    vTarget.push_back(std::make_pair(std::string("all.dat"), &mapAll));
+    for(std::map<int, std::map<std::string, CAmount> >::const_iterator it = mapChange.begin(); it != mapChange.end(); it++)
+        vTarget.push_back(std::make_pair(strprintf("%d.change", it->first), &it->second));
+
+    const boost::filesystem::path heightDir = GetDataDir() / "height";
+    std::vector<std::string> vTempInstall;
+    for(unsigned int i = 0; i < vTarget.size(); i++)
+    {
+        boost::shared_ptr<const CAddressAmountView> pView = candySnapshotStore.Get(vTarget[i].first);
+        if(!pView)
+            return error("%s: map %s failed", __func__, vTarget[i].first);
+
+        if(!MergeAddressAmountFile(*pView, *vTarget[i].second, heightDir / (vTarget[i].first + ".temp")))
+            return error("%s: merge pending deltas to %s failed", __func__, vTarget[i].first);
+        vTempInstall.push_back(vTarget[i].first);
+    }
+
+    // 3. commit the compaction, then move the rewritten files into place
+    std::lock_guard<std::mutex> lock(mutexLedger);
+    if(nGeneration != nCompactGeneration)
+    {
+        LogPrintf("%s: pending deltas were replaced, discard the compaction\n", __func__);
+        for(unsigned int i = 0; i < vTempInstall.size(); i++)
+            boost::filesystem::remove(heightDir / (vTempInstall[i] + ".temp"));
+        return true;
+    }
+
+    // deltas appended meanwhile stay pending
+    assert(vPending.size() >= vCompact.size());
+    std::vector<CCandyDelta> vRemain(vPending.begin() + vCompact.size(), vPending.end());
+    vPending.swap(vRemain);
+    vInstall = vTempInstall;
+    if(!WriteManifest())
+    {
+        vPending.swap(vRemain);
+        vInstall.clear();
+        return false;
+    }
+
+    if(!InstallFiles())
+        throw std::runtime_error(strprintf("%s: install compacted candy files failed", __func__));
+
+    for(std::vector<CCandyDelta>::const_iterator it = vCompact.begin(); it != vCompact.end(); it++)
+    {
+        candySnapshotStore.Release(it->GetFileName());
+        boost::filesystem::remove(heightDir / it->GetFileName());
+    }
+
+    LogPrint("bench", "%s: compacted %u deltas into %u files: %.2fms\n", __func__, vCompact.size(), vTarget.size(), GetTimeMillis() - nStart);
+    return true;
+}
+
+bool CCandyLedger::FindPending(const int& nCandyHeight, const std::string& strAddress, CAmount& nAmount) const
+{
+    for(std::vector<CCandyDelta>::const_iterator it = vPending.begin(); it != vPending.end(); it++)
+    {
+        if(it->nLastCandyHeight >= nCandyHeight)
+            break;
+
+        boost::shared_ptr<const CAddressAmountView> pView = candySnapshotStore.Get(it->GetFileName());
+        if(!pView)
+            return error("%s: map delta of %d failed", __func__, it->nHeight);
+
+        CAmount nDelta = 0;
+        if(pView->Find(strAddress, nDelta) == 0)
+            nAmount += nDelta;
+    }
+
+    return true;
+}
+
+bool CCandyLedger::MergePending(const int& nCandyHeight, const std::vector<std::string>& vAddress, std::vector<CAmount>& vAmount) const
+{
+    for(std::vector<CCandyDelta>::const_iterator it = vPending.begin(); it != vPending.end(); it++)
+    {
+        if(it->nLastCandyHeight >= nCandyHeight)
+            break;
+
+        boost::shared_ptr<const CAddressAmountView> pView = candySnapshotStore.Get(it->GetFileName());
+        if(!pView)
+            return error("%s: map delta of %d failed", __func__, it->nHeight);
+
+        pView->MergeAmounts(vAddress, vAmount, 1);
+    }
+
+    return true;
+}
@@ -0,0 +1,184 @@
+// Copyright (c) 2018-2019 The Safe Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef SAFE_CANDYSNAPSHOT_H
+#define SAFE_CANDYSNAPSHOT_H
+
+#include "amount.h"
+#include "serialize.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+struct CAddressAmount;
+
+/** Number of records covered by one entry of the in-memory fence index */
+static const unsigned int CANDY_SNAPSHOT_FENCE_INTERVAL = 64;
+/** Compact the candy ledger once this many block deltas are pending */
+static const unsigned int CANDY_DELTA_COMPACT_COUNT = 144;
+/** Compact pending block deltas at least this often (in seconds) */
+static const int64_t CANDY_DELTA_COMPACT_INTERVAL = 30 * 60;
+
+/**
+ * Read-only, memory-mapped view of a sorted address amount file (all.dat or
+ * <height>.change). The on-disk layout is a plain array of CAddressAmount
+ * records ordered by address, as written by WriteChangeFile.
+ *
+ * A fence index holding the first 8 address bytes of every
+ * CANDY_SNAPSHOT_FENCE_INTERVAL-th record narrows each lookup to a single
+ * block of records, so a lookup costs a few memory compares and no syscalls.
+ */
+class CAddressAmountView : private boost::noncopyable
+{
+private:
+    boost::interprocess::file_mapping mapping;
+    boost::interprocess::mapped_region region;
+    const CAddressAmount* pRecords;
+    size_t nRecords;
+    std::vector<uint64_t> vFence;
+
+public:
+    CAddressAmountView();
+
+    /** Map path, a missing or empty file is treated as an empty view */
+    bool Open(const boost::filesystem::path& path);
+
+    size_t size() const { return nRecords; }
+    const CAddressAmount* begin() const { return pRecords; }
+    const CAddressAmount* end() const;
+
+    /**
+     * Search strAddress in the view, with the result convention of BinarySearchFromFile:
+     * found: 0, none: 1 (strAddress is a median) or 2 (strAddress is more than all records).
+     * pPos receives the position of the record or the position it would be inserted at.
+     */
+    int Find(const std::string& strAddress, CAmount& nAmount, long* pPos = NULL) const;
+
+    /**
+     * Add nSign times the amount of every address of vAddress (sorted ascending)
+     * to the matching slot of vAmount, in a single forward pass over the view.
+     */
+    void MergeAmounts(const std::vector<std::string>& vAddress, std::vector<CAmount>& vAmount, int nSign) const;
+};
+
+/**
+ * Cache of mapped address amount files, keyed by their path relative to the
+ * height directory. Writers of those files must call Release before replacing
+ * or removing a file.
+ */
+class CCandySnapshotStore
+{
+private:
+    std::mutex mutex;
+    std::map<std::string, boost::shared_ptr<const CAddressAmountView> > mapViews;
+
+public:
+    /** Get the view of strFile in the height directory, mapping it if needed */
+    boost::shared_ptr<const CAddressAmountView> Get(const std::string& strFile);
+    void Release(const std::string& strFile);
+    void Clear();
+};
+
+extern CCandySnapshotStore candySnapshotStore;
+
+/** Merge the sorted mapDelta into the records of src and write the sorted result to dest, dropping zero amounts */
+bool MergeAddressAmountFile(const CAddressAmountView& src, const std::map<std::string, CAmount>& mapDelta, const boost::filesystem::path& dest);
+
+/** Address amount changes of one block which are not compacted yet */
+struct CCandyDelta
+{
+    int nHeight;
+    int nLastCandyHeight;
+
+    CCandyDelta(const int& nHeightIn = 0, const int& nLastCandyHeightIn = 0)
+        : nHeight(nHeightIn), nLastCandyHeight(nLastCandyHeightIn) {
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(nHeight);
+        READWRITE(nLastCandyHeight);
+    }
+
+    /** Path of the delta file, relative to the height directory */
+    std::string GetFileName() const;
+};
+
+/**
+ * Log-structured candy balance ledger.
+ *
+ * Every block appends a small sorted delta file (height/delta/<height>.dat)
+ * instead of rewriting all.dat and the current change file. Pending deltas
+ * are folded into all.dat and the change files by Compact, which rewrites
+ * each affected file once for the whole batch.
+ *
+ * manifest.dat lists the pending deltas and, while a compaction is being
+ * installed, the rewritten files still to be renamed into place, so an
+ * interrupted compaction is rolled forward by Load. Readers combine the
+ * compacted files with the pending deltas listed in the manifest.
+ *
+ * The last appended delta stays open until the rest of the change info of its
+ * block is written, an open delta may still be replaced after a restart and is
+ * never compacted.
+ *
+ * All methods except Compact must be called with g_mutexChangeFile held.
+ */
+class CCandyLedger
+{
+private:
+    std::vector<CCandyDelta> vPending;
+    std::vector<std::string> vInstall;
+    int64_t nLastCompactTime;
+    // bumped whenever pending deltas are dropped, a compaction running meanwhile is discarded
+    uint64_t nGeneration;
+    bool fDeltaOpen;
+
+    bool WriteManifest() const;
+    bool InstallFiles();
+
+public:
+    CCandyLedger();
+
+    /** Read the manifest, finish an interrupted compaction and remove stale deltas */
+    bool Load();
+
+    /** Store the address changes of nHeight as an open pending delta, replacing deltas at or above nHeight */
+    bool AppendDelta(const int& nHeight, const int& nLastCandyHeight, const std::map<std::string, CAmount>& mapAddressAmount);
+
+    /** Close the last delta once all change info of its block is written */
+    void CloseDelta() { fDeltaOpen = false; }
+
+    bool NeedCompact() const;
+
+    /**
+     * Fold every pending delta into all.dat and the change files. Must be called
+     * with mutexLedger (g_mutexChangeFile) not held, from the thread which appends
+     * the deltas: the files are rewritten without the lock, so readers are not
+     * blocked, and only swapped in under it.
+     */
+    bool Compact(std::mutex& mutexLedger);
+
+    /**
+     * Add the pending changes which belong to the balance at nCandyHeight, that is the
+     * deltas which are not yet counted in a change file at or above nCandyHeight.
+     */
+    bool FindPending(const int& nCandyHeight, const std::string& strAddress, CAmount& nAmount) const;
+    bool MergePending(const int& nCandyHeight, const std::vector<std::string>& vAddress, std::vector<CAmount>& vAmount) const;
+
+    size_t GetPendingCount() const { return vPending.size(); }
+};
+
+extern CCandyLedger candyLedger;
+
+#endif // SAFE_CANDYSNAPSHOT_H
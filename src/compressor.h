@@ -118,7 +118,7 @@ public:
         CScriptCompressor cscript(REF(txout.scriptPubKey));
         READWRITE(cscript);
         READWRITE(txout.nUnlockedHeight);
-        READWRITE(txout.vReserve);
+        READWRITE(*(CTxOutReserveBase*)(&txout.vReserve));
     }
 };
 
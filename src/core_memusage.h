@@ -13,6 +13,10 @@ static inline size_t RecursiveDynamicUsage(const CScript& script) {
     return memusage::DynamicUsage(*static_cast<const CScriptBase*>(&script));
 }
 
+static inline size_t RecursiveDynamicUsage(const CTxOutReserve& reserve) {
+    return memusage::DynamicUsage(*static_cast<const CTxOutReserveBase*>(&reserve));
+}
+
 static inline size_t RecursiveDynamicUsage(const COutPoint& out) {
     return 0;
 }
@@ -22,7 +26,7 @@ static inline size_t RecursiveDynamicUsage(const CTxIn& in) {
 }
 
 static inline size_t RecursiveDynamicUsage(const CTxOut& out) {
-    return RecursiveDynamicUsage(out.scriptPubKey);
+    return RecursiveDynamicUsage(out.scriptPubKey) + RecursiveDynamicUsage(out.vReserve);
 }
 
 static inline size_t RecursiveDynamicUsage(const CTransaction& tx) {
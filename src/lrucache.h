@@ -0,0 +1,171 @@
+// Copyright (c) 2018-2019 The Safe Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef SAFE_LRUCACHE_H
+#define SAFE_LRUCACHE_H
+
+#include <list>
+#include <map>
+#include <utility>
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+
+/**
+ * Map like container that keeps the N most recently used items.
+ * Not thread safe, see CShardedLRUCache.
+ */
+template<typename K, typename V>
+class CLRUCache
+{
+private:
+    typedef std::list<std::pair<K, V> > list_t;
+    typedef std::map<K, typename list_t::iterator> map_t;
+
+    size_t nMaxSize;
+    list_t listItems; // most recently used first
+    map_t mapIndex;
+
+public:
+    CLRUCache(size_t nMaxSizeIn = 0) : nMaxSize(nMaxSizeIn) {}
+
+    void SetMaxSize(size_t nMaxSizeIn)
+    {
+        nMaxSize = nMaxSizeIn;
+        while(mapIndex.size() > nMaxSize)
+            PruneLast();
+    }
+
+    size_t GetMaxSize() const { return nMaxSize; }
+    size_t GetSize() const { return mapIndex.size(); }
+
+    void Insert(const K& key, const V& value)
+    {
+        typename map_t::iterator it = mapIndex.find(key);
+        if(it != mapIndex.end())
+        {
+            it->second->second = value;
+            listItems.splice(listItems.begin(), listItems, it->second);
+            return;
+        }
+        if(nMaxSize == 0)
+            return;
+        if(mapIndex.size() >= nMaxSize)
+            PruneLast();
+        listItems.push_front(std::make_pair(key, value));
+        mapIndex.insert(std::make_pair(key, listItems.begin()));
+    }
+
+    /** Copy the value of key and mark it as most recently used */
+    bool Get(const K& key, V& value)
+    {
+        typename map_t::iterator it = mapIndex.find(key);
+        if(it == mapIndex.end())
+            return false;
+        listItems.splice(listItems.begin(), listItems, it->second);
+        value = it->second->second;
+        return true;
+    }
+
+    void Erase(const K& key)
+    {
+        typename map_t::iterator it = mapIndex.find(key);
+        if(it == mapIndex.end())
+            return;
+        listItems.erase(it->second);
+        mapIndex.erase(it);
+    }
+
+    void Clear()
+    {
+        mapIndex.clear();
+        listItems.clear();
+    }
+
+private:
+    void PruneLast()
+    {
+        if(listItems.empty())
+            return;
+        mapIndex.erase(listItems.back().first);
+        listItems.pop_back();
+    }
+};
+
+/**
+ * Thread safe LRU cache split into N independently locked shards, so that
+ * concurrent readers rarely wait on each other. Hasher maps a key to the
+ * shard holding it.
+ */
+template<typename K, typename V, typename Hasher, unsigned int N = 16>
+class CShardedLRUCache : private boost::noncopyable
+{
+private:
+    struct Shard
+    {
+        boost::mutex mutex;
+        CLRUCache<K, V> cache;
+    };
+
+    Shard shards[N];
+    Hasher hasher;
+
+    Shard& GetShard(const K& key) { return shards[hasher(key) % N]; }
+
+public:
+    CShardedLRUCache(size_t nMaxSize = 0) { SetMaxSize(nMaxSize); }
+
+    /** Set the total capacity, spread evenly over the shards */
+    void SetMaxSize(size_t nMaxSize)
+    {
+        for(unsigned int i = 0; i < N; i++)
+        {
+            boost::mutex::scoped_lock lock(shards[i].mutex);
+            shards[i].cache.SetMaxSize((nMaxSize + N - 1) / N);
+        }
+    }
+
+    void Insert(const K& key, const V& value)
+    {
+        Shard& shard = GetShard(key);
+        boost::mutex::scoped_lock lock(shard.mutex);
+        shard.cache.Insert(key, value);
+    }
+
+    bool Get(const K& key, V& value)
+    {
+        Shard& shard = GetShard(key);
+        boost::mutex::scoped_lock lock(shard.mutex);
+        return shard.cache.Get(key, value);
+    }
+
+    void Erase(const K& key)
+    {
+        Shard& shard = GetShard(key);
+        boost::mutex::scoped_lock lock(shard.mutex);
+        shard.cache.Erase(key);
+    }
+
+    void Clear()
+    {
+        for(unsigned int i = 0; i < N; i++)
+        {
+            boost::mutex::scoped_lock lock(shards[i].mutex);
+            shards[i].cache.Clear();
+        }
+    }
+
+    size_t GetSize()
+    {
+        size_t nSize = 0;
+        for(unsigned int i = 0; i < N; i++)
+        {
+            boost::mutex::scoped_lock lock(shards[i].mutex);
+            nSize += shards[i].cache.GetSize();
+        }
+        return nSize;
+    }
+};
+
+#endif // SAFE_LRUCACHE_H
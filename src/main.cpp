@@ -7,6 +7,7 @@
 #include "consensus/merkle.h"
 #include "init.h"
 #include "masternode.h"
+#include "lrucache.h"
 
 #include <string>
 
@@ -150,8 +151,42 @@ bool CheckCriticalBlock(const CBlockHeader& block)
     return false;
 }
 
+struct CTxHeightInfo
+{
+    int nHeight;
+    int32_t nVersion;
+    uint256 hashBlock;
+
+    CTxHeightInfo() : nHeight(0), nVersion(0) {}
+    CTxHeightInfo(const int& nHeightIn, const int32_t& nVersionIn, const uint256& hashBlockIn)
+        : nHeight(nHeightIn), nVersion(nVersionIn), hashBlock(hashBlockIn) {}
+};
+
+/** Confirmed transactions of the active chain, filled by ConnectBlock, the wallet and lookups, emptied by DisconnectBlock */
+static CShardedLRUCache<uint256, CTxHeightInfo, BlockHasher> txHeightCache(TX_HEIGHT_CACHE_SIZE);
+
+void CacheTxHeight(const uint256& txHash, const int& nHeight, const int32_t& nVersion, const uint256& hashBlock)
+{
+    txHeightCache.Insert(txHash, CTxHeightInfo(nHeight, nVersion, hashBlock));
+}
+
+void UncacheTxHeight(const uint256& txHash)
+{
+    txHeightCache.Erase(txHash);
+}
+
 int GetTxHeight(const uint256& txHash, uint256* pBlockHash, int32_t* pVersion)
 {
+    CTxHeightInfo info;
+    if(txHeightCache.Get(txHash, info))
+    {
+        if(pVersion)
+            *pVersion = info.nVersion;
+        if(pBlockHash)
+            *pBlockHash = info.hashBlock;
+        return info.nHeight;
+    }
+
     CTransaction txTmp;
     uint256 hashBlock = uint256();
     if(GetTransaction(txHash, txTmp, Params().GetConsensus(), hashBlock, true) && hashBlock != uint256())
@@ -159,11 +194,14 @@ int GetTxHeight(const uint256& txHash, uint256* pBlockHash, int32_t* pVersion)
         if (pVersion)
             *pVersion = txTmp.nVersion;
 
+        LOCK(cs_main);
         BlockMap::iterator mi = mapBlockIndex.find(hashBlock);
         if(mi != mapBlockIndex.end() && (*mi).second)
         {
             if(pBlockHash)
                 *pBlockHash = hashBlock;
+            if(chainActive.Contains((*mi).second))
+                CacheTxHeight(txHash, (*mi).second->nHeight, txTmp.nVersion, hashBlock);
             return (*mi).second->nHeight;
         }
     }
@@ -361,7 +399,7 @@ CAmount GetTxAdditionalFee(const CTransaction& tx)
     CAmount nFee = 0;
     BOOST_FOREACH(const CTxOut& txout, tx.vout)
     {
-        const std::vector<unsigned char>& vReserve = txout.vReserve;
+        const CTxOutReserve& vReserve = txout.vReserve;
         unsigned int nSize = vReserve.size();
         if(nSize > TXOUT_RESERVE_MAX_SIZE)
             return -1;
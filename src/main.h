@@ -67,8 +67,17 @@ CBlock CreateCriticalBlock(const CBlockIndex* pindexPrev, const int nVersion, co
 
 bool CheckCriticalBlock(const CBlockHeader& block);
 
+/** Number of confirmed transactions whose height and version are kept for lock checks */
+static const unsigned int TX_HEIGHT_CACHE_SIZE = 100000;
+
 int GetTxHeight(const uint256& txHash, uint256* pBlockHash = NULL, int32_t* pVersion = NULL);
 
+/** Remember that txHash was confirmed in the active chain block hashBlock at nHeight */
+void CacheTxHeight(const uint256& txHash, const int& nHeight, const int32_t& nVersion, const uint256& hashBlock);
+
+/** Forget txHash, called when its block is disconnected */
+void UncacheTxHeight(const uint256& txHash);
+
 bool IsLockedTxOut(const uint256& txHash, const CTxOut& txout);
 
 bool IsLockedTxOutByHeight(const int& nHeight, const CTxOut& txout, const int32_t& nVersion);
@@ -80,10 +80,33 @@ bool CMasternodeMan::Add(CMasternode &mn)
 
     LogPrint("masternode", "CMasternodeMan::Add -- Adding new Masternode: addr=%s, %i now\n", mn.addr.ToString(), size() + 1);
     mapMasternodes[mn.vin.prevout] = mn;
+    AddToCollateralIndex(mn.vin.prevout, mn);
     fMasternodesAdded = true;
     return true;
 }
 
+void CMasternodeMan::AddToCollateralIndex(const COutPoint& outpoint, const CMasternode& mn)
+{
+    mapCollateralIndex[mn.pubKeyCollateralAddress.GetID().ToString()].insert(outpoint);
+}
+
+void CMasternodeMan::RemoveFromCollateralIndex(const COutPoint& outpoint, const CMasternode& mn)
+{
+    std::map<std::string, std::set<COutPoint> >::iterator it = mapCollateralIndex.find(mn.pubKeyCollateralAddress.GetID().ToString());
+    if(it == mapCollateralIndex.end())
+        return;
+    it->second.erase(outpoint);
+    if(it->second.empty())
+        mapCollateralIndex.erase(it);
+}
+
+void CMasternodeMan::RebuildCollateralIndex()
+{
+    mapCollateralIndex.clear();
+    for (auto& mnpair : mapMasternodes)
+        AddToCollateralIndex(mnpair.first, mnpair.second);
+}
+
 void CMasternodeMan::AskForMN(CNode* pnode, const COutPoint& outpoint, CConnman& connman)
 {
     if(!pnode) return;
@@ -194,6 +217,7 @@ void CMasternodeMan::CheckAndRemove(CConnman& connman)
 
                 // and finally remove it from the list
                 it->second.FlagGovernanceItemsAsDirty();
+                RemoveFromCollateralIndex(it->first, it->second);
                 mapMasternodes.erase(it++);
                 fMasternodesRemoved = true;
             } else {
@@ -350,6 +374,7 @@ void CMasternodeMan::Clear()
 {
     LOCK(cs);
     mapMasternodes.clear();
+    mapCollateralIndex.clear();
     mAskedUsForMasternodeList.clear();
     mWeAskedForMasternodeList.clear();
     mWeAskedForMasternodeListEntry.clear();
@@ -1666,17 +1691,19 @@ void CMasternodeMan::GetFullMasternodeData(std::map<COutPoint, CMasternode> &map
 
     if(fFilterSpent)
     {
-        std::map<std::string, std::pair<COutPoint,CMasternode> > mapAddressMasternodes;
-        for (auto& mnpair : mapMasternodes)
-        {
-            std::string strPubKeyCollateralAddress = mnpair.second.pubKeyCollateralAddress.GetID().ToString();
-            mapAddressMasternodes[strPubKeyCollateralAddress] = make_pair(mnpair.first,mnpair.second);
-        }
         int nLogOldCnt = 0,nLogPayNotFoundCnt = 0;
         for(auto& payeeInfo : mapAllPayeeInfo)
         {
-            if(!fOfficialMasterNode && mapAddressMasternodes.count(payeeInfo.first)<=0)
+            // if several masternodes share a collateral address the one with the greatest outpoint is used
+            std::map<COutPoint, CMasternode>::const_iterator itMn = mapMasternodes.end();
+            std::map<std::string, std::set<COutPoint> >::const_iterator itIndex = mapCollateralIndex.find(payeeInfo.first);
+            if(itIndex != mapCollateralIndex.end() && !itIndex->second.empty())
+                itMn = mapMasternodes.find(*itIndex->second.rbegin());
+            if(itMn == mapMasternodes.end())
             {
+                if(fOfficialMasterNode)
+                    continue;
+
                 nLogPayNotFoundCnt++;
                 if(nLogPayNotFoundCnt<=g_nLogMaxCnt)
                 {
@@ -1691,14 +1718,15 @@ void CMasternodeMan::GetFullMasternodeData(std::map<COutPoint, CMasternode> &map
                 continue;
             }
 
-            std::pair<COutPoint,CMasternode>& mnpair = mapAddressMasternodes[payeeInfo.first];
-            bool fSelfMasternode = activeMasternode.pubKeyMasternode == mnpair.second.pubKeyMasternode;
+            const COutPoint& outpoint = itMn->first;
+            const CMasternode& mnRef = itMn->second;
+            bool fSelfMasternode = activeMasternode.pubKeyMasternode == mnRef.pubKeyMasternode;
             if(!fOfficialMasterNode && nHeight-payeeInfo.second.nHeight>=g_nCanSelectMasternodeHeight)
             {
                 if(fSelfMasternode)
                 {
                     LogPrintf("SPOS_Message:not meeted active masternode,payee(%s),ip:%s,nHeight:%d is old,blockTime:%lld,nPayeeTimes:%d,currHeight:%d\n",
-                              payeeInfo.first,mnpair.second.addr.ToStringIP(),payeeInfo.second.nHeight,payeeInfo.second.blockTime,
+                              payeeInfo.first,mnRef.addr.ToStringIP(),payeeInfo.second.nHeight,payeeInfo.second.blockTime,
                               payeeInfo.second.nPayeeTimes,nHeight);
                 }else
                 {
@@ -1706,30 +1734,32 @@ void CMasternodeMan::GetFullMasternodeData(std::map<COutPoint, CMasternode> &map
                     if(nLogOldCnt<=g_nLogMaxCnt)
                     {
                         LogPrintf("SPOS_Message:payee(%s),ip:%s,nHeight:%d is old,blockTime:%lld,nPayeeTimes:%d,currHeight:%d\n",payeeInfo.first,
-                                  mnpair.second.addr.ToStringIP(),payeeInfo.second.nHeight,payeeInfo.second.blockTime,
+                                  mnRef.addr.ToStringIP(),payeeInfo.second.nHeight,payeeInfo.second.blockTime,
                                   payeeInfo.second.nPayeeTimes,nHeight);
                     }else
                     {
                         LogPrint("sposinfo","SPOS_Message:extra payee(%s),ip:%s,nHeight:%d is old,blockTime:%lld,nPayeeTimes:%d,currHeight:%d\n",payeeInfo.first,
-                                  mnpair.second.addr.ToStringIP(),payeeInfo.second.nHeight,payeeInfo.second.blockTime,
+                                  mnRef.addr.ToStringIP(),payeeInfo.second.nHeight,payeeInfo.second.blockTime,
                                   payeeInfo.second.nPayeeTimes,nHeight);
                     }
                 }
                 continue;
             }
-            mnpair.second.nTxHeight = -1;
-            CMasternode::CollateralStatus err = CMasternode::CheckCollateral(mnpair.first,mnpair.second.nTxHeight);
-            unsigned int canBeSelectTime = mnpair.second.getCanbeSelectTime(nHeight);
+            // only candidates are copied, their collateral height is set on the copy
+            CMasternode mn(mnRef);
+            mn.nTxHeight = -1;
+            CMasternode::CollateralStatus err = CMasternode::CheckCollateral(outpoint,mn.nTxHeight);
+            unsigned int canBeSelectTime = mn.getCanbeSelectTime(nHeight);
             if (err == CMasternode::COLLATERAL_OK && (fOfficialMasterNode || canBeSelectTime > g_nMasternodeCanBeSelectedTime))
             {
-                mapOutMasternodes[mnpair.first] = mnpair.second;
                 if(fSelfMasternode)
                     LogPrintf("SPOS_Message:meeted active masternode:%s,output:%s,err:%d,canBeSelectTime:%d,nProtocolVersion:%d,height:%d\n",
-                       mnpair.second.addr.ToStringIP(),mnpair.first.ToString(), err, canBeSelectTime,mnpair.second.nProtocolVersion,nHeight);
+                       mn.addr.ToStringIP(),outpoint.ToString(), err, canBeSelectTime,mn.nProtocolVersion,nHeight);
+                mapOutMasternodes[outpoint] = mn;
             }else if(fSelfMasternode)
             {
                 LogPrintf("SPOS_Message:not meeted active masternode:%s,output:%s,err:%d,canBeSelectTime:%d,nProtocolVersion:%d,height:%d\n",
-                       mnpair.second.addr.ToStringIP(),mnpair.first.ToString(), err, canBeSelectTime,mnpair.second.nProtocolVersion,nHeight);
+                       mn.addr.ToStringIP(),outpoint.ToString(), err, canBeSelectTime,mn.nProtocolVersion,nHeight);
             }
         }
         LogPrintf("SPOS_Message:after GetFullMasternodeData,old masternode count:%d,pay not found count:%d\n",nLogOldCnt,nLogPayNotFoundCnt);
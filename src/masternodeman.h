@@ -51,6 +51,8 @@ private:
 
     // map to hold all MNs
     std::map<COutPoint, CMasternode> mapMasternodes;
+    // collateral address as used by the payee index -> outpoints of the MNs paid to it, kept in step with mapMasternodes
+    std::map<std::string, std::set<COutPoint> > mapCollateralIndex;
     // who's asked for the Masternode list and the last time
     std::map<CNetAddr, int64_t> mAskedUsForMasternodeList;
     // who we asked for the Masternode list and the last time
@@ -81,6 +83,10 @@ private:
 
     bool GetMasternodeScores(const uint256& nBlockHash, score_pair_vec_t& vecMasternodeScoresRet, int nMinProtocol = 0);
 
+    void AddToCollateralIndex(const COutPoint& outpoint, const CMasternode& mn);
+    void RemoveFromCollateralIndex(const COutPoint& outpoint, const CMasternode& mn);
+    void RebuildCollateralIndex();
+
 public:
     // Keep track of all broadcasts I've seen
     std::map<uint256, std::pair<int64_t, CMasternodeBroadcast> > mapSeenMasternodeBroadcast;
@@ -120,6 +126,9 @@ public:
         if(ser_action.ForRead() && (strVersion != SERIALIZATION_VERSION_STRING)) {
             Clear();
         }
+        if(ser_action.ForRead()) {
+            RebuildCollateralIndex();
+        }
     }
 
     CMasternodeMan();
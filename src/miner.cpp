@@ -37,8 +37,13 @@
 #include <boost/thread.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/identity.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
 
-#include <queue>
+#include <algorithm>
+#include <limits>
 
 using namespace std;
 
@@ -50,8 +55,9 @@ using namespace std;
 //
 // Unconfirmed transactions in the memory pool often depend on other
 // transactions in the memory pool. When we select transactions from the
-// pool, we select by highest priority or fee rate, so we might consider
-// transactions that depend on transactions that aren't yet in the block.
+// pool, we select packages of a transaction and its not yet included
+// in-mempool ancestors by their combined fee rate, so a high fee child
+// pays for the parents it needs.
 
 uint64_t nLastBlockTx = 0;
 uint64_t nLastBlockSize = 0;
@@ -76,20 +82,201 @@ extern int g_nPushForwardTime;
 extern bool g_fReceiveBlock;
 uint32_t nSposSleeptime = 50;
 
+/** Seconds a cached SPOS block template is kept while the mempool keeps changing */
+static const int64_t SPOS_TEMPLATE_REFRESH_INTERVAL = 5;
+/** A prepared SPOS block is no longer replaced by a template refresh this close to its slot (ms) */
+static const int64_t SPOS_TEMPLATE_FREEZE_TIME = 2000;
+
+/**
+ * SPOS block assembled ahead of the slot of the local masternode: the coinbase
+ * already carries the signed SPOS data and the block passed TestBlockValidity,
+ * so at the slot only the time has to be stamped before it is submitted.
+ */
+struct CSposPreparedBlock
+{
+    const CBlockIndex* pindexPrev;
+    unsigned int nTemplateId;
+    int64_t nSlotTime;
+    bool fValid; // false if the attempt for this slot failed, it is not retried
+    CBlock block;
+
+    CSposPreparedBlock()
+    {
+        SetNull();
+    }
+
+    void SetNull()
+    {
+        pindexPrev = NULL;
+        nTemplateId = 0;
+        nSlotTime = 0;
+        fValid = false;
+        block.SetNull();
+    }
+
+    bool IsFor(const CBlockIndex* pindexPrevIn, const unsigned int& nTemplateIdIn, const int64_t& nSlotTimeIn) const
+    {
+        return pindexPrev && pindexPrev == pindexPrevIn && nTemplateId == nTemplateIdIn && nSlotTime == nSlotTimeIn;
+    }
+};
+
+/** Longest the SPOS miner sleeps when it has no slot deadline to wait for (ms) */
+static const int64_t SPOS_IDLE_WAIT_TIME = 1000;
+
+static boost::mutex csSposWake;
+static boost::condition_variable condSposWake;
+static bool fSposWake = false;
+
+static CCriticalSection cs_sposStats;
+static CSposMinerStats sposStats;
+
+void WakeSposMiner()
+{
+    {
+        boost::unique_lock<boost::mutex> lock(csSposWake);
+        fSposWake = true;
+    }
+    condSposWake.notify_all();
+}
+
+/** Sleep until nWakeTime (ms) or until WakeSposMiner is called, returns true in the latter case */
+static bool WaitForSposEvent(int64_t nWakeTime)
+{
+    boost::unique_lock<boost::mutex> lock(csSposWake);
+    while(!fSposWake)
+    {
+        int64_t nWait = nWakeTime - GetTimeMillis();
+        if(nWait <= 0)
+            return false;
+        condSposWake.timed_wait(lock, boost::posix_time::milliseconds(nWait));
+    }
+    fSposWake = false;
+    return true;
+}
+
+void GetSposMinerStats(CSposMinerStats& stats)
+{
+    LOCK(cs_sposStats);
+    stats = sposStats;
+}
+
+/** Wakes the SPOS miner when the tip changes, so it neither waits for a stale deadline nor polls for new blocks */
+class CSposMinerNotify : public CValidationInterface
+{
+protected:
+    void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
+    {
+        WakeSposMiner();
+    }
+};
 
+static CSposMinerNotify sposMinerNotify;
 
+/** Number of SPOS slots elapsed at nTime (seconds) since the masternode list took effect, the slot index is this modulo the list size */
+static int64_t GetSposIntervalCount(const int64_t& nTime, const int64_t& nStartNewLoopTime, int64_t* pnTimeInerval = NULL)
+{
+    int64_t interval = Params().GetConsensus().nSPOSTargetSpacing;
+    int64_t nTimeInerval = nTime - g_nPushForwardTime + interval - nStartNewLoopTime/ 1000;
+    if(pnTimeInerval)
+        *pnTimeInerval = nTimeInerval;
+    return nTimeInerval / interval - 2;
+}
+
+
+
+
+/**
+ * A mempool transaction together with the totals of its in-mempool ancestors
+ * which are not in the block yet, itself included.
+ */
+struct CTxPackage
+{
+    CTxMemPool::txiter iter;
+    // the required part of the fee of app and asset transactions, see GetTxAdditionalFee
+    CAmount nAdditionalFee;
+    // all in-mempool ancestors, included ones too, only used to order a package
+    uint64_t nCountWithAncestors;
+    uint64_t nSizeWithAncestors;
+    CAmount nModFeesWithAncestors;
+    CAmount nAdditionalFeesWithAncestors;
+    unsigned int nSigOpsWithAncestors;
+
+    CTxPackage(CTxMemPool::txiter entry) : iter(entry)
+    {
+        nAdditionalFee = std::max(GetTxAdditionalFee(entry->GetTx()), (CAmount)0);
+        nCountWithAncestors = 1;
+        nSizeWithAncestors = entry->GetTxSize();
+        nModFeesWithAncestors = entry->GetModifiedFee();
+        nAdditionalFeesWithAncestors = nAdditionalFee;
+        nSigOpsWithAncestors = entry->GetSigOpCount();
+    }
+};
+
+/** Sort packages by ancestor fee rate, the highest first */
+struct CompareTxPackageByAncestorFee
+{
+    bool operator()(const CTxPackage& a, const CTxPackage& b) const
+    {
+        double f1 = (double)a.nModFeesWithAncestors * b.nSizeWithAncestors;
+        double f2 = (double)b.nModFeesWithAncestors * a.nSizeWithAncestors;
+        if (f1 == f2)
+            return CTxMemPool::CompareIteratorByHash()(a.iter, b.iter);
+        return f1 > f2;
+    }
+};
 
-class ScoreCompare
+typedef boost::multi_index_container<
+    CTxPackage,
+    boost::multi_index::indexed_by<
+        // sorted by mempool entry
+        boost::multi_index::ordered_unique<
+            boost::multi_index::member<CTxPackage, CTxMemPool::txiter, &CTxPackage::iter>,
+            CTxMemPool::CompareIteratorByHash
+        >,
+        // sorted by ancestor fee rate
+        boost::multi_index::ordered_unique<
+            boost::multi_index::identity<CTxPackage>,
+            CompareTxPackageByAncestorFee
+        >
+    >
+> indexed_tx_package_set;
+
+/** Remove an ancestor which was added to the block from the package totals */
+struct update_for_parent_inclusion
 {
-public:
-    ScoreCompare() {}
+    update_for_parent_inclusion(const CTxPackage& parentIn) : parent(parentIn) {}
+
+    void operator() (CTxPackage& e)
+    {
+        e.nSizeWithAncestors -= parent.iter->GetTxSize();
+        e.nModFeesWithAncestors -= parent.iter->GetModifiedFee();
+        e.nAdditionalFeesWithAncestors -= parent.nAdditionalFee;
+        e.nSigOpsWithAncestors -= parent.iter->GetSigOpCount();
+    }
 
-    bool operator()(const CTxMemPool::txiter a, const CTxMemPool::txiter b)
+private:
+    CTxPackage parent;
+};
+
+struct CompareTxPackageByAncestorCount
+{
+    bool operator()(const CTxPackage* a, const CTxPackage* b) const
     {
-        return CompareTxMemPoolEntryByScore()(*b,*a); // Convert to less than
+        if (a->nCountWithAncestors != b->nCountWithAncestors)
+            return a->nCountWithAncestors < b->nCountWithAncestors;
+        return CTxMemPool::CompareIteratorByHash()(a->iter, b->iter);
     }
 };
 
+/** Drop a transaction and its in-mempool descendants from the candidates */
+static void ExcludeWithDescendants(CTxMemPool::txiter iter, indexed_tx_package_set& mapPackage)
+{
+    CTxMemPool::setEntries setDescendants;
+    mempool.CalculateDescendants(iter, setDescendants);
+    BOOST_FOREACH(CTxMemPool::txiter desc, setDescendants)
+        mapPackage.erase(desc);
+}
+
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev)
 {
     int64_t nOldTime = pblock->nTime;
@@ -128,11 +315,6 @@ CBlockTemplate* CreateNewBlock(const CChainParams& chainparams, const CScript& s
     // Limit to between 1K and MAX_BLOCK_SIZE-1K for sanity:
     nBlockMaxSize = std::max((unsigned int)1000, std::min((unsigned int)(MaxBlockSize(fDIP0001ActiveAtTip)-1000), nBlockMaxSize));
 
-    // How much of the block should be dedicated to high-priority transactions,
-    // included regardless of the fees they pay
-    unsigned int nBlockPrioritySize = GetArg("-blockprioritysize", DEFAULT_BLOCK_PRIORITY_SIZE);
-    nBlockPrioritySize = std::min(nBlockMaxSize, nBlockPrioritySize);
-
     // Minimum block size you want to create; block will be filled with free transactions
     // until there are no more or the block reaches this size:
     unsigned int nBlockMinSize = GetArg("-blockminsize", DEFAULT_BLOCK_MIN_SIZE);
@@ -140,16 +322,8 @@ CBlockTemplate* CreateNewBlock(const CChainParams& chainparams, const CScript& s
 
     // Collect memory pool transactions into the block
     CTxMemPool::setEntries inBlock;
-    CTxMemPool::setEntries waitSet;
-
-    // This vector will be sorted into a priority queue:
-    vector<TxCoinAgePriority> vecPriority;
-    TxCoinAgePriorityCompare pricomparer;
-    std::map<CTxMemPool::txiter, double, CTxMemPool::CompareIteratorByHash> waitPriMap;
-    typedef std::map<CTxMemPool::txiter, double, CTxMemPool::CompareIteratorByHash>::iterator waitPriIter;
-    double actualPriority = -1;
+    indexed_tx_package_set mapPackage;
 
-    std::priority_queue<CTxMemPool::txiter, std::vector<CTxMemPool::txiter>, ScoreCompare> clearedTxs;
     bool fPrintPriority = GetBoolArg("-printpriority", DEFAULT_PRINTPRIORITY);
     uint64_t nBlockSize = 1000;
     uint64_t nBlockTx = 0;
@@ -182,134 +356,158 @@ CBlockTemplate* CreateNewBlock(const CChainParams& chainparams, const CScript& s
         {
             LOCK(mempool.cs);
 
-            bool fPriorityBlock = nBlockPrioritySize > 0;
-            if (fPriorityBlock) {
-                vecPriority.reserve(mempool.mapTx.size());
-                for (CTxMemPool::indexed_transaction_set::iterator mi = mempool.mapTx.begin();
-                     mi != mempool.mapTx.end(); ++mi)
+            uint64_t nNoLimit = std::numeric_limits<uint64_t>::max();
+            std::string dummy;
+            for (CTxMemPool::txiter mi = mempool.mapTx.begin(); mi != mempool.mapTx.end(); ++mi)
+                mapPackage.insert(CTxPackage(mi));
+            for (indexed_tx_package_set::iterator it = mapPackage.begin(); it != mapPackage.end(); ++it)
+            {
+                CTxPackage package(*it);
+                CTxMemPool::setEntries setAncestors;
+                mempool.CalculateMemPoolAncestors(*it->iter, setAncestors, nNoLimit, nNoLimit, nNoLimit, nNoLimit, dummy, false);
+                BOOST_FOREACH(CTxMemPool::txiter ancestor, setAncestors)
                 {
-                    double dPriority = mi->GetPriority(nHeight);
-                    CAmount dummy;
-                    mempool.ApplyDeltas(mi->GetTx().GetHash(), dPriority, dummy);
-                    vecPriority.push_back(TxCoinAgePriority(dPriority, mi));
+                    package.nCountWithAncestors++;
+                    package.nSizeWithAncestors += ancestor->GetTxSize();
+                    package.nModFeesWithAncestors += ancestor->GetModifiedFee();
+                    package.nAdditionalFeesWithAncestors += mapPackage.find(ancestor)->nAdditionalFee;
+                    package.nSigOpsWithAncestors += ancestor->GetSigOpCount();
                 }
-                std::make_heap(vecPriority.begin(), vecPriority.end(), pricomparer);
+                mapPackage.replace(it, package);
             }
 
-            CTxMemPool::indexed_transaction_set::nth_index<3>::type::iterator mi = mempool.mapTx.get<3>().begin();
-            CTxMemPool::txiter iter;
+            // App and asset rules are checked against the coins of the block built so far, the candy
+            // claims of the block are tracked in mapAssetGetCandy as ConnectBlock does.
+            CCoinsViewCache viewBlock(pcoinsTip);
+            map<CPutCandy_IndexKey, CAmount> mapAssetGetCandy;
+            unsigned int nMaxBlockSigOps = MaxBlockSigOps(fDIP0001ActiveAtTip);
 
-            while (mi != mempool.mapTx.get<3>().end() || !clearedTxs.empty())
+            while (!mapPackage.empty())
             {
-                bool priorityTx = false;
-                if (fPriorityBlock && !vecPriority.empty()) { // add a tx from priority queue to fill the blockprioritysize
-                    priorityTx = true;
-                    iter = vecPriority.front().second;
-                    actualPriority = vecPriority.front().first;
-                    std::pop_heap(vecPriority.begin(), vecPriority.end(), pricomparer);
-                    vecPriority.pop_back();
-                }
-                else if (clearedTxs.empty()) { // add tx with next highest score
-                    iter = mempool.mapTx.project<0>(mi);
-                    mi++;
-                }
-                else {  // try to add a previously postponed child tx
-                    iter = clearedTxs.top();
-                    clearedTxs.pop();
-                }
-
-                if (inBlock.count(iter))
-                    continue; // could have been added to the priorityBlock
-
-                const CTransaction& tx = iter->GetTx();
-
-                bool fOrphan = false;
-                BOOST_FOREACH(CTxMemPool::txiter parent, mempool.GetMemPoolParents(iter))
-                {
-                    if (!inBlock.count(parent)) {
-                        fOrphan = true;
-                        break;
-                    }
-                }
-                if (fOrphan) {
-                    if (priorityTx)
-                        waitPriMap.insert(std::make_pair(iter,actualPriority));
-                    else
-                        waitSet.insert(iter);
+                indexed_tx_package_set::nth_index<1>::type::iterator mi = mapPackage.get<1>().begin();
+                CTxMemPool::txiter iter = mi->iter;
+
+                // A package which can't be added is dropped together with its descendants,
+                // they can't be mined in this block without it.
+                // The additional fee of app and asset transactions is required by consensus,
+                // only the fee paid above it counts toward the relay fee.
+                if (mi->nModFeesWithAncestors - mi->nAdditionalFeesWithAncestors < ::minRelayTxFee.GetFee(mi->nSizeWithAncestors) &&
+                    nBlockSize >= nBlockMinSize) {
+                    ExcludeWithDescendants(iter, mapPackage);
                     continue;
                 }
-
-                unsigned int nTxSize = iter->GetTxSize();
-                if (fPriorityBlock &&
-                    (nBlockSize + nTxSize >= nBlockPrioritySize || !AllowFree(actualPriority))) {
-                    fPriorityBlock = false;
-                    waitPriMap.clear();
-                }
-                if (!priorityTx &&
-                    (iter->GetModifiedFee() < ::minRelayTxFee.GetFee(nTxSize) && nBlockSize >= nBlockMinSize)) {
-                    break;
-                }
-                if (nBlockSize + nTxSize >= nBlockMaxSize) {
-                    if (nBlockSize >  nBlockMaxSize - 100 || lastFewTxs > 50) {
+                if (nBlockSize + mi->nSizeWithAncestors >= nBlockMaxSize) {
+                    if (nBlockSize > nBlockMaxSize - 100 || lastFewTxs > 50) {
                         break;
                     }
-                    // Once we're within 1000 bytes of a full block, only look at 50 more txs
+                    // Once we're within 1000 bytes of a full block, only look at 50 more packages
                     // to try to fill the remaining space.
                     if (nBlockSize > nBlockMaxSize - 1000) {
                         lastFewTxs++;
                     }
+                    ExcludeWithDescendants(iter, mapPackage);
                     continue;
                 }
-
-                if (!IsFinalTx(tx, nHeight, nLockTimeCutoff))
-                    continue;
-
-                unsigned int nTxSigOps = iter->GetSigOpCount();
-                unsigned int nMaxBlockSigOps = MaxBlockSigOps(fDIP0001ActiveAtTip);
-                if (nBlockSigOps + nTxSigOps >= nMaxBlockSigOps) {
+                if (nBlockSigOps + mi->nSigOpsWithAncestors >= nMaxBlockSigOps) {
                     if (nBlockSigOps > nMaxBlockSigOps - 2) {
                         break;
                     }
+                    ExcludeWithDescendants(iter, mapPackage);
                     continue;
                 }
 
-                CAmount nTxFees = iter->GetFee();
-                // Added
-                pblock->vtx.push_back(tx);
-                pblocktemplate->vTxFees.push_back(nTxFees);
-                pblocktemplate->vTxSigOps.push_back(nTxSigOps);
-                nBlockSize += nTxSize;
-                ++nBlockTx;
-                nBlockSigOps += nTxSigOps;
-                nFees += nTxFees;
+                // The package is the transaction and its ancestors not yet in the block, parents first
+                CTxMemPool::setEntries setAncestors;
+                mempool.CalculateMemPoolAncestors(*iter, setAncestors, nNoLimit, nNoLimit, nNoLimit, nNoLimit, dummy, false);
+                std::vector<const CTxPackage*> vPackage;
+                vPackage.push_back(&*mi);
+                BOOST_FOREACH(CTxMemPool::txiter ancestor, setAncestors)
+                {
+                    if (!inBlock.count(ancestor))
+                        vPackage.push_back(&*mapPackage.find(ancestor));
+                }
+                std::sort(vPackage.begin(), vPackage.end(), CompareTxPackageByAncestorCount());
+
+                // Check the package on top of the block, a failing transaction can't be
+                // mined in this block and neither can its descendants.
+                CCoinsViewCache viewPackage(&viewBlock);
+                map<CPutCandy_IndexKey, CAmount> mapPackageGetCandy(mapAssetGetCandy);
+                CTxMemPool::txiter failed = mempool.mapTx.end();
+                for (unsigned int i = 0; i < vPackage.size(); i++)
+                {
+                    const CTransaction& tx = vPackage[i]->iter->GetTx();
+                    if (!IsFinalTx(tx, nHeight, nLockTimeCutoff)) {
+                        failed = vPackage[i]->iter;
+                        break;
+                    }
+
+                    // transactions with unknown inputs are left to TestBlockValidity
+                    if (!viewPackage.HaveInputs(tx))
+                        continue;
+
+                    CValidationState state;
+                    if (!CheckAssetTxInputAndOutput(tx, state, viewPackage) ||
+                        !CheckAppTransaction(tx, state, viewPackage, mapPackageGetCandy, false)) {
+                        LogPrint("asset", "CreateNewBlock(): skip tx %s, %s\n", tx.GetHash().ToString(), FormatStateMessage(state));
+                        failed = vPackage[i]->iter;
+                        break;
+                    }
+                    UpdateCoins(tx, state, viewPackage, nHeight);
+                }
+                if (failed != mempool.mapTx.end()) {
+                    ExcludeWithDescendants(failed, mapPackage);
+                    continue;
+                }
+                viewPackage.Flush();
+                mapAssetGetCandy.swap(mapPackageGetCandy);
 
                 if (fPrintPriority)
                 {
-                    double dPriority = iter->GetPriority(nHeight);
-                    CAmount dummy;
-                    mempool.ApplyDeltas(tx.GetHash(), dPriority, dummy);
-                    LogPrintf("priority %.1f fee %s txid %s\n",
-                              dPriority , CFeeRate(iter->GetModifiedFee(), nTxSize).ToString(), tx.GetHash().ToString());
+                    LogPrintf("package fee %s txs %u txid %s\n",
+                              CFeeRate(mi->nModFeesWithAncestors, mi->nSizeWithAncestors).ToString(), vPackage.size(), iter->GetTx().GetHash().ToString());
                 }
 
-                inBlock.insert(iter);
-
-                // Add transactions that depend on this one to the priority queue
-                BOOST_FOREACH(CTxMemPool::txiter child, mempool.GetMemPoolChildren(iter))
+                std::vector<CTxPackage> vAdded;
+                for (unsigned int i = 0; i < vPackage.size(); i++)
                 {
-                    if (fPriorityBlock) {
-                        waitPriIter wpiter = waitPriMap.find(child);
-                        if (wpiter != waitPriMap.end()) {
-                            vecPriority.push_back(TxCoinAgePriority(wpiter->second,child));
-                            std::push_heap(vecPriority.begin(), vecPriority.end(), pricomparer);
-                            waitPriMap.erase(wpiter);
-                        }
+                    CTxMemPool::txiter it = vPackage[i]->iter;
+                    const CTransaction& tx = it->GetTx();
+                    unsigned int nTxSize = it->GetTxSize();
+                    unsigned int nTxSigOps = it->GetSigOpCount();
+                    CAmount nTxFees = it->GetFee();
+
+                    // Added
+                    pblock->vtx.push_back(tx);
+                    pblocktemplate->vTxFees.push_back(nTxFees);
+                    pblocktemplate->vTxSigOps.push_back(nTxSigOps);
+                    nBlockSize += nTxSize;
+                    ++nBlockTx;
+                    nBlockSigOps += nTxSigOps;
+                    nFees += nTxFees;
+
+                    if (fPrintPriority)
+                    {
+                        LogPrintf("fee %s txid %s\n",
+                                  CFeeRate(it->GetModifiedFee(), nTxSize).ToString(), tx.GetHash().ToString());
                     }
-                    else {
-                        if (waitSet.count(child)) {
-                            clearedTxs.push(child);
-                            waitSet.erase(child);
-                        }
+
+                    inBlock.insert(it);
+                    vAdded.push_back(*vPackage[i]);
+                }
+
+                // Take the added transactions out of the packages of their descendants
+                for (unsigned int i = 0; i < vAdded.size(); i++)
+                {
+                    mapPackage.erase(vAdded[i].iter);
+                    CTxMemPool::setEntries setDescendants;
+                    mempool.CalculateDescendants(vAdded[i].iter, setDescendants);
+                    BOOST_FOREACH(CTxMemPool::txiter desc, setDescendants)
+                    {
+                        if (inBlock.count(desc))
+                            continue;
+                        indexed_tx_package_set::iterator it = mapPackage.find(desc);
+                        if (it != mapPackage.end())
+                            mapPackage.modify(it, update_for_parent_inclusion(vAdded[i]));
                     }
                 }
             }
@@ -667,15 +865,49 @@ void static BitcoinMiner(const CChainParams& chainparams, CConnman& connman)
     }
 }
 
+/** Assemble and validate the block mn generates in the slot starting at nSlotTime (ms), the outcome is kept in prepared */
+static void PrepareSposBlock(const CChainParams& chainparams,CBlockIndex* pindexPrev,const CBlock* pblock,const CMasternode& mn
+                             ,const int64_t& nSlotTime,const unsigned int& nTemplateId,CSposPreparedBlock& prepared)
+{
+    unsigned int nHeight = pindexPrev->nHeight+1;
+    prepared.SetNull();
+    CBlock block(*pblock);
+    block.nTime = nSlotTime / 1000;
+    block.nNonce = mn.getCanbeSelectTime(nHeight);
+    CValidationState state;
+    bool fValid = CoinBaseAddSPosExtraData(&block, pindexPrev, mn);
+    if(fValid)
+    {
+        LOCK(cs_main);
+        fValid = pindexPrev == chainActive.Tip() && TestBlockValidity(state, chainparams, block, pindexPrev, false, false);
+    }
+    prepared.pindexPrev = pindexPrev;
+    prepared.nTemplateId = nTemplateId;
+    prepared.nSlotTime = nSlotTime;
+    prepared.fValid = fValid;
+    if(fValid)
+    {
+        prepared.block = block;
+        {
+            LOCK(cs_sposStats);
+            sposStats.nPreparedBlocks++;
+        }
+        LogPrint("spos", "SPOS_Message:prepared block %d for slot %lld with %u transactions\n", nHeight, nSlotTime, block.vtx.size());
+    }
+    else
+        LogPrintf("SPOS_Warning:prepare block %d failed: %s\n", nHeight, FormatStateMessage(state));
+}
+
 /*
     Consensus Use Safe Pos
 */
 static void ConsensusUseSPos(const CChainParams& chainparams,CConnman& connman,CBlockIndex* pindexPrev
                              ,unsigned int nNewBlockHeight,CBlock *pblock,boost::shared_ptr<CReserveScript>& coinbaseScript
-                             ,unsigned int nTransactionsUpdatedLast,int64_t& nNextTime,unsigned int& nSleepMS
+                             ,unsigned int nTransactionsUpdatedLast,int64_t& nNextTime,int64_t& nWakeTime
                              ,int64_t& nNextLogTime,int64_t& nNextLogAllowTime,unsigned int& nWaitBlockHeight
                              ,std::vector<CMasternode>& tmpVecResultMasternodes,int nSposGeneratedIndex
-                             ,int64_t& nStartNewLoopTime,unsigned int& nEmptySposCntHeight,unsigned int& nAbnormalSposCntHeight)
+                             ,int64_t& nStartNewLoopTime,unsigned int& nEmptySposCntHeight,unsigned int& nAbnormalSposCntHeight
+                             ,const unsigned int& nTemplateId,CSposPreparedBlock& prepared,int64_t& nLastSlotTime)
 {
     int index = 0;
     unsigned int masternodeSPosCount = tmpVecResultMasternodes.size();
@@ -695,7 +927,7 @@ static void ConsensusUseSPos(const CChainParams& chainparams,CConnman& connman,C
     }
 
     //1.3
-    pblock->nTime = GetTime();
+    int64_t nBlockTime = GetTime();
     int64_t nCurrTime = GetTimeMillis();
     if(nCurrTime/1000 + g_nAllowableErrorTime < (int64_t)pindexPrev->nTime)
     {
@@ -711,14 +943,19 @@ static void ConsensusUseSPos(const CChainParams& chainparams,CConnman& connman,C
     }
 
     int64_t interval = Params().GetConsensus().nSPOSTargetSpacing;
-    int64_t nTimeInerval = pblock->nTime - g_nPushForwardTime + interval - nStartNewLoopTime/ 1000;
-    int64_t nTimeIntervalCnt = (nTimeInerval / interval - 2);
+    int64_t nTimeInerval = 0;
+    int64_t nTimeIntervalCnt = GetSposIntervalCount(nBlockTime, nStartNewLoopTime, &nTimeInerval);
     //to avoid nTimeIntervalCnt=masternodeSPosCount,first time nTimeIntervalCnt:-1,index:-1
     if(nTimeIntervalCnt<0)
+    {
+        nWakeTime = nStartNewLoopTime + g_nPushForwardTime*1000 + interval*1000;
         return;
+    }
 
     index = nTimeIntervalCnt % masternodeSPosCount;
     nNextTime = nStartNewLoopTime + g_nPushForwardTime*1000 + (nTimeIntervalCnt+1)*interval*1000;
+    // nothing changes before the next slot starts, unless a new tip or masternode list wakes the miner earlier
+    nWakeTime = nNextTime + interval*1000;
 
     if(index<0||index>=(int)masternodeSPosCount)
     {
@@ -726,52 +963,99 @@ static void ConsensusUseSPos(const CChainParams& chainparams,CConnman& connman,C
         return;
     }
 
+    // the owner of the next slot prepares its block on the current tip, a block arriving for this slot wakes the miner to prepare again
+    CMasternode& mnNext = tmpVecResultMasternodes[(nTimeIntervalCnt+1) % masternodeSPosCount];
+    if(activeMasternode.pubKeyMasternode == mnNext.GetInfo().pubKeyMasternode && !prepared.IsFor(pindexPrev, nTemplateId, nWakeTime))
+    {
+        if(!pblock)
+        {
+            // the slot turned over since the miner decided no template was needed
+            nWakeTime = nCurrTime;
+            return;
+        }
+        PrepareSposBlock(chainparams, pindexPrev, pblock, mnNext, nWakeTime, nTemplateId, prepared);
+    }
+
     CMasternode& mn = tmpVecResultMasternodes[index];
     string masterIP = mn.addr.ToStringIP();
     string localIP = activeMasternode.service.ToStringIP();
     unsigned int nHeight = pindexPrev->nHeight+1;
-    pblock->nNonce = mn.getCanbeSelectTime(nHeight);
 
     if(activeMasternode.pubKeyMasternode != mn.GetInfo().pubKeyMasternode)
     {
-        if(nNewBlockHeight != nWaitBlockHeight && pblock->nTime != nNextLogTime)
+        if(nNewBlockHeight != nWaitBlockHeight && nBlockTime != nNextLogTime)
         {
             LogPrintf("SPOS_Message:Wait MastnodeIP[%d]:%s to generate pos block,current block:%d.blockTime:%lld,g_nStartNewLoopTime:%lld,"
                       "local collateral address:%s,masternode collateral address:%s,nTimeInerval:%d\n",index
-                      ,masterIP,pindexPrev->nHeight,pblock->nTime,nStartNewLoopTime
+                      ,masterIP,pindexPrev->nHeight,nBlockTime,nStartNewLoopTime
                       ,CBitcoinAddress(activeMasternode.pubKeyMasternode.GetID()).ToString()
                       ,CBitcoinAddress(mn.pubKeyMasternode.GetID()).ToString(),nTimeInerval);
         }
-        nNextLogTime = pblock->nTime;
+        nNextLogTime = nBlockTime;
         nWaitBlockHeight = nNewBlockHeight;
         return;
     }
 
+    // the block of this slot was generated already or the slot was missed
+    if(nLastSlotTime == nNextTime)
+        return;
+
     int64_t nActualTimeMillisInterval = std::abs(nNextTime - nCurrTime);
     if(nActualTimeMillisInterval > nIntervalMS && nNextTime!=0 && nSposGeneratedIndex != -2)
     {
+        if(nNextTime > nCurrTime)
+        {
+            // the slot starts within the current second
+            nWakeTime = nNextTime;
+            return;
+        }
+
+        nLastSlotTime = nNextTime;
+        {
+            LOCK(cs_sposStats);
+            sposStats.nMissedSlots++;
+        }
         if(index != nSposGeneratedIndex)
             LogPrintf("SPOS_Warning:nActualTimeMillisInterval(%d) big than nIntervalMS(%d),currblock:%d,sposIndex:%d\n"
                       ,nActualTimeMillisInterval,nIntervalMS,pindexPrev->nHeight,nSposGeneratedIndex);
         return;
     }
 
+    if(!pblock)
+    {
+        nWakeTime = nCurrTime;
+        return;
+    }
+
+    // retry within the slot window if the block can not be generated yet
+    nWakeTime = nCurrTime + nSposSleeptime;
+
     //it's turn to generate block
     LogPrintf("SPOS_Info:Self mastnodeIP[%d]:%s generate pos block:%d.nActualTimeMillisInterval:%d,keyid:%s,nCurrTime:%lld,g_nStartNewLoopTime:%lld,"
               "blockTime:%lld,g_nSposIndex:%d,nTimeInerval:%d,g_nPushForwardTime:%d\n",index,localIP,nNewBlockHeight,nActualTimeMillisInterval,
-              mn.pubKeyMasternode.GetID().ToString(),nCurrTime,nStartNewLoopTime,pblock->nTime,nSposGeneratedIndex,nTimeInerval,g_nPushForwardTime);
+              mn.pubKeyMasternode.GetID().ToString(),nCurrTime,nStartNewLoopTime,nBlockTime,nSposGeneratedIndex,nTimeInerval,g_nPushForwardTime);
 
     SetThreadPriority(THREAD_PRIORITY_NORMAL);
 
+    // use the block prepared for this slot, only its time changes
+    bool fPrepared = prepared.IsFor(pindexPrev, nTemplateId, nNextTime) && prepared.fValid;
+    CBlock block(fPrepared ? prepared.block : *pblock);
+    prepared.SetNull();
+    block.nTime = nBlockTime;
+
     //coin base add extra data
-    if(!CoinBaseAddSPosExtraData(pblock,pindexPrev,mn))
-        return;
+    if(!fPrepared)
+    {
+        block.nNonce = mn.getCanbeSelectTime(nHeight);
+        if(!CoinBaseAddSPosExtraData(&block,pindexPrev,mn))
+            return;
+    }
 
-    if (pblock->nNonce <= g_nMasternodeCanBeSelectedTime)
+    if (block.nNonce <= g_nMasternodeCanBeSelectedTime)
     {
         LogPrintf("SPOS_Warning:the activation time of the selected master node is less than or equal to the master node "
                   "can be selected time of the limit. pblock->nNonce:%d, g_nMasternodeCanBeSelectedTime:%d\n",
-                  pblock->nNonce, g_nMasternodeCanBeSelectedTime);
+                  block.nNonce, g_nMasternodeCanBeSelectedTime);
         return;
     }
 
@@ -782,7 +1066,7 @@ static void ConsensusUseSPos(const CChainParams& chainparams,CConnman& connman,C
     }
 
     CValidationState state;
-    if (!TestBlockValidity(state, chainparams, *pblock, pindexPrev, false, false)) {
+    if (!fPrepared && !TestBlockValidity(state, chainparams, block, pindexPrev, false, false)) {
         throw std::runtime_error(strprintf("%s: TestBlockValidity failed: %s", __func__, FormatStateMessage(state)));
     }
 
@@ -793,15 +1077,23 @@ static void ConsensusUseSPos(const CChainParams& chainparams,CConnman& connman,C
             LOCK(cs_spos);
             g_nSposGeneratedIndex = index;
         }
-        ProcessBlockFound(pblock, chainparams);
+        {
+            int64_t nJitter = GetTimeMillis() - nNextTime;
+            LOCK(cs_sposStats);
+            sposStats.nSlots++;
+            if(fPrepared)
+                sposStats.nPreparedSlots++;
+            sposStats.nLastJitter = nJitter;
+            sposStats.nMaxJitter = std::max(sposStats.nMaxJitter, nJitter);
+            sposStats.nTotalJitter += nJitter;
+        }
+        ProcessBlockFound(&block, chainparams);
 
         SetThreadPriority(THREAD_PRIORITY_LOWEST);
         coinbaseScript->KeepScript();
 
-        if(masternodeSPosCount==1)//XJTODO
-            nSleepMS = Params().GetConsensus().nSPOSTargetSpacing*1000;
-        else
-            nSleepMS = nIntervalMS;
+        nLastSlotTime = nNextTime;
+        nWakeTime = nNextTime + interval*1000;
     }
 
     // In regression test mode, stop mining after a block is found. This
@@ -863,7 +1155,14 @@ void static SposMiner(const CChainParams& chainparams, CConnman& connman)
             g_nStartNewLoopTimeMS = GetTime()*1000;
         }
         unsigned int nWaitBlockHeight = 0,nEmptySposCntHeight = 0,nAbnormalSposCntHeight = 0;
-        int64_t nNextBlockTime = 0,nNextLogTime = 0,nLogOutput = 0,nLastMasternodeCount = 0,nNextLogAllowTime = 0;
+        int64_t nNextBlockTime = 0,nNextLogTime = 0,nLogOutput = 0,nLastMasternodeCount = 0,nNextLogAllowTime = 0,nLastSlotTime = 0;
+
+        // the block template is kept across iterations and only rebuilt for a new tip or a changed mempool
+        std::unique_ptr<CBlockTemplate> pblocktemplate;
+        const CBlockIndex* pindexTemplatePrev = NULL;
+        unsigned int nTemplateTransactionsUpdated = 0,nTemplateId = 0;
+        int64_t nTemplateTime = 0;
+        CSposPreparedBlock prepared;
         while (true) {
             if (chainparams.MiningRequiresPeers()) {
                 // Busy-wait for the network to come online so we don't waste time mining
@@ -876,7 +1175,7 @@ void static SposMiner(const CChainParams& chainparams, CConnman& connman)
                 } while (true);
             }
 
-            unsigned int nSleepMS = 0;
+            int64_t nWakeTime = GetTimeMillis() + SPOS_IDLE_WAIT_TIME;
             CBlockIndex* pindexPrev = chainActive.Tip();
             if(!pindexPrev)
             {
@@ -895,7 +1194,7 @@ void static SposMiner(const CChainParams& chainparams, CConnman& connman)
                         LogPrintf("SPOS_Warning:self masternode outpoint is empty,if self is masternode maybe need to wait sync or reindex or start alias\n");
                         nLogOutput = 1;
                     }
-                    MilliSleep(nSposSleeptime);
+                    WaitForSposEvent(nWakeTime);
                     continue;
                 }
 
@@ -905,26 +1204,6 @@ void static SposMiner(const CChainParams& chainparams, CConnman& connman)
                     LogPrintf("SPOS_Warning:self masternode empty outpoint is normal,start miner\n");
                 }
 
-                std::unique_ptr<CBlockTemplate> pblocktemplate(CreateNewBlock(chainparams, coinbaseScript->reserveScript));
-                if (!pblocktemplate.get())
-                {
-                    LogPrintf("SafeSposMiner -- Keypool ran out, please call keypoolrefill before restarting the mining thread\n");
-                    return;
-                }
-
-                if(pindexPrev != chainActive.Tip())
-                {
-                    LogPrintf("SPOS_Message:create new block(%d) fail,already recived the block:%d\n",nNewBlockHeight,chainActive.Height());
-                    MilliSleep(nSposSleeptime);
-                    continue;
-                }
-
-                CBlock *pblock = &pblocktemplate->block;
-                IncrementExtraNonce(pblock, pindexPrev, nExtraNonce);
-
-//                LogPrintf("SPOS_Message:Running miner with %u transactions in block (%u bytes),currHeight:%d\n",pblock->vtx.size(),
-//                          ::GetSerializeSize(*pblock, SER_NETWORK, PROTOCOL_VERSION),pindexPrev->nHeight);
-
                 std::vector<CMasternode> tmpVecResultMasternodes;
                 int nSposGeneratedIndex=0,masternodeSPosCount=0;
                 int64_t nStartNewLoopTime=0;
@@ -938,21 +1217,86 @@ void static SposMiner(const CChainParams& chainparams, CConnman& connman)
                     nStartNewLoopTime = g_nStartNewLoopTimeMS;
                     nSposGeneratedIndex = g_nSposGeneratedIndex;
                 }
+
+                // only the owners of the current and the next slot need a block template
+                bool fNeedTemplate = false;
+                if(masternodeSPosCount != 0)
+                {
+                    int64_t nTimeIntervalCnt = GetSposIntervalCount(GetTime(), nStartNewLoopTime);
+                    for(int64_t i = std::max(nTimeIntervalCnt, (int64_t)0); i <= nTimeIntervalCnt + 1; i++)
+                    {
+                        if(tmpVecResultMasternodes[i % masternodeSPosCount].GetInfo().pubKeyMasternode == activeMasternode.pubKeyMasternode)
+                            fNeedTemplate = true;
+                    }
+                }
+
+                bool fNewTip = !pblocktemplate || pindexTemplatePrev != pindexPrev;
+                bool fMempoolChanged = nTransactionsUpdatedLast != nTemplateTransactionsUpdated && GetTime() - nTemplateTime >= SPOS_TEMPLATE_REFRESH_INTERVAL;
+                bool fFreeze = prepared.fValid && prepared.pindexPrev == pindexPrev && prepared.nSlotTime - GetTimeMillis() < SPOS_TEMPLATE_FREEZE_TIME;
+                if(fNeedTemplate && (fNewTip || (fMempoolChanged && !fFreeze)))
+                {
+                    pblocktemplate.reset(CreateNewBlock(chainparams, coinbaseScript->reserveScript));
+                    if (!pblocktemplate.get())
+                    {
+                        LogPrintf("SafeSposMiner -- Keypool ran out, please call keypoolrefill before restarting the mining thread\n");
+                        return;
+                    }
+
+                    if(pindexPrev != chainActive.Tip())
+                    {
+                        LogPrintf("SPOS_Message:create new block(%d) fail,already recived the block:%d\n",nNewBlockHeight,chainActive.Height());
+                        pblocktemplate.reset();
+                        MilliSleep(nSposSleeptime);
+                        continue;
+                    }
+
+                    IncrementExtraNonce(&pblocktemplate->block, pindexPrev, nExtraNonce);
+                    pindexTemplatePrev = pindexPrev;
+                    nTemplateTransactionsUpdated = nTransactionsUpdatedLast;
+                    nTemplateTime = GetTime();
+                    nTemplateId++;
+                    {
+                        LOCK(cs_sposStats);
+                        sposStats.nTemplates++;
+                    }
+                }
+
+                CBlock *pblock = fNeedTemplate ? &pblocktemplate->block : NULL;
+
+//                LogPrintf("SPOS_Message:Running miner with %u transactions in block (%u bytes),currHeight:%d\n",pblock->vtx.size(),
+//                          ::GetSerializeSize(*pblock, SER_NETWORK, PROTOCOL_VERSION),pindexPrev->nHeight);
+
                 if(masternodeSPosCount != 0)
                 {
                     ConsensusUseSPos(chainparams,connman,pindexPrev,nNewBlockHeight,pblock,coinbaseScript,nTransactionsUpdatedLast,nNextBlockTime,
-                                     nSleepMS,nNextLogTime,nNextLogAllowTime,nWaitBlockHeight,tmpVecResultMasternodes,nSposGeneratedIndex,
-                                     nStartNewLoopTime,nEmptySposCntHeight,nAbnormalSposCntHeight);
+                                     nWakeTime,nNextLogTime,nNextLogAllowTime,nWaitBlockHeight,tmpVecResultMasternodes,nSposGeneratedIndex,
+                                     nStartNewLoopTime,nEmptySposCntHeight,nAbnormalSposCntHeight,nTemplateId,prepared,nLastSlotTime);
                 }else if(nLastMasternodeCount != 0)
                 {
                     LogPrintf("SPOS_Error:vec_masternodes is empty,nLastMasternodeCount:%d\n",nLastMasternodeCount);
                 }
                 nLastMasternodeCount = masternodeSPosCount;
+
+                // look at a changed mempool while holding the template of an upcoming slot
+                if(fNeedTemplate)
+                    nWakeTime = std::min(nWakeTime, GetTimeMillis() + SPOS_TEMPLATE_REFRESH_INTERVAL*1000);
+            }
+
+            // sleep until the next deadline of the slot schedule, a new tip or masternode list wakes the miner earlier
+            int64_t nCurrTime = GetTimeMillis();
+            if(nWakeTime <= nCurrTime)
+                nWakeTime = nCurrTime + nSposSleeptime;
+            {
+                LOCK(cs_sposStats);
+                sposStats.nNextWakeTime = nWakeTime;
+            }
+            bool fEvent = WaitForSposEvent(nWakeTime);
+            {
+                LOCK(cs_sposStats);
+                sposStats.nWakeups++;
+                if(fEvent)
+                    sposStats.nEventWakeups++;
             }
-            if(nSleepMS>0)
-                MilliSleep(nSleepMS);
-            else
-                MilliSleep(nSposSleeptime);
         }
     }
     catch (const boost::thread_interrupted&)
@@ -1026,12 +1370,14 @@ void GenerateBitcoinsBySPOS(bool fGenerate, int nThreads, const CChainParams& ch
         sposMinerThreads->interrupt_all();
         delete sposMinerThreads;
         sposMinerThreads = NULL;
+        UnregisterValidationInterface(&sposMinerNotify);
     }
 
     if (nThreads == 0 || !fGenerate)
         return;
 
     sposMinerThreads = new boost::thread_group();
+    RegisterValidationInterface(&sposMinerNotify);
     for (int i = 0; i < nThreads; i++)
         sposMinerThreads->create_thread(boost::bind(&SposMiner, boost::cref(chainparams), boost::ref(connman)));
 }
@@ -30,12 +30,38 @@ struct CBlockTemplate
     std::vector<int64_t> vTxSigOps;
 };
 
+/** Counters of the SPOS miner scheduler, times in milliseconds */
+struct CSposMinerStats
+{
+    int64_t nWakeups;           // scheduler passes
+    int64_t nEventWakeups;      // passes started early by a tip or masternode list change
+    int64_t nTemplates;         // block templates created
+    int64_t nPreparedBlocks;    // blocks assembled ahead of the local slot
+    int64_t nSlots;             // local slots a block was submitted for
+    int64_t nPreparedSlots;     // local slots served by a prepared block
+    int64_t nMissedSlots;       // local slots whose window had passed on wakeup
+    int64_t nLastJitter;        // delay between slot start and block submission
+    int64_t nMaxJitter;
+    int64_t nTotalJitter;
+    int64_t nNextWakeTime;
+
+    CSposMinerStats()
+    {
+        nWakeups = nEventWakeups = nTemplates = nPreparedBlocks = 0;
+        nSlots = nPreparedSlots = nMissedSlots = 0;
+        nLastJitter = nMaxJitter = nTotalJitter = nNextWakeTime = 0;
+    }
+};
+
 /** Run the miner threads */
 void GenerateBitcoins(bool fGenerate, int nThreads, const CChainParams& chainparams, CConnman& connman);
 
 void GenerateBitcoinsBySPOS(bool fGenerate, int nThreads, const CChainParams& chainparams, CConnman& connman);
 
 void ThreadSPOSAutoReselect(const CChainParams& chainparams, CConnman& connman);
+/** Let the SPOS miner look at the slot schedule now instead of at its next deadline */
+void WakeSposMiner();
+void GetSposMinerStats(CSposMinerStats& stats);
 /** Generate a new block, without valid proof-of-work */
 CBlockTemplate* CreateNewBlock(const CChainParams& chainparams, const CScript& scriptPubKeyIn);
 /** Modify the extranonce in a block */
@@ -36,27 +36,20 @@ extern int g_nProtocolV2Height;
 
 bool IsProtocolV0(const int& nHeight);
 
-inline bool VectorEqual(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b)
-{
-    unsigned int a_size = a.size();
-    unsigned int b_size = b.size();
-
-    if(a_size != b_size) // non-equal length
-        return false;
+/** Bytes of a txout reserve stored inline. The "safe" marker of plain outputs
+ * fits without a heap allocation, app and SPOS reserves spill to the heap. */
+static const unsigned int TXOUT_RESERVE_INLINE_SIZE = 12;
 
-    if(a_size == 0) // all are empty
-        return true;
-
-    for(std::vector<unsigned char>::const_iterator it_a = a.begin(), it_b = b.begin();
-            it_a != a.end(), it_b != b.end();
-            it_a++, it_b++)
-    {
-        if(*it_a != *it_b)
-            return false;
-    }
+typedef prevector<TXOUT_RESERVE_INLINE_SIZE, unsigned char> CTxOutReserveBase;
 
-    return true;
-}
+/** Reserve data of a txout, serialized exactly like std::vector<unsigned char> */
+class CTxOutReserve : public CTxOutReserveBase
+{
+public:
+    CTxOutReserve() { }
+    CTxOutReserve(const std::vector<unsigned char>& v) : CTxOutReserveBase(v.begin(), v.end()) { }
+    CTxOutReserve(const_iterator pbegin, const_iterator pend) : CTxOutReserveBase(pbegin, pend) { }
+};
 
 /** An outpoint - a combination of a transaction hash and an index n into its vout */
 class COutPoint
@@ -184,7 +177,7 @@ public:
     CScript scriptPubKey;
     int nRounds;
     int64_t nUnlockedHeight;
-    std::vector<unsigned char> vReserve;
+    CTxOutReserve vReserve;
 
     CTxOut()
     {
@@ -202,7 +195,7 @@ public:
         if(nVersion >= SAFE_TX_VERSION_1)
         {
             READWRITE(nUnlockedHeight);
-            READWRITE(vReserve);
+            READWRITE(*(CTxOutReserveBase*)(&vReserve));
         }
     }
 
@@ -319,7 +312,7 @@ public:
                 a.scriptPubKey == b.scriptPubKey &&
                 a.nRounds      == b.nRounds &&
                 a.nUnlockedHeight == b.nUnlockedHeight &&
-                VectorEqual(a.vReserve, b.vReserve));
+                a.vReserve == b.vReserve);
     }
 
     friend bool operator!=(const CTxOut& a, const CTxOut& b)
@@ -245,50 +245,16 @@ void AssetsDistribute::updateCandyValue()
         return;
     int decimal = ui->decimalEdit->text().toInt();
     string totalAssetsStr = ui->totalAssetsEdit->text().toStdString();
-    string memoryAssetsStr = "";
-    int pos = totalAssetsStr.find(".");
-    if(pos<0)
-    {
-        memoryAssetsStr = totalAssetsStr;
-        for(int i=0;i<decimal;i++)
-            memoryAssetsStr.push_back('0');
-    }else
-    {
-        memoryAssetsStr = totalAssetsStr.substr(0,pos);
-        int decimalIndex = pos+1;
-        int strSize = totalAssetsStr.size();
-        for(int i=0;i<decimal;i++)
-        {
-            if(decimalIndex<strSize)
-                memoryAssetsStr.push_back(totalAssetsStr[decimalIndex]);
-            else
-                memoryAssetsStr.push_back('0');
-            decimalIndex++;
-        }
-    }
-    string memoryCandyStr = mulstring(memoryAssetsStr,QString::number(ui->assetsCandyRatioSlider->value()).toStdString());
 
-    int addDecimal = 3;//10% is 1,slider max 100 is 2,total 3
-    int totalDecimal = decimal+addDecimal;
-    int size = memoryCandyStr.size();
-    if(decimal==0||size==0)
+    // slider value is in 1/1000 of the total amount, 100 is 10%
+    CAssetAmount candyAmount;
+    if(decimal<=0||decimal>MAX_ASSETDECIMALS_VALUE||!CAssetAmount::Parse(totalAssetsStr,decimal,candyAmount)
+            ||!candyAmount.Mul(ui->assetsCandyRatioSlider->value())||!candyAmount.Div(1000))
     {
         ui->candyTotalValueLabel->clear();
         return;
     }
-    if(size<=totalDecimal)
-    {
-        string resultStr = "0.";
-        int zeroCount = totalDecimal-size;
-        for(int i=0;i<zeroCount;i++)
-            resultStr.push_back('0');
-        resultStr.append(memoryCandyStr.substr(0,decimal-zeroCount));
-        ui->candyTotalValueLabel->setText(QString::fromStdString(resultStr));
-    }else
-    {
-        string resultStr = numtofloatstring(memoryCandyStr,totalDecimal);
-        ui->candyTotalValueLabel->setText(QString::fromStdString(resultStr.substr(0,resultStr.size()-addDecimal)));
-    }
+    ui->candyTotalValueLabel->setText(QString::fromStdString(candyAmount.ToString(decimal)));
 }
 
 void AssetsDistribute::initFirstDistribute()
@@ -404,6 +404,11 @@ void GetCandyWorker::doGetCandy()
         std::string saddress = CBitcoinAddress(tempit->first).ToString();
         vaddress.push_back(saddress);
     }
+    std::sort(vaddress.begin(), vaddress.end());
+
+    std::vector<CAmount> vSafe;
+    if(!GetAddressAmountsByHeight(nTxHeight, vaddress, vSafe))
+        vSafe.assign(vaddress.size(), 0);
 
     CAppHeader appHeader(g_nAppHeaderVersion, uint256S(g_strSafeAssetId), GET_CANDY_CMD);
     CPutCandy_IndexKey assetIdCandyInfo;
@@ -427,9 +432,7 @@ void GetCandyWorker::doGetCandy()
     bool bGottenCandy = false;
     for (; addit != vaddress.end(); addit++)
     {
-        CAmount nSafe = 0;
-        if(!GetAddressAmountByHeight(nTxHeight, *addit, nSafe))
-            continue;
+        const CAmount& nSafe = vSafe[addit - vaddress.begin()];
         if (nSafe < 1 * COIN || nSafe > nTotalSafe)
             continue;
 
@@ -581,6 +584,7 @@ void CandyPage::eraseCandy(int rowNum)
         return;
     }
     gAllCandyInfoVec.erase(gAllCandyInfoVec.begin()+removeIndex);
+    EraseCandyEligibility(tmpInfo.outpoint);
     updatePage();
 }
 
@@ -702,20 +706,13 @@ void CandyPage::on_okButton_clicked()
 
 void CandyPage::updateCandyValue()
 {
-    char amountStr[64] = "";
-#ifdef WIN32
-    snprintf(amountStr,sizeof(amountStr),"%lld",currAssetTotalAmount);
-#else
-    snprintf(amountStr,sizeof(amountStr),"%ld",currAssetTotalAmount);
-#endif
-    string multiStr = mulstring(amountStr,QString::number(ui->candyRatioSlider->value()).toStdString());
-    int addDecimal = 3;//10% is 1,slider max 100 is 2,total 3
-    int totalDecimal = currAssetDecimal+addDecimal;
-    int size = multiStr.size();
-    if( size <= totalDecimal)
-        multiStr = "0" + multiStr;
-    string resultStr = numtofloatstring(multiStr,totalDecimal);
-    ui->candyValueLabel->setText(QString::fromStdString(resultStr.substr(0,resultStr.size()-addDecimal)));
+    // slider value is in 1/1000 of the total amount, 100 is 10%
+    CAssetAmount candyAmount(currAssetTotalAmount);
+    if(!candyAmount.Mul(ui->candyRatioSlider->value()) || !candyAmount.Div(1000)){
+        ui->candyValueLabel->setText("");
+        return;
+    }
+    ui->candyValueLabel->setText(QString::fromStdString(candyAmount.ToString(currAssetDecimal)));
     ui->candyValueLabel->setVisible(true);
 }
 
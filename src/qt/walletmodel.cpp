@@ -67,6 +67,7 @@ WalletModel::WalletModel(const PlatformStyle *platformStyle, CWallet *wallet, Op
     cachedWatchUnconfBalance(0),
     cachedWatchImmatureBalance(0),
     cachedWatchLockedBalance(0),
+    cachedWalletGeneration(0),
     cachedEncryptionStatus(Unencrypted),
     cachedNumBlocks(0),
     cachedTxLocks(0),
@@ -271,42 +272,18 @@ void WalletModel::pollBalanceChanged(bool checkIncrease)
 
 void WalletModel::checkBalanceChanged(bool checkIncrease)
 {
-    if(!wallet->mapWallet_tmp.empty())
-    {
-        wallet->mapWallet_tmp.clear();
-        std::map<uint256, CWalletTx>().swap(wallet->mapWallet_tmp);
-    }
+    // The wallet generation only moves when a transaction changed,
+    // so periodic checks have nothing to recompute while it stays the same
+    unsigned int nGeneration = wallet->GetWalletGeneration();
+    if(checkIncrease && nGeneration == cachedWalletGeneration)
+        return;
+    cachedWalletGeneration = nGeneration;
 
-    {
-        LOCK2(cs_main, wallet->cs_wallet);
-        for (std::map<uint256, CWalletTx>::const_iterator it = wallet->mapWallet.begin(); it != wallet->mapWallet.end(); ++it)
-        {
-            if(wallet->mapWallet_bk.count((*it).first)==0)
-            {
-                wallet->mapWallet_bk[(*it).first] = 1;
-                wallet->mapWallet_tmp[(*it).first] = (*it).second;
-            }
-        }
-    }
-
-    if(checkIncrease)
-    {
-        //no update,return
-        if(wallet->mapWallet_tmp.empty())
-            return;
-    }
-    CAmount newLockedBalance = 0;
-    CAmount newWatchLockedBalance = 0;
-    newLockedBalance = getLockedBalance(false,NULL,NULL,!checkIncrease);
-    newWatchLockedBalance = getWatchLockedBalance(false,NULL,NULL,!checkIncrease);
-    if(checkIncrease)
-    {
-        if(0 != newLockedBalance || 0 != newWatchLockedBalance)
-            wallet->MarkDirty();
-    }else if(cachedLockedBalance !=newLockedBalance || cachedWatchLockedBalance != newWatchLockedBalance)
-    {
+    CAmount newLockedBalance = getLockedBalance(false,NULL,NULL,!checkIncrease);
+    CAmount newWatchLockedBalance = getWatchLockedBalance(false,NULL,NULL,!checkIncrease);
+    if(cachedLockedBalance != newLockedBalance || cachedWatchLockedBalance != newWatchLockedBalance)
         wallet->MarkDirty();
-    }
+
     CAmount newBalance = getBalance(NULL,false,NULL,NULL,!checkIncrease);
     CAmount newUnconfirmedBalance = getUnconfirmedBalance(false,NULL,NULL,!checkIncrease);
     CAmount newImmatureBalance = getImmatureBalance(false,NULL,NULL,!checkIncrease);
@@ -323,44 +300,22 @@ void WalletModel::checkBalanceChanged(bool checkIncrease)
         newWatchImmatureBalance = getWatchImmatureBalance();
     }
 
-    if(checkIncrease)
+    if(cachedBalance != newBalance || cachedUnconfirmedBalance != newUnconfirmedBalance || cachedImmatureBalance != newImmatureBalance || cachedLockedBalance != newLockedBalance ||
+        cachedAnonymizedBalance != newAnonymizedBalance || cachedTxLocks != nCompleteTXLocks ||
+        cachedWatchOnlyBalance != newWatchOnlyBalance || cachedWatchUnconfBalance != newWatchUnconfBalance || cachedWatchImmatureBalance != newWatchImmatureBalance || cachedWatchLockedBalance != newWatchLockedBalance)
     {
-        if(0 != newBalance || 0 != newUnconfirmedBalance || 0 != newImmatureBalance || 0 != newLockedBalance ||
-            0 != newAnonymizedBalance || 0 != nCompleteTXLocks ||
-            0 != newWatchOnlyBalance || 0 != newWatchUnconfBalance || 0 != newWatchImmatureBalance || 0 != newWatchLockedBalance)
-        {
-            cachedBalance += newBalance;
-            cachedUnconfirmedBalance += newUnconfirmedBalance;
-            cachedImmatureBalance += newImmatureBalance;
-            cachedLockedBalance += newLockedBalance;
-            cachedAnonymizedBalance += newAnonymizedBalance;
-            cachedTxLocks += nCompleteTXLocks;
-            cachedWatchOnlyBalance += newWatchOnlyBalance;
-            cachedWatchUnconfBalance += newWatchUnconfBalance;
-            cachedWatchImmatureBalance += newWatchImmatureBalance;
-            cachedWatchLockedBalance += newWatchLockedBalance;
-            Q_EMIT balanceChanged(cachedBalance, cachedUnconfirmedBalance, cachedImmatureBalance, cachedLockedBalance, cachedAnonymizedBalance,
-                                cachedWatchOnlyBalance, cachedWatchUnconfBalance, cachedWatchImmatureBalance, cachedWatchLockedBalance);
-        }
-    }else
-    {
-        if(cachedBalance != newBalance || cachedUnconfirmedBalance != newUnconfirmedBalance || cachedImmatureBalance != newImmatureBalance || cachedLockedBalance != newLockedBalance ||
-            cachedAnonymizedBalance != newAnonymizedBalance || cachedTxLocks != nCompleteTXLocks ||
-            cachedWatchOnlyBalance != newWatchOnlyBalance || cachedWatchUnconfBalance != newWatchUnconfBalance || cachedWatchImmatureBalance != newWatchImmatureBalance || cachedWatchLockedBalance != newWatchLockedBalance)
-        {
-            cachedBalance = newBalance;
-            cachedUnconfirmedBalance = newUnconfirmedBalance;
-            cachedImmatureBalance = newImmatureBalance;
-            cachedLockedBalance = newLockedBalance;
-            cachedAnonymizedBalance = newAnonymizedBalance;
-            cachedTxLocks = nCompleteTXLocks;
-            cachedWatchOnlyBalance = newWatchOnlyBalance;
-            cachedWatchUnconfBalance = newWatchUnconfBalance;
-            cachedWatchImmatureBalance = newWatchImmatureBalance;
-            cachedWatchLockedBalance = newWatchLockedBalance;
-            Q_EMIT balanceChanged(newBalance, newUnconfirmedBalance, newImmatureBalance, newLockedBalance, newAnonymizedBalance,
-                                newWatchOnlyBalance, newWatchUnconfBalance, newWatchImmatureBalance, newWatchLockedBalance);
-        }
+        cachedBalance = newBalance;
+        cachedUnconfirmedBalance = newUnconfirmedBalance;
+        cachedImmatureBalance = newImmatureBalance;
+        cachedLockedBalance = newLockedBalance;
+        cachedAnonymizedBalance = newAnonymizedBalance;
+        cachedTxLocks = nCompleteTXLocks;
+        cachedWatchOnlyBalance = newWatchOnlyBalance;
+        cachedWatchUnconfBalance = newWatchUnconfBalance;
+        cachedWatchImmatureBalance = newWatchImmatureBalance;
+        cachedWatchLockedBalance = newWatchLockedBalance;
+        Q_EMIT balanceChanged(newBalance, newUnconfirmedBalance, newImmatureBalance, newLockedBalance, newAnonymizedBalance,
+                            newWatchOnlyBalance, newWatchUnconfBalance, newWatchImmatureBalance, newWatchLockedBalance);
     }
 }
 
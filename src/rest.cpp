@@ -3,8 +3,11 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include "app/app.h"
+#include "base58.h"
 #include "chain.h"
 #include "chainparams.h"
+#include "main.h"
 #include "primitives/block.h"
 #include "primitives/transaction.h"
 #include "validation.h"
@@ -24,6 +27,10 @@
 using namespace std;
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
+static const unsigned int DEFAULT_REST_TXIDS = 100;
+static const unsigned int MAX_REST_TXIDS = 1000;
+static const int REST_CACHE_MIN_DEPTH = 6; //confirmations after which asset and app data is served as immutable
+static const int REST_CACHE_MAX_AGE = 86400;
 
 enum RetFormat {
     RF_UNDEF,
@@ -118,6 +125,58 @@ static bool ParseHashStr(const string& strReq, uint256& v)
     return true;
 }
 
+static bool ParseOutPointStr(const string& strReq, COutPoint& out)
+{
+    const std::string::size_type pos = strReq.find('-');
+    int32_t nOutput;
+    uint256 txid;
+    if (pos == std::string::npos || !ParseHashStr(strReq.substr(0, pos), txid) || !ParseInt32(strReq.substr(pos + 1), &nOutput) || nOutput < 0)
+        return false;
+
+    out = COutPoint(txid, (uint32_t)nOutput);
+    return true;
+}
+
+/** Let proxies keep a reply about data confirmed at nHeight once a reorg is unlikely to change it */
+static void SetCacheHeader(HTTPRequest* req, const int& nHeight)
+{
+    if (nHeight >= 0 && g_nChainHeight - nHeight + 1 >= REST_CACHE_MIN_DEPTH)
+        req->WriteHeader("Cache-Control", strprintf("public, max-age=%d", REST_CACHE_MAX_AGE));
+    else
+        req->WriteHeader("Cache-Control", "no-cache");
+}
+
+/** Reply with ss for .bin and .hex, and with json for .json */
+static bool WriteDataReply(HTTPRequest* req, const RetFormat rf, const CDataStream& ss, const UniValue& json)
+{
+    switch (rf) {
+    case RF_BINARY: {
+        string binaryData = ss.str();
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, binaryData);
+        return true;
+    }
+
+    case RF_HEX: {
+        string strHex = HexStr(ss.begin(), ss.end()) + "\n";
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, strHex);
+        return true;
+    }
+
+    case RF_JSON: {
+        string strJSON = json.write() + "\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, strJSON);
+        return true;
+    }
+
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
 static bool CheckWarmup(HTTPRequest* req)
 {
     std::string statusmessage;
@@ -601,6 +660,271 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
     return true; // continue to process further HTTP reqs on this cxn
 }
 
+// The asset, app and candy handlers read the block tree indexes, which are
+// written in one batch per block, so none of them takes cs_main.
+
+static bool rest_asset(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string hashStr;
+    const RetFormat rf = ParseDataFormat(hashStr, strURIPart);
+
+    uint256 assetId;
+    if (!ParseHashStr(hashStr, assetId))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid asset id: " + hashStr);
+
+    // the mempool also knows assets issued by unconfirmed transactions, which have no height yet
+    CAssetId_AssetInfo_IndexValue assetInfo;
+    const bool fConfirmed = !assetId.IsNull() && GetAssetInfoByAssetId(assetId, assetInfo, false);
+    if (!fConfirmed && (assetId.IsNull() || !GetAssetInfoByAssetId(assetId, assetInfo)))
+        return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+
+    CDataStream ssAsset(SER_NETWORK, PROTOCOL_VERSION);
+    ssAsset << assetInfo;
+
+    const CAssetData& assetData = assetInfo.assetData;
+    UniValue objAsset(UniValue::VOBJ);
+    if (rf == RF_JSON) {
+        objAsset.push_back(Pair("assetId", assetId.GetHex()));
+        objAsset.push_back(Pair("assetShortName", assetData.strShortName));
+        objAsset.push_back(Pair("assetName", assetData.strAssetName));
+        objAsset.push_back(Pair("assetDesc", assetData.strAssetDesc));
+        objAsset.push_back(Pair("assetUnit", assetData.strAssetUnit));
+        objAsset.push_back(Pair("assetTotalAmount", StrValueFromAmount(assetData.nTotalAmount, assetData.nDecimals)));
+        objAsset.push_back(Pair("firstIssueAmount", StrValueFromAmount(assetData.nFirstIssueAmount, assetData.nDecimals)));
+        objAsset.push_back(Pair("firstActualAmount", StrValueFromAmount(assetData.nFirstActualAmount, assetData.nDecimals)));
+        objAsset.push_back(Pair("assetDecimals", assetData.nDecimals));
+        objAsset.push_back(Pair("isDestory", assetData.bDestory));
+        objAsset.push_back(Pair("isPayCandy", assetData.bPayCandy));
+        objAsset.push_back(Pair("candyTotalAmount", StrValueFromAmount(assetData.nCandyAmount, assetData.nDecimals)));
+        objAsset.push_back(Pair("candyExpired", assetData.nCandyExpired));
+        objAsset.push_back(Pair("remarks", assetData.strRemarks));
+        objAsset.push_back(Pair("adminSafeAddress", assetInfo.strAdminAddress));
+        objAsset.push_back(Pair("height", assetInfo.nHeight));
+    }
+
+    // the asset info is only written when the asset is issued
+    SetCacheHeader(req, fConfirmed ? assetInfo.nHeight : -1);
+    return WriteDataReply(req, rf, ssAsset, objAsset);
+}
+
+static bool rest_assettxs(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    vector<string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+
+    if (path.size() > 3)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid request. Use /rest/assettxs/<assetId>[/<count>[/<cursor>]].<ext>.");
+
+    uint256 assetId;
+    if (!ParseHashStr(path[0], assetId))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid asset id: " + path[0]);
+
+    long count = DEFAULT_REST_TXIDS;
+    if (path.size() > 1) {
+        count = strtol(path[1].c_str(), NULL, 10);
+        if (count < 1 || count > (long)MAX_REST_TXIDS)
+            return RESTERR(req, HTTP_BAD_REQUEST, "Transaction count out of range: " + path[1]);
+    }
+
+    CTxIdCursor cursor;
+    if (path.size() > 2 && !CTxIdCursor::Parse(path[2], cursor))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid cursor: " + path[2]);
+
+    CTxIdPage page(cursor, count);
+    std::vector<uint256> vTxId;
+    CTxIdCursor cursorNext;
+    if (GetTxIdsByAssetIdTxClass(assetId, "", (uint8_t)ALL_TXOUT, page))
+        page.Get(vTxId, cursorNext);
+    if (vTxId.empty() && page.IsFirst())
+        return RESTERR(req, HTTP_NOT_FOUND, path[0] + " not found");
+
+    CDataStream ssTxIds(SER_NETWORK, PROTOCOL_VERSION);
+    ssTxIds << vTxId << (cursorNext.IsNull() ? std::string() : cursorNext.ToString());
+
+    UniValue objTxIds(UniValue::VOBJ);
+    if (rf == RF_JSON)
+        PushTxIdPage(vTxId, cursorNext, objTxIds);
+
+    // a full page only changes when the block of its last transaction is reorganised away
+    SetCacheHeader(req, cursorNext.IsNull() ? -1 : cursorNext.nHeight);
+    return WriteDataReply(req, rf, ssTxIds, objTxIds);
+}
+
+struct CRESTAssetBalance {
+    uint256 assetId;
+    CAssetAmount nReceived;
+    CAssetAmount nSent;
+    CAssetAmount nLocked;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
+    {
+        READWRITE(assetId);
+        READWRITE(nReceived);
+        READWRITE(nSent);
+        READWRITE(nLocked);
+    }
+};
+
+static bool rest_address(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    vector<string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+
+    if (path.size() != 2 || path[1] != "assets")
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid request. Use /rest/address/<address>/assets.<ext>.");
+
+    const std::string& strAddress = path[0];
+    if (!CBitcoinAddress(strAddress).IsValid())
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid address: " + strAddress);
+
+    std::vector<uint256> vAssetId;
+    GetAssetIdByAddress(strAddress, vAssetId);
+
+    // confirmed balances are only known with the address asset balance index
+    std::vector<CRESTAssetBalance> vBalance;
+    BOOST_FOREACH(const uint256& assetId, vAssetId) {
+        CRESTAssetBalance balance;
+        balance.assetId = assetId;
+        if (!GetAddressAssetBalance(strAddress, assetId, balance.nReceived, balance.nSent, balance.nLocked)) {
+            vBalance.clear();
+            break;
+        }
+        vBalance.push_back(balance);
+    }
+
+    CDataStream ssAssets(SER_NETWORK, PROTOCOL_VERSION);
+    ssAssets << vAssetId << vBalance;
+
+    UniValue objAssets(UniValue::VOBJ);
+    if (rf == RF_JSON) {
+        UniValue assets(UniValue::VARR);
+        for (unsigned int i = 0; i < vAssetId.size(); i++) {
+            UniValue asset(UniValue::VOBJ);
+            asset.push_back(Pair("assetId", vAssetId[i].GetHex()));
+            CAssetId_AssetInfo_IndexValue assetInfo;
+            if (i < vBalance.size() && GetAssetInfoByAssetId(vAssetId[i], assetInfo)) {
+                const uint8_t& nDecimals = assetInfo.assetData.nDecimals;
+                CAssetAmount nBalance = vBalance[i].nReceived;
+                nBalance.Sub(vBalance[i].nSent);
+                asset.push_back(Pair("assetShortName", assetInfo.assetData.strShortName));
+                asset.push_back(Pair("ReceiveAmount", StrValueFromAssetAmount(vBalance[i].nReceived, nDecimals)));
+                asset.push_back(Pair("SendAmount", StrValueFromAssetAmount(vBalance[i].nSent, nDecimals)));
+                asset.push_back(Pair("totalAmount", StrValueFromAssetAmount(nBalance, nDecimals)));
+                asset.push_back(Pair("lockAmount", StrValueFromAssetAmount(vBalance[i].nLocked, nDecimals)));
+            }
+            assets.push_back(asset);
+        }
+        objAssets.push_back(Pair("address", strAddress));
+        objAssets.push_back(Pair("assets", assets));
+    }
+
+    SetCacheHeader(req, -1);
+    return WriteDataReply(req, rf, ssAssets, objAssets);
+}
+
+static bool rest_app(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string hashStr;
+    const RetFormat rf = ParseDataFormat(hashStr, strURIPart);
+
+    uint256 appId;
+    if (!ParseHashStr(hashStr, appId))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid app id: " + hashStr);
+
+    // the mempool also knows apps registered by unconfirmed transactions, which have no height yet
+    CAppId_AppInfo_IndexValue appInfo;
+    const bool fConfirmed = !appId.IsNull() && GetAppInfoByAppId(appId, appInfo, false);
+    if (!fConfirmed && (appId.IsNull() || !GetAppInfoByAppId(appId, appInfo)))
+        return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+
+    CDataStream ssApp(SER_NETWORK, PROTOCOL_VERSION);
+    ssApp << appInfo;
+
+    UniValue objApp(UniValue::VOBJ);
+    if (rf == RF_JSON) {
+        objApp.push_back(Pair("appId", appId.GetHex()));
+        objApp.push_back(Pair("appName", appInfo.appData.strAppName));
+        objApp.push_back(Pair("appDesc", appInfo.appData.strAppDesc));
+        objApp.push_back(Pair("devType", appInfo.appData.nDevType));
+        objApp.push_back(Pair("devName", appInfo.appData.strDevName));
+        objApp.push_back(Pair("webUrl", appInfo.appData.strWebUrl));
+        objApp.push_back(Pair("appLogoUrl", appInfo.appData.strLogoUrl));
+        objApp.push_back(Pair("appCoverUrl", appInfo.appData.strCoverUrl));
+        objApp.push_back(Pair("adminSafeAddress", appInfo.strAdminAddress));
+        objApp.push_back(Pair("height", appInfo.nHeight));
+    }
+
+    // the app info is only written when the app is registered
+    SetCacheHeader(req, fConfirmed ? appInfo.nHeight : -1);
+    return WriteDataReply(req, rf, ssApp, objApp);
+}
+
+static bool rest_candy(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string outStr;
+    const RetFormat rf = ParseDataFormat(outStr, strURIPart);
+
+    COutPoint out;
+    if (!ParseOutPointStr(outStr, out))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid outpoint: " + outStr + ". Use /rest/candy/<txid>-<n>.<ext>.");
+
+    CTransaction tx;
+    uint256 hashBlock;
+    if (!GetTransaction(out.hash, tx, Params().GetConsensus(), hashBlock, true) || out.n >= tx.vout.size())
+        return RESTERR(req, HTTP_NOT_FOUND, outStr + " not found");
+
+    uint32_t nAppCmd = 0;
+    CAppPayloadRef payload = GetAppPayload(tx.vout[out.n].vReserve);
+    if (!tx.vout[out.n].IsAsset(&nAppCmd) || nAppCmd != PUT_CANDY_CMD || !payload || !payload->fBody)
+        return RESTERR(req, HTTP_NOT_FOUND, outStr + " is not a candy output");
+
+    const uint256& assetId = payload->assetId;
+    CCandyInfo candyInfo;
+    CAmount nGotAmount = 0, nMempoolGotAmount = 0;
+    if (!GetAssetIdCandyInfo(assetId, out, candyInfo) || !GetGetCandyTotalAmount(assetId, out, nGotAmount, nMempoolGotAmount))
+        return RESTERR(req, HTTP_NOT_FOUND, outStr + " not found");
+
+    CDataStream ssCandy(SER_NETWORK, PROTOCOL_VERSION);
+    ssCandy << assetId << candyInfo << nGotAmount << nMempoolGotAmount;
+
+    UniValue objCandy(UniValue::VOBJ);
+    if (rf == RF_JSON) {
+        uint8_t nDecimals = 8;
+        CAssetId_AssetInfo_IndexValue assetInfo;
+        if (GetAssetInfoByAssetId(assetId, assetInfo))
+            nDecimals = assetInfo.assetData.nDecimals;
+
+        objCandy.push_back(Pair("txid", out.hash.GetHex()));
+        objCandy.push_back(Pair("vout", (int)out.n));
+        objCandy.push_back(Pair("assetId", assetId.GetHex()));
+        objCandy.push_back(Pair("candyAmount", StrValueFromAmount(candyInfo.nAmount, nDecimals)));
+        objCandy.push_back(Pair("candyExpired", candyInfo.nExpired));
+        objCandy.push_back(Pair("gotAmount", StrValueFromAmount(nGotAmount, nDecimals)));
+        objCandy.push_back(Pair("mempoolGotAmount", StrValueFromAmount(nMempoolGotAmount, nDecimals)));
+    }
+
+    // the amount got changes with every get candy transaction
+    SetCacheHeader(req, -1);
+    return WriteDataReply(req, rf, ssCandy, objCandy);
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(HTTPRequest* req, const std::string& strReq);
@@ -613,6 +937,11 @@ static const struct {
       {"/rest/mempool/contents", rest_mempool_contents},
       {"/rest/headers/", rest_headers},
       {"/rest/getutxos", rest_getutxos},
+      {"/rest/asset/", rest_asset},
+      {"/rest/assettxs/", rest_assettxs},
+      {"/rest/address/", rest_address},
+      {"/rest/app/", rest_app},
+      {"/rest/candy/", rest_candy},
 };
 
 bool StartREST()
@@ -157,16 +157,21 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "putcandy", 1},
     { "putcandy", 2},
     { "getassetidtxids", 1},
+    { "getassetidtxids", 2},
     { "getaddrassettxids", 2},
+    { "getaddrassettxids", 3},
     { "getaddrassetbalance", 2},
     { "getaddressapptxids", 2},
     { "getaddressapptxids", 3},
+    { "getaddressapptxids", 4},
     { "getapptxids", 1},
     { "getapptxids", 2},
+    { "getapptxids", 3},
     { "getaddressamountbyheight", 0},
     { "sendmanywithlock", 0},
     { "transfermanyasset", 1},
     { "getassetlocaltxlist", 1},
+    { "getassetlocaltxlist", 2},
 };
 
 class CRPCConvertTable
@@ -286,6 +286,48 @@ UniValue getmininginfo(const UniValue& params, bool fHelp)
     return obj;
 }
 
+UniValue getsposstats(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+            "getsposstats\n"
+            "\nReturns scheduling statistics of the SPOS miner of this masternode, times are in milliseconds."
+            "\nResult:\n"
+            "{\n"
+            "  \"wakeups\": n,            (numeric) Times the miner looked at the slot schedule\n"
+            "  \"eventwakeups\": n,       (numeric) Wakeups caused by a new tip or masternode list\n"
+            "  \"templates\": n,          (numeric) Block templates created\n"
+            "  \"preparedblocks\": n,     (numeric) Blocks assembled ahead of a local slot\n"
+            "  \"slots\": n,              (numeric) Local slots a block was submitted for\n"
+            "  \"preparedslots\": n,      (numeric) Local slots served by a prepared block\n"
+            "  \"missedslots\": n,        (numeric) Local slots whose window had passed on wakeup\n"
+            "  \"lastjitter\": n,         (numeric) Delay between the start of the last local slot and its block submission\n"
+            "  \"maxjitter\": n,          (numeric) Largest slot start delay\n"
+            "  \"avgjitter\": n,          (numeric) Average slot start delay\n"
+            "  \"nextwaketime\": n        (numeric) When the miner wakes next, in milliseconds since epoch\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getsposstats", "")
+            + HelpExampleRpc("getsposstats", "")
+        );
+
+    CSposMinerStats stats;
+    GetSposMinerStats(stats);
+
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("wakeups",        stats.nWakeups));
+    obj.push_back(Pair("eventwakeups",   stats.nEventWakeups));
+    obj.push_back(Pair("templates",      stats.nTemplates));
+    obj.push_back(Pair("preparedblocks", stats.nPreparedBlocks));
+    obj.push_back(Pair("slots",          stats.nSlots));
+    obj.push_back(Pair("preparedslots",  stats.nPreparedSlots));
+    obj.push_back(Pair("missedslots",    stats.nMissedSlots));
+    obj.push_back(Pair("lastjitter",     stats.nLastJitter));
+    obj.push_back(Pair("maxjitter",      stats.nMaxJitter));
+    obj.push_back(Pair("avgjitter",      stats.nSlots > 0 ? stats.nTotalJitter / stats.nSlots : 0));
+    obj.push_back(Pair("nextwaketime",   stats.nNextWakeTime));
+    return obj;
+}
 
 // NOTE: Unlike wallet RPC (which use SAFE values), mining RPCs follow GBT (BIP 22) in using satoshi amounts
 UniValue prioritisetransaction(const UniValue& params, bool fHelp)
@@ -293,12 +335,11 @@ UniValue prioritisetransaction(const UniValue& params, bool fHelp)
     if (fHelp || params.size() != 3)
         throw runtime_error(
             "prioritisetransaction <txid> <priority delta> <fee delta>\n"
-            "Accepts the transaction into mined blocks at a higher (or lower) priority\n"
+            "Accepts the transaction into mined blocks at a higher (or lower) fee\n"
             "\nArguments:\n"
             "1. \"txid\"       (string, required) The transaction id.\n"
-            "2. priority delta (numeric, required) The priority to add or subtract.\n"
-            "                  The transaction selection algorithm considers the tx as it would have a higher priority.\n"
-            "                  (priority of a transaction is calculated: coinage * value_in_duffs / txsize) \n"
+            "2. priority delta (numeric, required) Ignored, blocks are filled by ancestor fee rate only.\n"
+            "                  Kept for compatibility, pass 0.\n"
             "3. fee delta      (numeric, required) The fee value (in duffs) to add (or subtract, if negative).\n"
             "                  The fee is not actually paid, only the algorithm for selecting transactions into a block\n"
             "                  considers the transaction as it would have paid a higher (or lower) fee.\n"
@@ -198,6 +198,11 @@ UniValue StrValueFromAmount(const CAmount& amount, const uint8_t& nDecimals)
     return UniValue(UniValue::VSTR, strprintf("%s%lld.%08lld", sign ? "-" : "", quotient, remainder));
 }
 
+UniValue StrValueFromAssetAmount(const CAssetAmount& amount, const uint8_t& nDecimals)
+{
+    return UniValue(UniValue::VSTR, amount.ToString(nDecimals));
+}
+
 
 uint256 ParseHashV(const UniValue& v, string strName)
 {
@@ -370,6 +375,7 @@ static const CRPCCommand vRPCCommands[] =
     { "mining",             "getblocktemplate",       &getblocktemplate,            true  },
     { "mining",             "getmininginfo",          &getmininginfo,               true  },
     { "mining",             "getnetworkhashps",       &getnetworkhashps,            true  },
+    { "mining",             "getsposstats",           &getsposstats,                true  },
     { "mining",             "prioritisetransaction",  &prioritisetransaction,       true  },
     { "mining",             "submitblock",            &submitblock,                 true  },
 
@@ -449,6 +455,7 @@ static const CRPCCommand vRPCCommands[] =
     { "wallet",             "abandontransaction",     &abandontransaction,          false },
     { "wallet",             "getunconfirmedbalance",  &getunconfirmedbalance,       false },
     { "wallet",             "getlockedtxinfo",        &getlockedtxinfo,             false },
+    { "wallet",             "getrescaninfo",          &getrescaninfo,               true  },
     { "wallet",             "getwalletinfo",          &getwalletinfo,               false },
     { "wallet",             "importprivkey",          &importprivkey,               true  },
     { "wallet",             "importwallet",           &importwallet,                true  },
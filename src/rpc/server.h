@@ -31,6 +31,8 @@ namespace RPCServer
 
 class CBlockIndex;
 class CNetAddr;
+class CTxIdPage;
+struct CTxIdCursor;
 
 class JSONRequest
 {
@@ -165,6 +167,7 @@ extern int64_t nWalletUnlockTime;
 extern CAmount AmountFromValue(const UniValue& value, const uint8_t& nDecimals = 8, const bool fAsset = false);
 extern UniValue ValueFromAmount(const CAmount& amount, const uint8_t& nDecimals = 8);
 extern UniValue StrValueFromAmount(const CAmount& amount, const uint8_t& nDecimals = 8);
+extern UniValue StrValueFromAssetAmount(const CAssetAmount& amount, const uint8_t& nDecimals = 8);
 
 extern double GetDifficulty(const CBlockIndex* blockindex = NULL);
 extern std::string HelpRequiringPassphrase();
@@ -205,6 +208,7 @@ extern UniValue setgenerate(const UniValue& params, bool fHelp);
 extern UniValue generate(const UniValue& params, bool fHelp);
 extern UniValue getnetworkhashps(const UniValue& params, bool fHelp);
 extern UniValue getmininginfo(const UniValue& params, bool fHelp);
+extern UniValue getsposstats(const UniValue& params, bool fHelp);
 extern UniValue prioritisetransaction(const UniValue& params, bool fHelp);
 extern UniValue getblocktemplate(const UniValue& params, bool fHelp);
 extern UniValue submitblock(const UniValue& params, bool fHelp);
@@ -254,6 +258,7 @@ extern UniValue getinfo(const UniValue& params, bool fHelp);
 extern UniValue debug(const UniValue& params, bool fHelp);
 extern UniValue getlockedtxinfo(const UniValue& params, bool fHelp);
 extern UniValue getwalletinfo(const UniValue& params, bool fHelp);
+extern UniValue getrescaninfo(const UniValue& params, bool fHelp);
 extern UniValue getblockchaininfo(const UniValue& params, bool fHelp);
 extern UniValue getnetworkinfo(const UniValue& params, bool fHelp);
 extern UniValue setmocktime(const UniValue& params, bool fHelp);
@@ -341,6 +346,10 @@ extern UniValue getlocalassetlist(const UniValue& params, bool fHelp);
 extern UniValue transfermanyasset(const UniValue& params, bool fHelp);
 extern UniValue getassetlocaltxlist(const UniValue& params, bool fHelp);
 
+/** Paged txid lists of the app and asset rpcs: count and cursor parameters from nIndex on, and the result */
+extern void ParseTxIdPage(const UniValue& params, const unsigned int& nIndex, CTxIdPage& page);
+extern void PushTxIdPage(const std::vector<uint256>& vTxId, const CTxIdCursor& cursorNext, UniValue& ret);
+
 
 
 bool StartRPC();
@@ -0,0 +1,74 @@
+// Copyright (c) 2018-2019 The Safe Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "amount.h"
+
+#include "test/test_safe.h"
+
+#include <limits>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(amount_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(assetamount_arithmetic)
+{
+    CAssetAmount amount;
+    for (int i = 0; i < 100; i++)
+        BOOST_CHECK(amount.Add(MAX_ASSETS));
+    BOOST_CHECK_EQUAL(amount.ToString(0), "200000000000000000000");
+    BOOST_CHECK(amount > CAssetAmount(MAX_ASSETS));
+
+    CAmount nAmount = 0;
+    BOOST_CHECK(!amount.GetAmount(nAmount));
+    BOOST_CHECK(amount.Div(100));
+    BOOST_CHECK(amount.GetAmount(nAmount));
+    BOOST_CHECK_EQUAL(nAmount, MAX_ASSETS);
+
+    BOOST_CHECK(amount.Sub(CAssetAmount(MAX_ASSETS)));
+    BOOST_CHECK(amount == CAssetAmount());
+    BOOST_CHECK(amount.Sub(5));
+    BOOST_CHECK(amount < CAssetAmount());
+    BOOST_CHECK_EQUAL(amount.ToString(2), "-0.05");
+    BOOST_CHECK(amount.Mul(-3));
+    BOOST_CHECK_EQUAL(amount.ToString(2), "0.15");
+    BOOST_CHECK(amount.Div(-2));
+    BOOST_CHECK_EQUAL(amount.ToString(0), "-7");
+
+    // overflow leaves the value unchanged
+    CAssetAmount big(std::numeric_limits<CAmount>::max());
+    BOOST_CHECK(big.Mul(std::numeric_limits<CAmount>::max()));
+    BOOST_CHECK(!big.Mul(4));
+    BOOST_CHECK_EQUAL(big.ToString(0), "85070591730234615847396907784232501249");
+    BOOST_CHECK(big.Add(big));
+    BOOST_CHECK(!big.Add(big));
+    BOOST_CHECK(!big.Div(0));
+}
+
+BOOST_AUTO_TEST_CASE(assetamount_string)
+{
+    BOOST_CHECK_EQUAL(CAssetAmount().ToString(0), "0");
+    BOOST_CHECK_EQUAL(CAssetAmount().ToString(4), "0.0000");
+    BOOST_CHECK_EQUAL(CAssetAmount(123).ToString(5), "0.00123");
+    BOOST_CHECK_EQUAL(CAssetAmount(-123456).ToString(3), "-123.456");
+    BOOST_CHECK_EQUAL(CAssetAmount(std::numeric_limits<CAmount>::min()).ToString(0), "-9223372036854775808");
+
+    CAssetAmount amount;
+    BOOST_CHECK(CAssetAmount::Parse("12.345", 2, amount));
+    BOOST_CHECK(amount == CAssetAmount(1234));
+    BOOST_CHECK(CAssetAmount::Parse("-7", 3, amount));
+    BOOST_CHECK(amount == CAssetAmount(-7000));
+    BOOST_CHECK(CAssetAmount::Parse(".5", 1, amount));
+    BOOST_CHECK(amount == CAssetAmount(5));
+    BOOST_CHECK(CAssetAmount::Parse("200000000000000000000", 8, amount));
+    BOOST_CHECK_EQUAL(amount.ToString(8), "200000000000000000000.00000000");
+
+    BOOST_CHECK(!CAssetAmount::Parse("", 2, amount));
+    BOOST_CHECK(!CAssetAmount::Parse(".", 2, amount));
+    BOOST_CHECK(!CAssetAmount::Parse("1.2.3", 2, amount));
+    BOOST_CHECK(!CAssetAmount::Parse("1e5", 2, amount));
+    BOOST_CHECK(!CAssetAmount::Parse("1000000000000000000000000000000000000000", 0, amount));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
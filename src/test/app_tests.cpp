@@ -0,0 +1,190 @@
+// Copyright (c) 2018-2019 The Safe Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "app/app.h"
+#include "arith_uint256.h"
+#include "clientversion.h"
+#include "core_memusage.h"
+#include "primitives/transaction.h"
+#include "streams.h"
+#include "uint256.h"
+#include "validation.h"
+
+#include "test/test_safe.h"
+
+#include <algorithm>
+#include <climits>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(app_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(app_payload)
+{
+    uint256 appId = uint256S(g_strSafeAssetId);
+    uint256 assetId = uint256S("0x1234");
+
+    std::vector<unsigned char> vReserve = FillCommonData(CAppHeader(g_nAppHeaderVersion, appId, TRANSFER_ASSET_CMD), CCommonData(assetId, 500, "remarks"));
+    CAppPayloadRef payload = GetAppPayload(vReserve);
+    BOOST_REQUIRE(payload);
+    BOOST_CHECK(payload->fBody);
+    BOOST_CHECK(payload->IsAssetCmd());
+    BOOST_CHECK(payload->header.appId == appId);
+    BOOST_CHECK_EQUAL(payload->header.nAppCmd, (uint32_t)TRANSFER_ASSET_CMD);
+    BOOST_CHECK(payload->assetId == assetId);
+    BOOST_CHECK_EQUAL(payload->GetCommonData().nAmount, 500);
+    BOOST_CHECK_EQUAL(payload->GetCommonData().strRemarks, "remarks");
+    // only the body of the command is kept
+    BOOST_CHECK(payload->GetPutCandyData().assetId.IsNull());
+    BOOST_CHECK(payload->GetAssetData().strAssetName.empty());
+
+    // the same reserve is served from the cache
+    std::vector<unsigned char> vCopy(vReserve);
+    BOOST_CHECK(GetAppPayload(vCopy) == payload);
+
+    // the typed body is parsed the same way as ParseReserve and ParseCommonData
+    CAppHeader header;
+    std::vector<unsigned char> vData;
+    BOOST_REQUIRE(ParseReserve(vReserve, header, vData));
+    BOOST_CHECK(vData == payload->vData);
+
+    // plain safe txouts carry no payload
+    std::vector<unsigned char> vSafe;
+    vSafe.push_back('s');
+    vSafe.push_back('a');
+    vSafe.push_back('f');
+    vSafe.push_back('e');
+    BOOST_CHECK(!GetAppPayload(vSafe));
+
+    // a valid header with a garbage body still yields the header
+    std::vector<unsigned char> vBad = FillCommonData(CAppHeader(g_nAppHeaderVersion, appId, ADD_ASSET_CMD), CCommonData(assetId, 1, ""));
+    vBad.resize(TXOUT_RESERVE_MIN_SIZE + sizeof(uint16_t) + 32 + sizeof(uint32_t));
+    vBad.push_back(0xff);
+    vBad.push_back(0xff);
+    CAppPayloadRef bad = GetAppPayload(vBad);
+    BOOST_REQUIRE(bad);
+    BOOST_CHECK_EQUAL(bad->header.nAppCmd, (uint32_t)ADD_ASSET_CMD);
+    BOOST_CHECK(!bad->fBody);
+    BOOST_CHECK(bad->assetId.IsNull());
+}
+
+BOOST_AUTO_TEST_CASE(txout_reserve)
+{
+    // the default "safe" marker is stored inline
+    CTxOut txoutNull;
+    BOOST_CHECK_EQUAL(RecursiveDynamicUsage(txoutNull.vReserve), 0U);
+
+    for(unsigned int nSize = TXOUT_RESERVE_MIN_SIZE; nSize <= 300; nSize += 37)
+    {
+        std::vector<unsigned char> vReserve(nSize);
+        for(unsigned int i = 0; i < nSize; i++)
+            vReserve[i] = (unsigned char)(i * 7);
+
+        CTxOut txout(5 * COIN, CScript() << OP_TRUE, 100);
+        txout.vReserve = vReserve;
+        BOOST_CHECK_EQUAL(RecursiveDynamicUsage(txout.vReserve) == 0, nSize <= TXOUT_RESERVE_INLINE_SIZE);
+
+        // same wire format as the former std::vector member
+        CDataStream ssExpected(SER_NETWORK, SAFE_TX_VERSION_1);
+        ssExpected << txout.nValue << *(CScriptBase*)(&txout.scriptPubKey) << txout.nUnlockedHeight << vReserve;
+        CDataStream ss(SER_NETWORK, SAFE_TX_VERSION_1);
+        ss << txout;
+        BOOST_CHECK(std::string(ss.begin(), ss.end()) == std::string(ssExpected.begin(), ssExpected.end()));
+
+        CTxOut txoutRead;
+        ss >> txoutRead;
+        BOOST_CHECK(txoutRead == txout);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(txid_page)
+{
+    std::vector<uint256> vAll;
+    for(int i = 0; i < 10; i++)
+        vAll.push_back(ArithToUint256(arith_uint256(i + 1)));
+
+    // every txid is added twice, as for a transaction with two indexed outputs
+    CTxIdCursor cursor;
+    std::vector<uint256> vPaged;
+    for(int nPage = 0; nPage < 10; nPage++)
+    {
+        CTxIdPage page(cursor, 3);
+        for(int i = 9; i >= 0; i--)
+        {
+            page.Add(100 + i / 2, vAll[i]);
+            page.Add(100 + i / 2, vAll[i]);
+        }
+
+        std::vector<uint256> vTxId;
+        page.Get(vTxId, cursor);
+        BOOST_CHECK(vTxId.size() <= 3);
+        vPaged.insert(vPaged.end(), vTxId.begin(), vTxId.end());
+        if(cursor.IsNull())
+            break;
+
+        CTxIdCursor parsed;
+        BOOST_REQUIRE(CTxIdCursor::Parse(cursor.ToString(), parsed));
+        BOOST_CHECK(!(parsed < cursor) && !(cursor < parsed));
+    }
+    BOOST_CHECK(vPaged == vAll);
+
+    // a filter drops txids before they take a place in the page, it is called
+    // once per txid and not for txids that can no longer make the page
+    CTxIdPage page(CTxIdCursor(), 2);
+    int nFilterCalls = 0;
+    page.fnFilter = [&vAll, &nFilterCalls](const uint256& txid) { nFilterCalls++; return txid != vAll[0]; };
+    for(int i = 0; i < 10; i++)
+    {
+        page.Add(100, vAll[i]);
+        page.Add(100, vAll[i]);
+    }
+    BOOST_CHECK_EQUAL(nFilterCalls, 4);
+    std::vector<uint256> vTxId;
+    page.Get(vTxId, cursor);
+    BOOST_REQUIRE_EQUAL(vTxId.size(), 2U);
+    BOOST_CHECK(vTxId[0] == vAll[1]);
+    BOOST_CHECK(vTxId[1] == vAll[2]);
+    BOOST_CHECK(!cursor.IsNull());
+
+    // rejected txids still tell an unknown app from one without matching txids
+    CTxIdPage pageRejected;
+    pageRejected.fnFilter = [](const uint256& txid) { return false; };
+    BOOST_CHECK(pageRejected.IsEmpty());
+    pageRejected.Add(100, vAll[0]);
+    vTxId.clear();
+    pageRejected.Get(vTxId, cursor);
+    BOOST_CHECK(vTxId.empty());
+    BOOST_CHECK(!pageRejected.IsEmpty());
+
+    CTxIdCursor invalid;
+    BOOST_CHECK(!CTxIdCursor::Parse("", invalid));
+    BOOST_CHECK(!CTxIdCursor::Parse("12", invalid));
+    BOOST_CHECK(!CTxIdCursor::Parse("-1:" + vAll[0].GetHex(), invalid));
+    BOOST_CHECK(!CTxIdCursor::Parse("12:xyz", invalid));
+}
+
+BOOST_AUTO_TEST_CASE(address_asset_locked_key)
+{
+    // the unlock height is stored big endian so that database keys sort by height
+    uint256 assetId = uint256S("0x1234");
+    std::vector<std::string> vKey;
+    int vHeight[] = {0, 1, 255, 256, 65536, 1000000, INT_MAX};
+    for(unsigned int i = 0; i < sizeof(vHeight) / sizeof(vHeight[0]); i++)
+    {
+        CAddressAssetLocked_IndexKey key("Xaddress", assetId, vHeight[i]);
+        CDataStream ss(SER_DISK, CLIENT_VERSION);
+        ss << key;
+        BOOST_CHECK_EQUAL(ss.size(), GetSerializeSize(key, SER_DISK, CLIENT_VERSION));
+        vKey.push_back(std::string(ss.begin(), ss.end()));
+
+        CAddressAssetLocked_IndexKey keyRead;
+        ss >> keyRead;
+        BOOST_CHECK_EQUAL(keyRead.strAddress, key.strAddress);
+        BOOST_CHECK(keyRead.assetId == key.assetId);
+        BOOST_CHECK_EQUAL(keyRead.nUnlockedHeight, key.nUnlockedHeight);
+    }
+    BOOST_CHECK(std::is_sorted(vKey.begin(), vKey.end()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
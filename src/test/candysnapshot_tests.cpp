@@ -0,0 +1,262 @@
+// Copyright (c) 2018-2019 The Safe Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "candysnapshot.h"
+#include "clientversion.h"
+#include "streams.h"
+#include "validation.h"
+#include "utilstrencodings.h"
+
+#include "test/test_safe.h"
+
+#include <stdio.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(candysnapshot_tests, TestingSetup)
+
+static void WriteRecords(const boost::filesystem::path& path, const std::vector<CAddressAmount>& vRecords)
+{
+    FILE* pFile = fopen(path.string().c_str(), "wb");
+    BOOST_REQUIRE(pFile);
+    if(!vRecords.empty())
+        BOOST_REQUIRE(fwrite(&vRecords[0], sizeof(CAddressAmount), vRecords.size(), pFile) == vRecords.size());
+    fclose(pFile);
+}
+
+static CAmount FindAmount(const std::string& strFile, const std::string& strAddress)
+{
+    boost::shared_ptr<const CAddressAmountView> pView = candySnapshotStore.Get(strFile);
+    BOOST_REQUIRE(pView);
+    CAmount nAmount = 0;
+    pView->Find(strAddress, nAmount);
+    return nAmount;
+}
+
+static CAmount FindPendingAmount(const CCandyLedger& ledger, const std::string& strAddress)
+{
+    CAmount nAmount = 0;
+    BOOST_CHECK(ledger.FindPending(1, strAddress, nAmount));
+    return nAmount;
+}
+
+BOOST_AUTO_TEST_CASE(candysnapshot_find)
+{
+    // Many addresses share their first 8 bytes, so lookups span several fence blocks
+    std::vector<CAddressAmount> vRecords;
+    for(int i = 0; i < 1000; i++)
+        vRecords.push_back(CAddressAmount(strprintf("Xaddress%06d", i * 2), i + 1));
+    for(int i = 0; i < 100; i++)
+        vRecords.push_back(CAddressAmount(strprintf("Y%d", i * 2), -i));
+    std::sort(vRecords.begin(), vRecords.end());
+
+    boost::filesystem::path path = pathTemp / "all.dat";
+    WriteRecords(path, vRecords);
+
+    CAddressAmountView view;
+    BOOST_CHECK(view.Open(path));
+    BOOST_CHECK_EQUAL(view.size(), vRecords.size());
+
+    for(size_t i = 0; i < vRecords.size(); i++)
+    {
+        CAmount nAmount = 0;
+        long nPos = -1;
+        BOOST_CHECK_EQUAL(view.Find(vRecords[i].szAddress, nAmount, &nPos), 0);
+        BOOST_CHECK_EQUAL(nAmount, vRecords[i].nAmount);
+        BOOST_CHECK_EQUAL(nPos, (long)i);
+    }
+
+    // odd suffixes are absent and must report their insertion position
+    for(int i = 0; i < 1000; i++)
+    {
+        CAddressAmount key(strprintf("Xaddress%06d", i * 2 + 1), 0);
+        CAmount nAmount = 7;
+        long nPos = -1;
+        BOOST_CHECK_EQUAL(view.Find(key.szAddress, nAmount, &nPos), 1);
+        BOOST_CHECK_EQUAL(nAmount, 7);
+        BOOST_CHECK_EQUAL(nPos, std::lower_bound(vRecords.begin(), vRecords.end(), key) - vRecords.begin());
+    }
+
+    CAmount nAmount = 0;
+    long nPos = -1;
+    BOOST_CHECK_EQUAL(view.Find("A", nAmount, &nPos), 1);
+    BOOST_CHECK_EQUAL(nPos, 0);
+    BOOST_CHECK_EQUAL(view.Find("Z", nAmount, &nPos), 2);
+    BOOST_CHECK_EQUAL(nPos, (long)vRecords.size());
+}
+
+BOOST_AUTO_TEST_CASE(candysnapshot_merge)
+{
+    std::vector<CAddressAmount> vRecords;
+    for(int i = 0; i < 1000; i++)
+        vRecords.push_back(CAddressAmount(strprintf("Xaddress%06d", i * 3), i + 1));
+    std::sort(vRecords.begin(), vRecords.end());
+
+    boost::filesystem::path path = pathTemp / "2.change";
+    WriteRecords(path, vRecords);
+
+    CAddressAmountView view;
+    BOOST_CHECK(view.Open(path));
+
+    // both sparse and dense address lists, partly absent from the view
+    for(int nStride = 1; nStride < 700; nStride += 37)
+    {
+        std::vector<std::string> vAddress;
+        for(int i = 0; i < 3000; i += nStride)
+            vAddress.push_back(strprintf("Xaddress%06d", i));
+        vAddress.push_back("Zaddress");
+        std::sort(vAddress.begin(), vAddress.end());
+
+        std::vector<CAmount> vAmount(vAddress.size(), 1);
+        view.MergeAmounts(vAddress, vAmount, -1);
+        for(size_t i = 0; i < vAddress.size(); i++)
+        {
+            CAmount nAmount = 0;
+            view.Find(vAddress[i], nAmount);
+            BOOST_CHECK_EQUAL(vAmount[i], 1 - nAmount);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(candysnapshot_merge_file)
+{
+    std::vector<CAddressAmount> vRecords;
+    vRecords.push_back(CAddressAmount("Xa", 10));
+    vRecords.push_back(CAddressAmount("Xc", 20));
+    vRecords.push_back(CAddressAmount("Xe", 30));
+
+    boost::filesystem::path path = pathTemp / "all.dat";
+    WriteRecords(path, vRecords);
+
+    std::map<std::string, CAmount> mapDelta;
+    mapDelta["Xa"] = 5;
+    mapDelta["Xb"] = 7;
+    mapDelta["Xc"] = -20;
+    mapDelta["Xf"] = -1;
+
+    CAddressAmountView src;
+    BOOST_CHECK(src.Open(path));
+    BOOST_CHECK(MergeAddressAmountFile(src, mapDelta, pathTemp / "all.dat.temp"));
+
+    // Xc drops to zero and is removed, new addresses keep the order
+    CAddressAmountView dest;
+    BOOST_CHECK(dest.Open(pathTemp / "all.dat.temp"));
+    BOOST_REQUIRE_EQUAL(dest.size(), 4U);
+    BOOST_CHECK_EQUAL(std::string(dest.begin()[0].szAddress), "Xa");
+    BOOST_CHECK_EQUAL(dest.begin()[0].nAmount, 15);
+    BOOST_CHECK_EQUAL(std::string(dest.begin()[1].szAddress), "Xb");
+    BOOST_CHECK_EQUAL(dest.begin()[1].nAmount, 7);
+    BOOST_CHECK_EQUAL(std::string(dest.begin()[2].szAddress), "Xe");
+    BOOST_CHECK_EQUAL(dest.begin()[2].nAmount, 30);
+    BOOST_CHECK_EQUAL(std::string(dest.begin()[3].szAddress), "Xf");
+    BOOST_CHECK_EQUAL(dest.begin()[3].nAmount, -1);
+}
+
+BOOST_AUTO_TEST_CASE(candysnapshot_empty)
+{
+    CAddressAmountView missing;
+    BOOST_CHECK(missing.Open(pathTemp / "missing.change"));
+    BOOST_CHECK_EQUAL(missing.size(), 0U);
+
+    boost::filesystem::path path = pathTemp / "1.change";
+    WriteRecords(path, std::vector<CAddressAmount>());
+
+    CAddressAmountView empty;
+    CAmount nAmount = 0;
+    BOOST_CHECK(empty.Open(path));
+    BOOST_CHECK_EQUAL(empty.Find("Xaddress", nAmount), 2);
+}
+
+BOOST_AUTO_TEST_CASE(candyledger_append_compact)
+{
+    boost::filesystem::path heightDir = pathTemp / "height";
+    boost::filesystem::create_directories(heightDir);
+    std::vector<CAddressAmount> vRecords;
+    vRecords.push_back(CAddressAmount("Xa", 10));
+    WriteRecords(heightDir / "all.dat", vRecords);
+
+    CCandyLedger ledger;
+    BOOST_REQUIRE(ledger.Load());
+
+    std::map<std::string, CAmount> mapDelta;
+    mapDelta["Xa"] = 5;
+    mapDelta["Xb"] = 7;
+    BOOST_CHECK(ledger.AppendDelta(10, 0, mapDelta));
+    ledger.CloseDelta();
+    mapDelta.clear();
+    mapDelta["Xa"] = -3;
+    BOOST_CHECK(ledger.AppendDelta(11, 0, mapDelta));
+    BOOST_CHECK(!ledger.NeedCompact());
+    BOOST_CHECK_EQUAL(FindPendingAmount(ledger, "Xa"), 2);
+
+    // a rewrite of height 11 replaces its delta
+    mapDelta["Xa"] = -1;
+    BOOST_CHECK(ledger.AppendDelta(11, 0, mapDelta));
+    BOOST_CHECK_EQUAL(ledger.GetPendingCount(), 2U);
+    BOOST_CHECK_EQUAL(FindPendingAmount(ledger, "Xa"), 4);
+    BOOST_CHECK_EQUAL(FindPendingAmount(ledger, "Xb"), 7);
+
+    // the open delta of height 11 is not compacted
+    std::mutex mutexLedger;
+    BOOST_CHECK(ledger.Compact(mutexLedger));
+    BOOST_CHECK_EQUAL(ledger.GetPendingCount(), 1U);
+    BOOST_CHECK_EQUAL(FindAmount("all.dat", "Xa"), 15);
+    BOOST_CHECK_EQUAL(FindAmount("all.dat", "Xb"), 7);
+    BOOST_CHECK(!boost::filesystem::exists(heightDir / "delta" / "10.dat"));
+    BOOST_CHECK(!boost::filesystem::exists(heightDir / "all.dat.temp"));
+
+    ledger.CloseDelta();
+    BOOST_CHECK(ledger.Compact(mutexLedger));
+    BOOST_CHECK_EQUAL(ledger.GetPendingCount(), 0U);
+    BOOST_CHECK_EQUAL(FindAmount("all.dat", "Xa"), 14);
+    BOOST_CHECK_EQUAL(FindPendingAmount(ledger, "Xa"), 0);
+}
+
+BOOST_AUTO_TEST_CASE(candyledger_load_after_crash)
+{
+    boost::filesystem::path heightDir = pathTemp / "height";
+    boost::filesystem::create_directories(heightDir);
+    WriteRecords(heightDir / "all.dat", std::vector<CAddressAmount>());
+
+    {
+        CCandyLedger ledger;
+        BOOST_REQUIRE(ledger.Load());
+        std::map<std::string, CAmount> mapDelta;
+        mapDelta["Xa"] = 5;
+        BOOST_CHECK(ledger.AppendDelta(10, 0, mapDelta));
+        ledger.CloseDelta();
+        BOOST_CHECK(ledger.AppendDelta(11, 0, mapDelta));
+    }
+    // a delta written but not yet listed in the manifest
+    WriteRecords(heightDir / "delta" / "12.dat", std::vector<CAddressAmount>(1, CAddressAmount("Xa", 1)));
+
+    // the pending deltas survive a restart, the last one may be incomplete and stays open
+    CCandyLedger ledger;
+    BOOST_REQUIRE(ledger.Load());
+    BOOST_CHECK_EQUAL(ledger.GetPendingCount(), 2U);
+    BOOST_CHECK_EQUAL(FindPendingAmount(ledger, "Xa"), 10);
+    BOOST_CHECK(!boost::filesystem::exists(heightDir / "delta" / "12.dat"));
+    std::mutex mutexLedger;
+    BOOST_CHECK(ledger.Compact(mutexLedger));
+    BOOST_CHECK_EQUAL(ledger.GetPendingCount(), 1U);
+    BOOST_CHECK_EQUAL(FindAmount("all.dat", "Xa"), 5);
+
+    // crash after the compaction was committed to the manifest but before all.dat was renamed
+    WriteRecords(heightDir / "all.dat.temp", std::vector<CAddressAmount>(1, CAddressAmount("Xa", 10)));
+    {
+        CAutoFile fileout(fopen((heightDir / "manifest.dat").string().c_str(), "wb"), SER_DISK, CLIENT_VERSION);
+        BOOST_REQUIRE(!fileout.IsNull());
+        fileout << CLIENT_VERSION;
+        fileout << std::vector<CCandyDelta>();
+        fileout << std::vector<std::string>(1, "all.dat");
+    }
+
+    BOOST_REQUIRE(ledger.Load());
+    BOOST_CHECK_EQUAL(ledger.GetPendingCount(), 0U);
+    BOOST_CHECK_EQUAL(FindAmount("all.dat", "Xa"), 10);
+    BOOST_CHECK(!boost::filesystem::exists(heightDir / "all.dat.temp"));
+    BOOST_CHECK(!boost::filesystem::exists(heightDir / "delta" / "11.dat"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,71 @@
+// Copyright (c) 2018-2019 The Safe Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "lrucache.h"
+
+#include "test/test_safe.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(lrucache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(lrucache_evict)
+{
+    CLRUCache<int, int> cache(3);
+    cache.Insert(1, 10);
+    cache.Insert(2, 20);
+    cache.Insert(3, 30);
+
+    // reading 1 makes 2 the least recently used item
+    int nValue = 0;
+    BOOST_CHECK(cache.Get(1, nValue));
+    BOOST_CHECK_EQUAL(nValue, 10);
+    cache.Insert(4, 40);
+    BOOST_CHECK_EQUAL(cache.GetSize(), 3U);
+    BOOST_CHECK(!cache.Get(2, nValue));
+    BOOST_CHECK(cache.Get(1, nValue));
+    BOOST_CHECK(cache.Get(3, nValue));
+    BOOST_CHECK(cache.Get(4, nValue));
+
+    // updating a value refreshes it as well
+    cache.Insert(1, 11);
+    cache.Insert(5, 50);
+    BOOST_CHECK(!cache.Get(3, nValue));
+    BOOST_CHECK(cache.Get(1, nValue));
+    BOOST_CHECK_EQUAL(nValue, 11);
+
+    cache.Erase(1);
+    BOOST_CHECK(!cache.Get(1, nValue));
+    cache.SetMaxSize(1);
+    BOOST_CHECK_EQUAL(cache.GetSize(), 1U);
+    BOOST_CHECK(cache.Get(5, nValue));
+}
+
+struct IdentityHasher
+{
+    size_t operator()(const int& n) const { return n; }
+};
+
+BOOST_AUTO_TEST_CASE(lrucache_sharded)
+{
+    CShardedLRUCache<int, int, IdentityHasher, 4> cache(8);
+    for(int i = 0; i < 100; i++)
+        cache.Insert(i, i * 2);
+
+    // every shard keeps its own two most recent items
+    BOOST_CHECK_EQUAL(cache.GetSize(), 8U);
+    int nValue = 0;
+    for(int i = 0; i < 92; i++)
+        BOOST_CHECK(!cache.Get(i, nValue));
+    for(int i = 92; i < 100; i++)
+    {
+        BOOST_CHECK(cache.Get(i, nValue));
+        BOOST_CHECK_EQUAL(nValue, i * 2);
+    }
+
+    cache.Clear();
+    BOOST_CHECK_EQUAL(cache.GetSize(), 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,6 +5,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "chainparams.h"
+#include "main.h"
 #include "validation.h"
 #include "net.h"
 
@@ -80,4 +81,31 @@ BOOST_AUTO_TEST_CASE(test_combiner_all)
     Test.disconnect(&ReturnTrue);
     BOOST_CHECK(Test());
 }
+
+BOOST_AUTO_TEST_CASE(tx_height_cache)
+{
+    uint256 txHash = uint256S("0xabcd");
+    uint256 hashBlock = uint256S("0x1234");
+    uint256 hashBlockRet;
+    int32_t nVersion = 0;
+
+    // unknown transactions are treated as unconfirmed
+    BOOST_CHECK_EQUAL(GetTxHeight(txHash, &hashBlockRet, &nVersion), g_nChainHeight + 1);
+    BOOST_CHECK_EQUAL(nVersion, 0);
+
+    CacheTxHeight(txHash, 100, SAFE_TX_VERSION_3, hashBlock);
+    BOOST_CHECK_EQUAL(GetTxHeight(txHash, &hashBlockRet, &nVersion), 100);
+    BOOST_CHECK_EQUAL(nVersion, SAFE_TX_VERSION_3);
+    BOOST_CHECK(hashBlockRet == hashBlock);
+
+    // the lock check agrees with the one on a known height
+    CTxOut txout(COIN, CScript(), g_nChainHeight + 100);
+    BOOST_CHECK_EQUAL(IsLockedTxOut(txHash, txout), IsLockedTxOutByHeight(100, txout, SAFE_TX_VERSION_3));
+
+    UncacheTxHeight(txHash);
+    nVersion = 0;
+    BOOST_CHECK_EQUAL(GetTxHeight(txHash, NULL, &nVersion), g_nChainHeight + 1);
+    BOOST_CHECK_EQUAL(nVersion, 0);
+    BOOST_CHECK(!IsLockedTxOut(txHash, txout));
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -2,6 +2,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include "app/app.h"
 #include "chainparams.h"
 #include "coins.h"
 #include "consensus/consensus.h"
@@ -206,6 +207,52 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
     delete pblocktemplate;
     mempool.clear();
 
+    // free parent is mined for the fee of its child
+    tx.vin.resize(1);
+    tx.vin[0].prevout.hash = txFirst[1]->GetHash();
+    tx.vin[0].prevout.n = 0;
+    tx.vout[0].nValue = 50000000000LL;
+    hash = tx.GetHash();
+    mempool.addUnchecked(hash, entry.Fee(0).Time(GetTime()).SpendsCoinbase(true).FromTx(tx));
+    tx.vin[0].prevout.hash = hash;
+    tx.vout[0].nValue = 49000000000LL;
+    hash = tx.GetHash();
+    mempool.addUnchecked(hash, entry.Fee(1000000000LL).Time(GetTime()).SpendsCoinbase(false).FromTx(tx));
+    BOOST_CHECK(pblocktemplate = CreateNewBlock(chainparams, scriptPubKey));
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 3);
+    BOOST_CHECK(pblocktemplate->block.vtx[2].GetHash() == hash);
+    delete pblocktemplate;
+    mempool.clear();
+
+    // spending an asset output without an asset output drops the tx and its child, not the others
+    uint256 hashAssetCoins = uint256S("0xa55e7");
+    {
+        CCoinsModifier coins = pcoinsTip->ModifyCoins(hashAssetCoins);
+        coins->nHeight = 1;
+        coins->vout.resize(1);
+        coins->vout[0].nValue = 500;
+        coins->vout[0].scriptPubKey = CScript() << OP_1;
+        coins->vout[0].vReserve = FillCommonData(CAppHeader(g_nAppHeaderVersion, uint256S(g_strSafeAssetId), TRANSFER_ASSET_CMD), CCommonData(uint256S("0x1234"), 500, "remarks"));
+    }
+    tx.vin[0].prevout.hash = hashAssetCoins;
+    tx.vin[0].prevout.n = 0;
+    tx.vout[0].nValue = 0;
+    hash = tx.GetHash();
+    mempool.addUnchecked(hash, entry.Fee(1000000000LL).Time(GetTime()).SpendsCoinbase(false).FromTx(tx));
+    tx.vin[0].prevout.hash = hash;
+    hash = tx.GetHash();
+    mempool.addUnchecked(hash, entry.Fee(1000000000LL).Time(GetTime()).SpendsCoinbase(false).FromTx(tx));
+    tx.vin[0].prevout.hash = txFirst[1]->GetHash();
+    tx.vout[0].nValue = 49000000000LL;
+    hash = tx.GetHash();
+    mempool.addUnchecked(hash, entry.Fee(1000000LL).Time(GetTime()).SpendsCoinbase(true).FromTx(tx));
+    BOOST_CHECK(pblocktemplate = CreateNewBlock(chainparams, scriptPubKey));
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 2);
+    BOOST_CHECK(pblocktemplate->block.vtx[1].GetHash() == hash);
+    delete pblocktemplate;
+    mempool.clear();
+    pcoinsTip->ModifyCoins(hashAssetCoins)->Clear();
+
     // coinbase in mempool, template creation fails
     tx.vin.resize(1);
     tx.vin[0].prevout.SetNull();
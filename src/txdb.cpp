@@ -37,18 +37,23 @@ static const char DB_LAST_BLOCK = 'l';
 static const string DB_APPID_APPINFO_INDEX = "appid_appinfo";
 static const string DB_APPNAME_APPID_INDEX = "appname_appid";
 static const string DB_APPTX_INDEX = "apptx";
+static const string DB_ADDRESS_APPTX_INDEX = "address_apptx";
 static const string DB_AUTH_INDEX = "auth";
 static const string DB_ASSETID_ASSETINFO_INDEX = "assetid_assetinfo";
 static const string DB_SHORTNAME_ASSETID_INDEX = "shortname_assetid";
 static const string DB_ASSETNAME_ASSETID_INDEX = "assetname_assetid";
 static const string DB_ASSETTX_INDEX = "assettx";
+static const string DB_ADDRESS_ASSETTX_INDEX = "address_assettx";
 static const string DB_PUTCANDY_INDEX = "putcandy";
 static const string DB_GETCANDY_INDEX = "getcandy";
+static const string DB_ADDRESS_GETCANDY_INDEX = "address_getcandy";
 static const string DB_CANDYHEIGHT_TOTALAMOUNT_INDEX = "candyheight_totalamount";
 static const string DB_CANDYHEIGHT_INDEX = "candyheight";
 static const string DB_GETCANDYCOUNT_INDEX = "getcandycount";
 static const string DB_MASTERNODE_PAYEE_INDEX ="masternode_payee";
 static const string DB_LOCAL_START_SAVE_PAYEE_HEIGHT_INDEX ="localstartsavepayee_height";
+static const string DB_ADDRESS_ASSETBALANCE_INDEX = "address_assetbalance";
+static const string DB_ADDRESS_ASSETLOCKED_INDEX = "address_assetlocked";
 
 CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe) : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe, true)
 {
@@ -177,19 +182,16 @@ bool CBlockTreeDB::ReadTxIndex(const uint256 &txid, CDiskTxPos &pos) {
     return Read(make_pair(DB_TXINDEX, txid), pos);
 }
 
-bool CBlockTreeDB::WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> >&vect) {
-    CDBBatch batch(&GetObfuscateKey());
+void CBlockTreeDB::WriteTxIndex(CDBBatch& batch, const std::vector<std::pair<uint256, CDiskTxPos> >&vect) {
     for (std::vector<std::pair<uint256,CDiskTxPos> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Write(make_pair(DB_TXINDEX, it->first), it->second);
-    return WriteBatch(batch);
 }
 
 bool CBlockTreeDB::ReadSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value) {
     return Read(make_pair(DB_SPENTINDEX, key), value);
 }
 
-bool CBlockTreeDB::UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >&vect) {
-    CDBBatch batch(&GetObfuscateKey());
+void CBlockTreeDB::UpdateSpentIndex(CDBBatch& batch, const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >&vect) {
     for (std::vector<std::pair<CSpentIndexKey,CSpentIndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
         if (it->second.IsNull()) {
             batch.Erase(make_pair(DB_SPENTINDEX, it->first));
@@ -197,11 +199,9 @@ bool CBlockTreeDB::UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey,
             batch.Write(make_pair(DB_SPENTINDEX, it->first), it->second);
         }
     }
-    return WriteBatch(batch);
 }
 
-bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect) {
-    CDBBatch batch(&GetObfuscateKey());
+void CBlockTreeDB::UpdateAddressUnspentIndex(CDBBatch& batch, const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect) {
     for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
         if (it->second.IsNull()) {
             batch.Erase(make_pair(DB_ADDRESSUNSPENTINDEX, it->first));
@@ -209,7 +209,6 @@ bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddres
             batch.Write(make_pair(DB_ADDRESSUNSPENTINDEX, it->first), it->second);
         }
     }
-    return WriteBatch(batch);
 }
 
 bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
@@ -238,18 +237,14 @@ bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
     return true;
 }
 
-bool CBlockTreeDB::WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
-    CDBBatch batch(&GetObfuscateKey());
+void CBlockTreeDB::WriteAddressIndex(CDBBatch& batch, const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Write(make_pair(DB_ADDRESSINDEX, it->first), it->second);
-    return WriteBatch(batch);
 }
 
-bool CBlockTreeDB::EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
-    CDBBatch batch(&GetObfuscateKey());
+void CBlockTreeDB::EraseAddressIndex(CDBBatch& batch, const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Erase(make_pair(DB_ADDRESSINDEX, it->first));
-    return WriteBatch(batch);
 }
 
 bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
@@ -286,10 +281,8 @@ bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
     return true;
 }
 
-bool CBlockTreeDB::WriteTimestampIndex(const CTimestampIndexKey &timestampIndex) {
-    CDBBatch batch(&GetObfuscateKey());
+void CBlockTreeDB::WriteTimestampIndex(CDBBatch& batch, const CTimestampIndexKey &timestampIndex) {
     batch.Write(make_pair(DB_TIMESTAMPINDEX, timestampIndex), 0);
-    return WriteBatch(batch);
 }
 
 bool CBlockTreeDB::ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &hashes) {
@@ -378,20 +371,16 @@ bool CBlockTreeDB::LoadBlockIndexGuts()
     return true;
 }
 
-bool CBlockTreeDB::Write_AppId_AppInfo_Index(const std::vector<std::pair<uint256, CAppId_AppInfo_IndexValue> > &vect)
+void CBlockTreeDB::Write_AppId_AppInfo_Index(CDBBatch& batch, const std::vector<std::pair<uint256, CAppId_AppInfo_IndexValue> > &vect)
 {
-    CDBBatch batch(&GetObfuscateKey());
     for (std::vector<std::pair<uint256, CAppId_AppInfo_IndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Write(make_pair(DB_APPID_APPINFO_INDEX, it->first), it->second);
-    return WriteBatch(batch);
 }
 
-bool CBlockTreeDB::Erase_AppId_AppInfo_Index(const std::vector<std::pair<uint256, CAppId_AppInfo_IndexValue> > &vect)
+void CBlockTreeDB::Erase_AppId_AppInfo_Index(CDBBatch& batch, const std::vector<std::pair<uint256, CAppId_AppInfo_IndexValue> > &vect)
 {
-    CDBBatch batch(&GetObfuscateKey());
     for (std::vector<std::pair<uint256, CAppId_AppInfo_IndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Erase(make_pair(DB_APPID_APPINFO_INDEX, it->first));
-    return WriteBatch(batch);
 }
 
 bool CBlockTreeDB::Read_AppId_AppInfo_Index(const uint256& appId, CAppId_AppInfo_IndexValue& appInfo)
@@ -432,20 +421,16 @@ bool CBlockTreeDB::Read_AppList_Index(std::vector<uint256>& vAppId)
     return vAppId.size();
 }
 
-bool CBlockTreeDB::Write_AppName_AppId_Index(const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect)
+void CBlockTreeDB::Write_AppName_AppId_Index(CDBBatch& batch, const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect)
 {
-    CDBBatch batch(&GetObfuscateKey());
     for (std::vector<std::pair<std::string, CName_Id_IndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Write(make_pair(DB_APPNAME_APPID_INDEX, ToLower(it->first)), it->second);
-    return WriteBatch(batch);
 }
 
-bool CBlockTreeDB::Erase_AppName_AppId_Index(const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect)
+void CBlockTreeDB::Erase_AppName_AppId_Index(CDBBatch& batch, const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect)
 {
-    CDBBatch batch(&GetObfuscateKey());
     for (std::vector<std::pair<std::string, CName_Id_IndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Erase(make_pair(DB_APPNAME_APPID_INDEX, ToLower(it->first)));
-    return WriteBatch(batch);
 }
 
 bool CBlockTreeDB::Read_AppName_AppId_Index(const std::string& strAppName, CName_Id_IndexValue& value)
@@ -453,20 +438,22 @@ bool CBlockTreeDB::Read_AppName_AppId_Index(const std::string& strAppName, CName
     return Read(make_pair(DB_APPNAME_APPID_INDEX, ToLower(strAppName)), value) && g_nChainHeight >= value.nHeight;
 }
 
-bool CBlockTreeDB::Write_AppTx_Index(const std::vector<std::pair<CAppTx_IndexKey, int> > &vect)
+void CBlockTreeDB::Write_AppTx_Index(CDBBatch& batch, const std::vector<std::pair<CAppTx_IndexKey, int> > &vect)
 {
-    CDBBatch batch(&GetObfuscateKey());
     for(std::vector<std::pair<CAppTx_IndexKey, int> >::const_iterator it = vect.begin(); it != vect.end(); it++)
+    {
         batch.Write(make_pair(DB_APPTX_INDEX, it->first), it->second);
-    return WriteBatch(batch);
+        batch.Write(make_pair(DB_ADDRESS_APPTX_INDEX, CAddressAppTx_IndexKey(it->first)), it->second);
+    }
 }
 
-bool CBlockTreeDB::Erase_AppTx_Index(const std::vector<std::pair<CAppTx_IndexKey, int> > &vect)
+void CBlockTreeDB::Erase_AppTx_Index(CDBBatch& batch, const std::vector<std::pair<CAppTx_IndexKey, int> > &vect)
 {
-    CDBBatch batch(&GetObfuscateKey());
     for(std::vector<std::pair<CAppTx_IndexKey, int> >::const_iterator it = vect.begin(); it != vect.end(); it++)
+    {
         batch.Erase(make_pair(DB_APPTX_INDEX, it->first));
-    return WriteBatch(batch);
+        batch.Erase(make_pair(DB_ADDRESS_APPTX_INDEX, CAddressAppTx_IndexKey(it->first)));
+    }
 }
 
 bool CBlockTreeDB::Read_AppTx_Index(const uint256& appId, std::vector<COutPoint>& vOut)
@@ -537,25 +524,24 @@ bool CBlockTreeDB::Read_AppTx_Index(const uint256& appId, const std::string& str
     return vOut.size();
 }
 
-bool CBlockTreeDB::Read_AppList_Index(const std::string& strAddress, std::vector<uint256>& vAppId)
+bool CBlockTreeDB::Read_AppTx_Index(const uint256& appId, const std::string& strAddress, CTxIdPage& page)
 {
     boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
 
-    pcursor->Seek(make_pair(DB_APPTX_INDEX, CIterator_IdAddressKey()));
+    pcursor->Seek(make_pair(DB_APPTX_INDEX, CIterator_IdAddressKey(appId, strAddress)));
 
     int nCurHeight = g_nChainHeight;
-    std::map<uint256, char> mapAppId;
     while (pcursor->Valid())
     {
         boost::this_thread::interruption_point();
         std::pair<std::string, CAppTx_IndexKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_APPTX_INDEX)
+        if (pcursor->GetKey(key) && key.first == DB_APPTX_INDEX && key.second.appId == appId && (strAddress.empty() || key.second.strAddress == strAddress))
         {
             int nHeight;
             if(pcursor->GetValue(nHeight))
             {
-                if(nCurHeight >= nHeight && key.second.strAddress == strAddress)
-                    mapAppId[key.second.appId] = 1;
+                if(nCurHeight >= nHeight)
+                    page.Add(nHeight, key.second.out.hash);
                 pcursor->Next();
             }
             else
@@ -569,15 +555,46 @@ bool CBlockTreeDB::Read_AppList_Index(const std::string& strAddress, std::vector
         }
     }
 
-    for(std::map<uint256, char>::const_iterator it = mapAppId.begin(); it != mapAppId.end(); it++)
-        vAppId.push_back(it->first);
+    return true;
+}
+
+bool CBlockTreeDB::Read_AppList_Index(const std::string& strAddress, std::vector<uint256>& vAppId)
+{
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+
+    pcursor->Seek(make_pair(DB_ADDRESS_APPTX_INDEX, CIterator_AddressKey(strAddress)));
+
+    int nCurHeight = g_nChainHeight;
+    while (pcursor->Valid())
+    {
+        boost::this_thread::interruption_point();
+        std::pair<std::string, CAddressAppTx_IndexKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESS_APPTX_INDEX && key.second.strAddress == strAddress)
+        {
+            int nHeight;
+            if(pcursor->GetValue(nHeight))
+            {
+                // keys are ordered by app id, so duplicates are adjacent
+                if(nCurHeight >= nHeight && (vAppId.empty() || vAppId.back() != key.second.appId))
+                    vAppId.push_back(key.second.appId);
+                pcursor->Next();
+            }
+            else
+            {
+                return error("failed to get address_apptx index value");
+            }
+        }
+        else
+        {
+            break;
+        }
+    }
 
     return vAppId.size();
 }
 
-bool CBlockTreeDB::Update_Auth_Index(const std::vector<std::pair<CAuth_IndexKey, int> > &vect)
+void CBlockTreeDB::Update_Auth_Index(CDBBatch& batch, const std::vector<std::pair<CAuth_IndexKey, int> > &vect)
 {
-    CDBBatch batch(&GetObfuscateKey());
     for(std::vector<std::pair<CAuth_IndexKey, int> >::const_iterator it = vect.begin(); it != vect.end(); it++)
     {
         if(it->second <= 0)
@@ -585,7 +602,6 @@ bool CBlockTreeDB::Update_Auth_Index(const std::vector<std::pair<CAuth_IndexKey,
         else
             batch.Write(make_pair(DB_AUTH_INDEX, it->first), it->second);
     }
-    return WriteBatch(batch);
 }
 bool CBlockTreeDB::Read_Auth_Index(const uint256& appId, const std::string& strAddress, std::map<uint32_t, int>& mapAuth)
 {
@@ -619,20 +635,16 @@ bool CBlockTreeDB::Read_Auth_Index(const uint256& appId, const std::string& strA
     return mapAuth.size();
 }
 
-bool CBlockTreeDB::Write_AssetId_AssetInfo_Index(const std::vector<std::pair<uint256, CAssetId_AssetInfo_IndexValue> > &vect)
+void CBlockTreeDB::Write_AssetId_AssetInfo_Index(CDBBatch& batch, const std::vector<std::pair<uint256, CAssetId_AssetInfo_IndexValue> > &vect)
 {
-    CDBBatch batch(&GetObfuscateKey());
     for (std::vector<std::pair<uint256, CAssetId_AssetInfo_IndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Write(make_pair(DB_ASSETID_ASSETINFO_INDEX, it->first), it->second);
-    return WriteBatch(batch);
 }
 
-bool CBlockTreeDB::Erase_AssetId_AssetInfo_Index(const std::vector<std::pair<uint256, CAssetId_AssetInfo_IndexValue> > &vect)
+void CBlockTreeDB::Erase_AssetId_AssetInfo_Index(CDBBatch& batch, const std::vector<std::pair<uint256, CAssetId_AssetInfo_IndexValue> > &vect)
 {
-    CDBBatch batch(&GetObfuscateKey());
     for (std::vector<std::pair<uint256, CAssetId_AssetInfo_IndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Erase(make_pair(DB_ASSETID_ASSETINFO_INDEX, it->first));
-    return WriteBatch(batch);
 }
 
 bool CBlockTreeDB::Read_AssetId_AssetInfo_Index(const uint256& assetId, CAssetId_AssetInfo_IndexValue& assetInfo)
@@ -674,20 +686,16 @@ bool CBlockTreeDB::Read_AssetList_Index(std::vector<uint256>& vAssetId)
     return vAssetId.size();
 }
 
-bool CBlockTreeDB::Write_ShortName_AssetId_Index(const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect)
+void CBlockTreeDB::Write_ShortName_AssetId_Index(CDBBatch& batch, const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect)
 {
-    CDBBatch batch(&GetObfuscateKey());
     for (std::vector<std::pair<std::string, CName_Id_IndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Write(make_pair(DB_SHORTNAME_ASSETID_INDEX, ToLower(it->first)), it->second);
-    return WriteBatch(batch);
 }
 
-bool CBlockTreeDB::Erase_ShortName_AssetId_Index(const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect)
+void CBlockTreeDB::Erase_ShortName_AssetId_Index(CDBBatch& batch, const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect)
 {
-    CDBBatch batch(&GetObfuscateKey());
     for (std::vector<std::pair<std::string, CName_Id_IndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Erase(make_pair(DB_SHORTNAME_ASSETID_INDEX, ToLower(it->first)));
-    return WriteBatch(batch);
 }
 
 bool CBlockTreeDB::Read_ShortName_AssetId_Index(const std::string& strShortName, CName_Id_IndexValue& value)
@@ -695,20 +703,16 @@ bool CBlockTreeDB::Read_ShortName_AssetId_Index(const std::string& strShortName,
     return Read(make_pair(DB_SHORTNAME_ASSETID_INDEX, ToLower(strShortName)), value) && g_nChainHeight >= value.nHeight;
 }
 
-bool CBlockTreeDB::Write_AssetName_AssetId_Index(const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect)
+void CBlockTreeDB::Write_AssetName_AssetId_Index(CDBBatch& batch, const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect)
 {
-    CDBBatch batch(&GetObfuscateKey());
     for (std::vector<std::pair<std::string, CName_Id_IndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Write(make_pair(DB_ASSETNAME_ASSETID_INDEX, ToLower(it->first)), it->second);
-    return WriteBatch(batch);
 }
 
-bool CBlockTreeDB::Erase_AssetName_AssetId_Index(const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect)
+void CBlockTreeDB::Erase_AssetName_AssetId_Index(CDBBatch& batch, const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect)
 {
-    CDBBatch batch(&GetObfuscateKey());
     for (std::vector<std::pair<std::string, CName_Id_IndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Erase(make_pair(DB_ASSETNAME_ASSETID_INDEX, ToLower(it->first)));
-    return WriteBatch(batch);
 }
 
 bool CBlockTreeDB::Read_AssetName_AssetId_Index(const std::string& strAssetName, CName_Id_IndexValue& value)
@@ -716,20 +720,22 @@ bool CBlockTreeDB::Read_AssetName_AssetId_Index(const std::string& strAssetName,
     return Read(make_pair(DB_ASSETNAME_ASSETID_INDEX, ToLower(strAssetName)), value) && g_nChainHeight >= value.nHeight;
 }
 
-bool CBlockTreeDB::Write_AssetTx_Index(const std::vector<std::pair<CAssetTx_IndexKey, int> > &vect)
+void CBlockTreeDB::Write_AssetTx_Index(CDBBatch& batch, const std::vector<std::pair<CAssetTx_IndexKey, int> > &vect)
 {
-    CDBBatch batch(&GetObfuscateKey());
     for(std::vector<std::pair<CAssetTx_IndexKey, int> >::const_iterator it = vect.begin(); it != vect.end(); it++)
+    {
         batch.Write(make_pair(DB_ASSETTX_INDEX, it->first), it->second);
-    return WriteBatch(batch);
+        batch.Write(make_pair(DB_ADDRESS_ASSETTX_INDEX, CAddressAssetTx_IndexKey(it->first)), it->second);
+    }
 }
 
-bool CBlockTreeDB::Erase_AssetTx_Index(const std::vector<std::pair<CAssetTx_IndexKey, int> > &vect)
+void CBlockTreeDB::Erase_AssetTx_Index(CDBBatch& batch, const std::vector<std::pair<CAssetTx_IndexKey, int> > &vect)
 {
-    CDBBatch batch(&GetObfuscateKey());
     for(std::vector<std::pair<CAssetTx_IndexKey, int> >::const_iterator it = vect.begin(); it != vect.end(); it++)
+    {
         batch.Erase(make_pair(DB_ASSETTX_INDEX, it->first));
-    return WriteBatch(batch);
+        batch.Erase(make_pair(DB_ADDRESS_ASSETTX_INDEX, CAddressAssetTx_IndexKey(it->first)));
+    }
 }
 
 bool CBlockTreeDB::Read_AssetTx_Index(const uint256& assetId, const uint8_t& nTxClass, std::vector<COutPoint>& vOut)
@@ -840,25 +846,29 @@ bool CBlockTreeDB::Read_AssetTx_Index(const uint256& assetId, const std::string&
     return vOut.size();
 }
 
-bool CBlockTreeDB::Read_AssetList_Index(const std::string& strAddress, std::vector<uint256>& vAssetId)
+bool CBlockTreeDB::Read_AssetTx_Index(const uint256& assetId, const std::string& strAddress, const uint8_t& nTxClass, CTxIdPage& page)
 {
     boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
 
-    pcursor->Seek(make_pair(DB_ASSETTX_INDEX, CIterator_IdAddressKey()));
+    pcursor->Seek(make_pair(DB_ASSETTX_INDEX, CIterator_IdAddressKey(assetId, strAddress)));
 
     int nCurHeight = g_nChainHeight;
-    std::map<uint256, char> mapAssetId;
     while (pcursor->Valid())
     {
         boost::this_thread::interruption_point();
         std::pair<std::string, CAssetTx_IndexKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_ASSETTX_INDEX)
+        if (pcursor->GetKey(key) && key.first == DB_ASSETTX_INDEX && key.second.assetId == assetId && (strAddress.empty() || key.second.strAddress == strAddress))
         {
             int nHeight;
             if(pcursor->GetValue(nHeight))
             {
-                if(nCurHeight >= nHeight && key.second.strAddress == strAddress)
-                    mapAssetId[key.second.assetId] = 1;
+                if(nCurHeight >= nHeight)
+                {
+                    if(nTxClass == ALL_TXOUT
+                        || (nTxClass == UNLOCKED_TXOUT && key.second.nTxClass != LOCKED_TXOUT)
+                        || key.second.nTxClass == nTxClass)
+                        page.Add(nHeight, key.second.out.hash);
+                }
                 pcursor->Next();
             }
             else
@@ -872,26 +882,54 @@ bool CBlockTreeDB::Read_AssetList_Index(const std::string& strAddress, std::vect
         }
     }
 
-    for(std::map<uint256, char>::iterator it = mapAssetId.begin(); it != mapAssetId.end(); it++)
-        vAssetId.push_back(it->first);
+    return true;
+}
+
+bool CBlockTreeDB::Read_AssetList_Index(const std::string& strAddress, std::vector<uint256>& vAssetId)
+{
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+
+    pcursor->Seek(make_pair(DB_ADDRESS_ASSETTX_INDEX, CIterator_AddressKey(strAddress)));
+
+    int nCurHeight = g_nChainHeight;
+    while (pcursor->Valid())
+    {
+        boost::this_thread::interruption_point();
+        std::pair<std::string, CAddressAssetTx_IndexKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESS_ASSETTX_INDEX && key.second.strAddress == strAddress)
+        {
+            int nHeight;
+            if(pcursor->GetValue(nHeight))
+            {
+                // keys are ordered by asset id, so duplicates are adjacent
+                if(nCurHeight >= nHeight && (vAssetId.empty() || vAssetId.back() != key.second.assetId))
+                    vAssetId.push_back(key.second.assetId);
+                pcursor->Next();
+            }
+            else
+            {
+                return error("failed to get address_assettx index value");
+            }
+        }
+        else
+        {
+            break;
+        }
+    }
 
     return vAssetId.size();
 }
 
-bool CBlockTreeDB::Write_PutCandy_Index(const std::vector<std::pair<CPutCandy_IndexKey, CPutCandy_IndexValue> > &vect)
+void CBlockTreeDB::Write_PutCandy_Index(CDBBatch& batch, const std::vector<std::pair<CPutCandy_IndexKey, CPutCandy_IndexValue> > &vect)
 {
-    CDBBatch batch(&GetObfuscateKey());
     for(std::vector<std::pair<CPutCandy_IndexKey, CPutCandy_IndexValue> >::const_iterator it = vect.begin(); it != vect.end(); it++)
         batch.Write(make_pair(DB_PUTCANDY_INDEX, it->first), it->second);
-    return WriteBatch(batch);
 }
 
-bool CBlockTreeDB::Erase_PutCandy_Index(const std::vector<std::pair<CPutCandy_IndexKey, CPutCandy_IndexValue> > &vect)
+void CBlockTreeDB::Erase_PutCandy_Index(CDBBatch& batch, const std::vector<std::pair<CPutCandy_IndexKey, CPutCandy_IndexValue> > &vect)
 {
-    CDBBatch batch(&GetObfuscateKey());
     for(std::vector<std::pair<CPutCandy_IndexKey, CPutCandy_IndexValue> >::const_iterator it = vect.begin(); it != vect.end(); it++)
         batch.Erase(make_pair(DB_PUTCANDY_INDEX, it->first));
-    return WriteBatch(batch);
 }
 
 bool CBlockTreeDB::Read_PutCandy_Index(const uint256& assetId, std::map<COutPoint, CCandyInfo>& mapCandyInfo)
@@ -999,20 +1037,22 @@ bool CBlockTreeDB::Read_PutCandy_Index(std::map<CPutCandy_IndexKey, CPutCandy_In
     return mapCandy.size();
 }
 
-bool CBlockTreeDB::Write_GetCandy_Index(const std::vector<std::pair<CGetCandy_IndexKey, CGetCandy_IndexValue> >& vect)
+void CBlockTreeDB::Write_GetCandy_Index(CDBBatch& batch, const std::vector<std::pair<CGetCandy_IndexKey, CGetCandy_IndexValue> >& vect)
 {
-    CDBBatch batch(&GetObfuscateKey());
     for(std::vector<std::pair<CGetCandy_IndexKey, CGetCandy_IndexValue> >::const_iterator it = vect.begin(); it != vect.end(); it++)
+    {
         batch.Write(make_pair(DB_GETCANDY_INDEX, it->first), it->second);
-    return WriteBatch(batch);
+        batch.Write(make_pair(DB_ADDRESS_GETCANDY_INDEX, CAddressGetCandy_IndexKey(it->first)), it->second.nHeight);
+    }
 }
 
-bool CBlockTreeDB::Erase_GetCandy_Index(const std::vector<std::pair<CGetCandy_IndexKey, CGetCandy_IndexValue> >& vect)
+void CBlockTreeDB::Erase_GetCandy_Index(CDBBatch& batch, const std::vector<std::pair<CGetCandy_IndexKey, CGetCandy_IndexValue> >& vect)
 {
-    CDBBatch batch(&GetObfuscateKey());
     for(std::vector<std::pair<CGetCandy_IndexKey, CGetCandy_IndexValue> >::const_iterator it = vect.begin(); it != vect.end(); it++)
+    {
         batch.Erase(make_pair(DB_GETCANDY_INDEX, it->first));
-    return WriteBatch(batch);
+        batch.Erase(make_pair(DB_ADDRESS_GETCANDY_INDEX, CAddressGetCandy_IndexKey(it->first)));
+    }
 }
 
 bool CBlockTreeDB::Read_GetCandy_Index(const uint256& assetId, const COutPoint& out, const std::string& strAddress, CAmount& nAmount)
@@ -1102,25 +1142,25 @@ bool CBlockTreeDB::Read_GetCandy_Index(const uint256& assetId, const std::string
 {
     boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
 
-    pcursor->Seek(make_pair(DB_GETCANDY_INDEX, CIterator_IdKey(assetId)));
+    pcursor->Seek(make_pair(DB_ADDRESS_GETCANDY_INDEX, CIterator_IdAddressKey(assetId, straddress)));
 
     int nCurHeight = g_nChainHeight;
     while (pcursor->Valid())
     {
         boost::this_thread::interruption_point();
-        std::pair<std::string, CGetCandy_IndexKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_GETCANDY_INDEX && key.second.assetId == assetId)
+        std::pair<std::string, CAddressGetCandy_IndexKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESS_GETCANDY_INDEX && key.second.assetId == assetId && key.second.strAddress == straddress)
         {
-            CGetCandy_IndexValue value;
-            if(pcursor->GetValue(value))
+            int nHeight;
+            if(pcursor->GetValue(nHeight))
             {
-                if(nCurHeight >= value.nHeight && key.second.strAddress == straddress)
+                if(nCurHeight >= nHeight)
                     vOut.push_back(key.second.out);
                 pcursor->Next();
             }
             else
             {
-                return error("failed to get getcandy index value");
+                return error("failed to get address_getcandy index value");
             }
         }
         else
@@ -1195,18 +1235,14 @@ bool CBlockTreeDB::Read_CandyHeight_Index(std::vector<int> &vHeight)
     return vHeight.size();
 }
 
-bool CBlockTreeDB::Write_GetCandyCount_Index(const CGetCandyCount_IndexKey& key,const CGetCandyCount_IndexValue& value)
+void CBlockTreeDB::Write_GetCandyCount_Index(CDBBatch& batch, const CGetCandyCount_IndexKey& key,const CGetCandyCount_IndexValue& value)
 {
-    CDBBatch batch(&GetObfuscateKey());
     batch.Write(make_pair(DB_GETCANDYCOUNT_INDEX, key), value);
-    return WriteBatch(batch);
 }
 
-bool CBlockTreeDB::Erase_GetCandyCount_Index(const CGetCandyCount_IndexKey &key)
+void CBlockTreeDB::Erase_GetCandyCount_Index(CDBBatch& batch, const CGetCandyCount_IndexKey &key)
 {
-    CDBBatch batch(&GetObfuscateKey());
     batch.Erase(make_pair(DB_GETCANDYCOUNT_INDEX, key));
-    return WriteBatch(batch);
 }
 
 bool CBlockTreeDB::Is_Exists_GetCandyCount_Key(const uint256& assetId, const COutPoint& out)
@@ -1264,18 +1300,14 @@ bool CBlockTreeDB::Read_GetCandyCount_Index(const uint256& assetId, const COutPo
     return ret;
 }
 
-bool CBlockTreeDB::Write_MasternodePayee_Index(const std::string& strPubKeyCollateralAddress, const CMasternodePayee_IndexValue& value)
+void CBlockTreeDB::Write_MasternodePayee_Index(CDBBatch& batch, const std::string& strPubKeyCollateralAddress, const CMasternodePayee_IndexValue& value)
 {
-    CDBBatch batch(&GetObfuscateKey());
     batch.Write(make_pair(DB_MASTERNODE_PAYEE_INDEX, strPubKeyCollateralAddress), value);
-    return WriteBatch(batch);
 }
 
-bool CBlockTreeDB::Erase_MasternodePayee_Index(const string &strPubKeyCollateralAddress)
+void CBlockTreeDB::Erase_MasternodePayee_Index(CDBBatch& batch, const string &strPubKeyCollateralAddress)
 {
-    CDBBatch batch(&GetObfuscateKey());
     batch.Erase(make_pair(DB_MASTERNODE_PAYEE_INDEX, strPubKeyCollateralAddress));
-    return WriteBatch(batch);
 }
 
 bool CBlockTreeDB::Read_MasternodePayee_Index(const string &strPubKeyCollateralAddress, CMasternodePayee_IndexValue &value)
@@ -1338,11 +1370,9 @@ bool CBlockTreeDB::Is_Exists_MasternodePayee_Key(const string &strPubKeyCollater
     return ret;
 }
 
-bool CBlockTreeDB::Write_LocalStartSavePayeeHeight_Index(const int &nHeight)
+void CBlockTreeDB::Write_LocalStartSavePayeeHeight_Index(CDBBatch& batch, const int &nHeight)
 {
-    CDBBatch batch(&GetObfuscateKey());
     batch.Write(DB_LOCAL_START_SAVE_PAYEE_HEIGHT_INDEX, nHeight);
-    return WriteBatch(batch);
 }
 
 bool CBlockTreeDB::Read_LocalStartSavePayeeHeight_Index(int &nHeight)
@@ -1370,3 +1400,132 @@ bool CBlockTreeDB::Read_LocalStartSavePayeeHeight_Index(int &nHeight)
 
     return ret;
 }
+
+static int GetIndexHeight(const int& nHeight) { return nHeight; }
+static int GetIndexHeight(const CGetCandy_IndexValue& value) { return value.nHeight; }
+
+bool CBlockTreeDB::Update_AddressAssetBalance_Index(CDBBatch& batch, const std::map<CAddressAssetBalance_IndexKey, CAddressAssetBalance_IndexValue>& mapDelta)
+{
+    for(std::map<CAddressAssetBalance_IndexKey, CAddressAssetBalance_IndexValue>::const_iterator it = mapDelta.begin(); it != mapDelta.end(); it++)
+    {
+        CAddressAssetBalance_IndexValue value;
+        if(Exists(make_pair(DB_ADDRESS_ASSETBALANCE_INDEX, it->first)) && !Read(make_pair(DB_ADDRESS_ASSETBALANCE_INDEX, it->first), value))
+            return error("failed to read address_assetbalance index value");
+        if(!value.nReceived.Add(it->second.nReceived) || !value.nSent.Add(it->second.nSent))
+            return error("address_assetbalance index amount overflow");
+
+        if(value.IsNull())
+            batch.Erase(make_pair(DB_ADDRESS_ASSETBALANCE_INDEX, it->first));
+        else
+            batch.Write(make_pair(DB_ADDRESS_ASSETBALANCE_INDEX, it->first), value);
+    }
+    return true;
+}
+
+bool CBlockTreeDB::Update_AddressAssetLocked_Index(CDBBatch& batch, const std::map<CAddressAssetLocked_IndexKey, CAssetAmount>& mapDelta)
+{
+    for(std::map<CAddressAssetLocked_IndexKey, CAssetAmount>::const_iterator it = mapDelta.begin(); it != mapDelta.end(); it++)
+    {
+        CAssetAmount nAmount;
+        if(Exists(make_pair(DB_ADDRESS_ASSETLOCKED_INDEX, it->first)) && !Read(make_pair(DB_ADDRESS_ASSETLOCKED_INDEX, it->first), nAmount))
+            return error("failed to read address_assetlocked index value");
+        if(!nAmount.Add(it->second))
+            return error("address_assetlocked index amount overflow");
+
+        if(nAmount == CAssetAmount())
+            batch.Erase(make_pair(DB_ADDRESS_ASSETLOCKED_INDEX, it->first));
+        else
+            batch.Write(make_pair(DB_ADDRESS_ASSETLOCKED_INDEX, it->first), nAmount);
+    }
+    return true;
+}
+
+bool CBlockTreeDB::Read_AddressAssetBalance_Index(const std::string& strAddress, const uint256& assetId, const int& nHeight, CAddressAssetBalance_IndexValue& value, CAssetAmount& nLocked)
+{
+    CAddressAssetBalance_IndexKey balanceKey(strAddress, assetId);
+    value = CAddressAssetBalance_IndexValue();
+    if(Exists(make_pair(DB_ADDRESS_ASSETBALANCE_INDEX, balanceKey)) && !Read(make_pair(DB_ADDRESS_ASSETBALANCE_INDEX, balanceKey), value))
+        return error("failed to read address_assetbalance index value");
+
+    // outputs unlocking above nHeight are still locked
+    nLocked = CAssetAmount();
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(make_pair(DB_ADDRESS_ASSETLOCKED_INDEX, CAddressAssetLocked_IndexKey(strAddress, assetId, nHeight + 1)));
+    while (pcursor->Valid())
+    {
+        boost::this_thread::interruption_point();
+        std::pair<std::string, CAddressAssetLocked_IndexKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESS_ASSETLOCKED_INDEX && key.second.strAddress == strAddress && key.second.assetId == assetId)
+        {
+            CAssetAmount nAmount;
+            if(!pcursor->GetValue(nAmount))
+                return error("failed to get address_assetlocked index value");
+            if(!nLocked.Add(nAmount))
+                return error("address_assetlocked index amount overflow");
+            pcursor->Next();
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    return true;
+}
+
+/** Copy every entry of the keyspace strFrom to strTo, with the key converted to NewKey and the value to its height */
+template <typename Key, typename Value, typename NewKey>
+static bool CopyIndex(CBlockTreeDB& db, const std::string& strFrom, const std::string& strTo, uint64_t& nCount)
+{
+    boost::scoped_ptr<CDBIterator> pcursor(db.NewIterator());
+    boost::scoped_ptr<CDBBatch> pbatch(new CDBBatch(&db.GetObfuscateKey()));
+
+    pcursor->Seek(make_pair(strFrom, CIterator_IdKey()));
+
+    unsigned int nBatch = 0;
+    while (pcursor->Valid())
+    {
+        boost::this_thread::interruption_point();
+        std::pair<std::string, Key> key;
+        if (!pcursor->GetKey(key) || key.first != strFrom)
+            break;
+
+        Value value;
+        if (!pcursor->GetValue(value))
+            return error("failed to get %s index value", strFrom);
+
+        pbatch->Write(make_pair(strTo, NewKey(key.second)), GetIndexHeight(value));
+        nCount++;
+        if (++nBatch >= 10000)
+        {
+            if (!db.WriteBatch(*pbatch))
+                return false;
+            pbatch.reset(new CDBBatch(&db.GetObfuscateKey()));
+            nBatch = 0;
+        }
+        pcursor->Next();
+    }
+
+    return db.WriteBatch(*pbatch);
+}
+
+bool CBlockTreeDB::Upgrade_AddressTx_Index()
+{
+    bool fUpgraded = false;
+    if (ReadFlag("addresstxindex", fUpgraded) && fUpgraded)
+        return true;
+
+    LogPrintf("Upgrading asset, app and candy indexes to address keyed indexes...\n");
+    int64_t nStart = GetTimeMillis();
+    uint64_t nCount = 0;
+
+    if (!CopyIndex<CAssetTx_IndexKey, int, CAddressAssetTx_IndexKey>(*this, DB_ASSETTX_INDEX, DB_ADDRESS_ASSETTX_INDEX, nCount))
+        return error("%s: upgrade address_assettx index failed", __func__);
+    if (!CopyIndex<CAppTx_IndexKey, int, CAddressAppTx_IndexKey>(*this, DB_APPTX_INDEX, DB_ADDRESS_APPTX_INDEX, nCount))
+        return error("%s: upgrade address_apptx index failed", __func__);
+    if (!CopyIndex<CGetCandy_IndexKey, CGetCandy_IndexValue, CAddressGetCandy_IndexKey>(*this, DB_GETCANDY_INDEX, DB_ADDRESS_GETCANDY_INDEX, nCount))
+        return error("%s: upgrade address_getcandy index failed", __func__);
+
+    LogPrintf("Upgraded %u index entries in %dms\n", nCount, GetTimeMillis() - nStart);
+    return WriteFlag("addresstxindex", true);
+}
@@ -39,6 +39,10 @@ struct CPutCandy_IndexKey;
 struct CPutCandy_IndexValue;
 struct CGetCandy_IndexKey;
 struct CGetCandy_IndexValue;
+class CTxIdPage;
+struct CAddressAssetBalance_IndexKey;
+struct CAddressAssetBalance_IndexValue;
+struct CAddressAssetLocked_IndexKey;
 
 //! -dbcache default (MiB)
 static const int64_t nDefaultDbCache = 100;
@@ -77,68 +81,73 @@ public:
     bool WriteReindexing(bool fReindex);
     bool ReadReindexing(bool &fReindex);
     bool ReadTxIndex(const uint256 &txid, CDiskTxPos &pos);
-    bool WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> > &list);
+    /** The index Write, Erase and Update methods below only add to batch, block (dis)connection commits one batch per block */
+    void WriteTxIndex(CDBBatch& batch, const std::vector<std::pair<uint256, CDiskTxPos> > &list);
     bool ReadSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value);
-    bool UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >&vect);
-    bool UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect);
+    void UpdateSpentIndex(CDBBatch& batch, const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >&vect);
+    void UpdateAddressUnspentIndex(CDBBatch& batch, const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect);
     bool ReadAddressUnspentIndex(uint160 addressHash, int type,
                                  std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vect);
-    bool WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect);
-    bool EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect);
+    void WriteAddressIndex(CDBBatch& batch, const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect);
+    void EraseAddressIndex(CDBBatch& batch, const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect);
     bool ReadAddressIndex(uint160 addressHash, int type,
                           std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
                           int start = 0, int end = 0);
-    bool WriteTimestampIndex(const CTimestampIndexKey &timestampIndex);
+    void WriteTimestampIndex(CDBBatch& batch, const CTimestampIndexKey &timestampIndex);
     bool ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &vect);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
     bool LoadBlockIndexGuts();
 
-    bool Write_AppId_AppInfo_Index(const std::vector<std::pair<uint256, CAppId_AppInfo_IndexValue> > &vect);
-    bool Erase_AppId_AppInfo_Index(const std::vector<std::pair<uint256, CAppId_AppInfo_IndexValue> > &vect);
+    void Write_AppId_AppInfo_Index(CDBBatch& batch, const std::vector<std::pair<uint256, CAppId_AppInfo_IndexValue> > &vect);
+    void Erase_AppId_AppInfo_Index(CDBBatch& batch, const std::vector<std::pair<uint256, CAppId_AppInfo_IndexValue> > &vect);
     bool Read_AppId_AppInfo_Index(const uint256& appId, CAppId_AppInfo_IndexValue& appInfo);
     bool Read_AppList_Index(std::vector<uint256>& vAppId);
 
-    bool Write_AppName_AppId_Index(const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect);
-    bool Erase_AppName_AppId_Index(const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect);
+    void Write_AppName_AppId_Index(CDBBatch& batch, const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect);
+    void Erase_AppName_AppId_Index(CDBBatch& batch, const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect);
     bool Read_AppName_AppId_Index(const std::string& strAppName, CName_Id_IndexValue& value);
 
-    bool Write_AppTx_Index(const std::vector<std::pair<CAppTx_IndexKey, int> > &vect);
-    bool Erase_AppTx_Index(const std::vector<std::pair<CAppTx_IndexKey, int> > &vect);
+    void Write_AppTx_Index(CDBBatch& batch, const std::vector<std::pair<CAppTx_IndexKey, int> > &vect);
+    void Erase_AppTx_Index(CDBBatch& batch, const std::vector<std::pair<CAppTx_IndexKey, int> > &vect);
     bool Read_AppTx_Index(const uint256& appId, std::vector<COutPoint>& vOut);
     bool Read_AppTx_Index(const uint256& appId, const std::string& strAddress, std::vector<COutPoint>& vOut);
+    /** Add the app txids to page, strAddress empty means any address */
+    bool Read_AppTx_Index(const uint256& appId, const std::string& strAddress, CTxIdPage& page);
     bool Read_AppList_Index(const std::string& strAddress, std::vector<uint256>& vAppId);
 
-    bool Update_Auth_Index(const std::vector<std::pair<CAuth_IndexKey, int> > &vect);
+    void Update_Auth_Index(CDBBatch& batch, const std::vector<std::pair<CAuth_IndexKey, int> > &vect);
     bool Read_Auth_Index(const uint256& appId, const std::string& strAddress, std::map<uint32_t, int>& mapAuth);
 
-    bool Write_AssetId_AssetInfo_Index(const std::vector<std::pair<uint256, CAssetId_AssetInfo_IndexValue> > &vect);
-    bool Erase_AssetId_AssetInfo_Index(const std::vector<std::pair<uint256, CAssetId_AssetInfo_IndexValue> > &vect);
+    void Write_AssetId_AssetInfo_Index(CDBBatch& batch, const std::vector<std::pair<uint256, CAssetId_AssetInfo_IndexValue> > &vect);
+    void Erase_AssetId_AssetInfo_Index(CDBBatch& batch, const std::vector<std::pair<uint256, CAssetId_AssetInfo_IndexValue> > &vect);
     bool Read_AssetId_AssetInfo_Index(const uint256& assetId, CAssetId_AssetInfo_IndexValue& assetInfo);
     bool Read_AssetList_Index(std::vector<uint256>& vAssetId);
 
-    bool Write_ShortName_AssetId_Index(const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect);
-    bool Erase_ShortName_AssetId_Index(const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect);
+    void Write_ShortName_AssetId_Index(CDBBatch& batch, const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect);
+    void Erase_ShortName_AssetId_Index(CDBBatch& batch, const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect);
     bool Read_ShortName_AssetId_Index(const std::string& strShortName, CName_Id_IndexValue& value);
 
-    bool Write_AssetName_AssetId_Index(const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect);
-    bool Erase_AssetName_AssetId_Index(const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect);
+    void Write_AssetName_AssetId_Index(CDBBatch& batch, const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect);
+    void Erase_AssetName_AssetId_Index(CDBBatch& batch, const std::vector<std::pair<std::string, CName_Id_IndexValue> > &vect);
     bool Read_AssetName_AssetId_Index(const std::string& strAssetName, CName_Id_IndexValue& value);
 
-    bool Write_AssetTx_Index(const std::vector<std::pair<CAssetTx_IndexKey, int> > &vect);
-    bool Erase_AssetTx_Index(const std::vector<std::pair<CAssetTx_IndexKey, int> > &vect);
+    void Write_AssetTx_Index(CDBBatch& batch, const std::vector<std::pair<CAssetTx_IndexKey, int> > &vect);
+    void Erase_AssetTx_Index(CDBBatch& batch, const std::vector<std::pair<CAssetTx_IndexKey, int> > &vect);
     bool Read_AssetTx_Index(const uint256& assetId, const uint8_t& nTxClass, std::vector<COutPoint>& vOut);
     bool Read_AssetTx_Index(const uint256& assetId, const std::string& strAddress, const uint8_t& nTxClass, std::vector<COutPoint>& vOut);
+    /** Add the asset txids of nTxClass to page, strAddress empty means any address */
+    bool Read_AssetTx_Index(const uint256& assetId, const std::string& strAddress, const uint8_t& nTxClass, CTxIdPage& page);
     bool Read_AssetList_Index(const std::string& strAddress, std::vector<uint256>& vAssetId);
 
-    bool Write_PutCandy_Index(const std::vector<std::pair<CPutCandy_IndexKey, CPutCandy_IndexValue> > &vect);
-    bool Erase_PutCandy_Index(const std::vector<std::pair<CPutCandy_IndexKey, CPutCandy_IndexValue> > &vect);
+    void Write_PutCandy_Index(CDBBatch& batch, const std::vector<std::pair<CPutCandy_IndexKey, CPutCandy_IndexValue> > &vect);
+    void Erase_PutCandy_Index(CDBBatch& batch, const std::vector<std::pair<CPutCandy_IndexKey, CPutCandy_IndexValue> > &vect);
     bool Read_PutCandy_Index(const uint256& assetId, std::map<COutPoint, CCandyInfo>& mapCandyInfo);
     bool Read_PutCandy_Index(const uint256& assetId, const COutPoint& out, CCandyInfo& candyInfo);
     bool Read_PutCandy_Index(std::map<CPutCandy_IndexKey, CPutCandy_IndexValue>& mapCandy);
 
-    bool Write_GetCandy_Index(const std::vector<std::pair<CGetCandy_IndexKey, CGetCandy_IndexValue> >& vect);
-    bool Erase_GetCandy_Index(const std::vector<std::pair<CGetCandy_IndexKey, CGetCandy_IndexValue> >& vect);
+    void Write_GetCandy_Index(CDBBatch& batch, const std::vector<std::pair<CGetCandy_IndexKey, CGetCandy_IndexValue> >& vect);
+    void Erase_GetCandy_Index(CDBBatch& batch, const std::vector<std::pair<CGetCandy_IndexKey, CGetCandy_IndexValue> >& vect);
     bool Read_GetCandy_Index(const uint256& assetId, const COutPoint& out, const std::string& strAddress, CAmount& amount);
     bool Read_GetCandy_Index(const uint256& assetId, std::map<COutPoint, std::vector<std::string> > &mapOutAddress);
     bool Read_GetCandy_Index(const uint256& assetId, const std::string& straddress, std::vector<COutPoint>& vOut);
@@ -150,19 +159,28 @@ public:
     bool Write_CandyHeight_Index(const int& nHeight);
     bool Read_CandyHeight_Index(std::vector<int>& vHeight);
 
-    bool Write_GetCandyCount_Index(const CGetCandyCount_IndexKey& key,const CGetCandyCount_IndexValue& value);
-    bool Erase_GetCandyCount_Index(const CGetCandyCount_IndexKey& key);
+    void Write_GetCandyCount_Index(CDBBatch& batch, const CGetCandyCount_IndexKey& key,const CGetCandyCount_IndexValue& value);
+    void Erase_GetCandyCount_Index(CDBBatch& batch, const CGetCandyCount_IndexKey& key);
     bool Read_GetCandyCount_Index(const uint256& assetId, const COutPoint& out,CGetCandyCount_IndexValue& getCandyCountvalue);
     bool Is_Exists_GetCandyCount_Key(const uint256& assetId, const COutPoint& out);
 
-    bool Write_MasternodePayee_Index(const std::string& strPubKeyCollateralAddress, const CMasternodePayee_IndexValue& value);
-    bool Erase_MasternodePayee_Index(const std::string& strPubKeyCollateralAddress);
+    void Write_MasternodePayee_Index(CDBBatch& batch, const std::string& strPubKeyCollateralAddress, const CMasternodePayee_IndexValue& value);
+    void Erase_MasternodePayee_Index(CDBBatch& batch, const std::string& strPubKeyCollateralAddress);
     bool Read_MasternodePayee_Index(const std::string& strPubKeyCollateralAddress, CMasternodePayee_IndexValue& value);
     bool Read_MasternodePayee_Index(std::map<std::string,CMasternodePayee_IndexValue>& mapPayeeInfo);
     bool Is_Exists_MasternodePayee_Key(const std::string& strPubKeyCollateralAddress);
 
-    bool Write_LocalStartSavePayeeHeight_Index(const int& nHeight);
+    void Write_LocalStartSavePayeeHeight_Index(CDBBatch& batch, const int& nHeight);
     bool Read_LocalStartSavePayeeHeight_Index(int& nHeight);
+
+    /** Apply the received and sent deltas of a block, fails on overflow */
+    bool Update_AddressAssetBalance_Index(CDBBatch& batch, const std::map<CAddressAssetBalance_IndexKey, CAddressAssetBalance_IndexValue>& mapDelta);
+    bool Update_AddressAssetLocked_Index(CDBBatch& batch, const std::map<CAddressAssetLocked_IndexKey, CAssetAmount>& mapDelta);
+    /** Read the totals of strAddress in assetId, and the amount still locked at nHeight */
+    bool Read_AddressAssetBalance_Index(const std::string& strAddress, const uint256& assetId, const int& nHeight, CAddressAssetBalance_IndexValue& value, CAssetAmount& nLocked);
+
+    /** Build the address keyed asset tx, app tx and get candy indexes of a database created before they existed */
+    bool Upgrade_AddressTx_Index();
 };
 
 #endif // BITCOIN_TXDB_H
@@ -617,18 +617,19 @@ void CTxMemPool::addAppInfoIndex(const CTxMemPoolEntry& entry, const CCoinsViewC
     {
         const CTxOut& txout = tx.vout[i];
 
-        CAppHeader header;
-        std::vector<unsigned char> vData;
-        if(ParseReserve(txout.vReserve, header, vData))
+        CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+        if(payload)
         {
+            const CAppHeader& header = payload->header;
+
             CTxDestination dest;
             if(!ExtractDestination(txout.scriptPubKey, dest))
                 continue;
 
             if(header.nAppCmd == REGISTER_APP_CMD)
             {
-                CAppData appData;
-                if(ParseRegisterData(vData, appData))
+                const CAppData& appData = payload->GetAppData();
+                if(payload->fBody)
                 {
                     mapAppId_AppInfo.insert(make_pair(header.appId, CAppId_AppInfo_IndexValue(CBitcoinAddress(dest).ToString(), appData)));
                     appId_inserted.push_back(header.appId);
@@ -721,6 +722,21 @@ bool CAppTx_IndexKeyCompare::operator()(const CAppTx_IndexKey& a, const CAppTx_I
     return a.appId < b.appId;
 }
 
+bool CAppTx_AddressKeyCompare::operator()(const CAppTx_IndexKey& a, const CAppTx_IndexKey& b) const
+{
+    if(a.strAddress == b.strAddress)
+    {
+        if(a.appId == b.appId)
+        {
+            if(a.nTxClass == b.nTxClass)
+                return a.out < b.out;
+            return a.nTxClass < b.nTxClass;
+        }
+        return a.appId < b.appId;
+    }
+    return a.strAddress < b.strAddress;
+}
+
 void CTxMemPool::add_AppTx_Index(const CTxMemPoolEntry& entry, const CCoinsViewCache& view)
 {
     LOCK(cs);
@@ -732,10 +748,11 @@ void CTxMemPool::add_AppTx_Index(const CTxMemPoolEntry& entry, const CCoinsViewC
     {
         const CTxOut& txout = tx.vout[i];
 
-        CAppHeader header;
-        std::vector<unsigned char> vData;
-        if(ParseReserve(txout.vReserve, header, vData))
+        CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+        if(payload)
         {
+            const CAppHeader& header = payload->header;
+
             CTxDestination dest;
             if(!ExtractDestination(txout.scriptPubKey, dest))
                 continue;
@@ -754,6 +771,7 @@ void CTxMemPool::add_AppTx_Index(const CTxMemPoolEntry& entry, const CCoinsViewC
 
             CAppTx_IndexKey key(header.appId, CBitcoinAddress(dest).ToString(), nTxClass, COutPoint(txhash, i));
             mapAppTx.insert(make_pair(key, -1));
+            setAppTx_Address.insert(key);
             inserted.push_back(key);
         }
     }
@@ -765,21 +783,19 @@ void CTxMemPool::add_AppTx_Index(const CTxMemPoolEntry& entry, const CCoinsViewC
 bool CTxMemPool::get_AppTx_Index(const uint256& appId, std::vector<COutPoint>& vOut)
 {
     LOCK(cs);
-    for(mapAppTx_Index::const_iterator it = mapAppTx.begin(); it != mapAppTx.end(); it++)
-    {
-        if(it->first.appId == appId)
-            vOut.push_back(it->first.out);
-    }
+    for(mapAppTx_Index::const_iterator it = mapAppTx.lower_bound(CAppTx_IndexKey(appId)); it != mapAppTx.end() && it->first.appId == appId; it++)
+        vOut.push_back(it->first.out);
     return vOut.size();
 }
 
 bool CTxMemPool::get_AppTx_Index(const uint256& appId, const std::string& strAddress, std::vector<COutPoint>& vOut)
 {
     LOCK(cs);
-    for(mapAppTx_Index::const_iterator it = mapAppTx.begin(); it != mapAppTx.end(); it++)
+    for(mapAppTx_Index::const_iterator it = mapAppTx.lower_bound(CAppTx_IndexKey(appId, strAddress)); it != mapAppTx.end(); it++)
     {
-        if(it->first.appId == appId && it->first.strAddress == strAddress)
-            vOut.push_back(it->first.out);
+        if(it->first.appId != appId || it->first.strAddress != strAddress)
+            break;
+        vOut.push_back(it->first.out);
     }
     return vOut.size();
 }
@@ -787,10 +803,10 @@ bool CTxMemPool::get_AppTx_Index(const uint256& appId, const std::string& strAdd
 bool CTxMemPool::getAppList(const std::string& strAddress, std::vector<uint256>& vAppId)
 {
     LOCK(cs);
-    for(mapAppTx_Index::const_iterator it = mapAppTx.begin(); it != mapAppTx.end(); it++)
+    for(setAppTx_AddressIndex::const_iterator it = setAppTx_Address.lower_bound(CAppTx_IndexKey(uint256(), strAddress)); it != setAppTx_Address.end() && it->strAddress == strAddress; it++)
     {
-        if(it->first.strAddress == strAddress)
-            vAppId.push_back(it->first.appId);
+        if(vAppId.empty() || vAppId.back() != it->appId)
+            vAppId.push_back(it->appId);
     }
     return vAppId.size();
 }
@@ -804,8 +820,8 @@ bool CTxMemPool::remove_AppTx_Index(const uint256& txhash)
         std::vector<CAppTx_IndexKey> keys = (*it).second;
         for(std::vector<CAppTx_IndexKey>::iterator mit = keys.begin(); mit != keys.end(); mit++)
         {
-            if(mapAppTx.find(*mit) != mapAppTx.end())
-                mapAppTx.erase(*mit);
+            mapAppTx.erase(*mit);
+            setAppTx_Address.erase(*mit);
         }
         mapAppTx_Inserted.erase(it);
     }
@@ -834,14 +850,15 @@ void CTxMemPool::add_Auth_Index(const CTxMemPoolEntry& entry, const CCoinsViewCa
     {
         const CTxOut& txout = tx.vout[i];
 
-        CAppHeader header;
-        std::vector<unsigned char> vData;
-        if(ParseReserve(txout.vReserve, header, vData))
+        CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+        if(payload)
         {
+            const CAppHeader& header = payload->header;
+
             if(header.nAppCmd == ADD_AUTH_CMD || header.nAppCmd == DELETE_AUTH_CMD)
             {
-                CAuthData authData;
-                if(ParseAuthData(vData, authData))
+                const CAuthData& authData = payload->GetAuthData();
+                if(payload->fBody)
                 {
                     CAuth_IndexKey key(header.appId, authData.strUserAddress, authData.nAuth);
                     mapAuth.insert(make_pair(key, -1));
@@ -897,20 +914,21 @@ void CTxMemPool::addAssetInfoIndex(const CTxMemPoolEntry& entry, const CCoinsVie
     {
         const CTxOut& txout = tx.vout[i];
 
-        CAppHeader header;
-        std::vector<unsigned char> vData;
-        if(ParseReserve(txout.vReserve, header, vData))
+        CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+        if(payload)
         {
+            const CAppHeader& header = payload->header;
+
             CTxDestination dest;
             if(!ExtractDestination(txout.scriptPubKey, dest))
                 continue;
 
             if(header.nAppCmd == ISSUE_ASSET_CMD)
             {
-                CAssetData assetData;
-                if(ParseIssueData(vData, assetData))
+                const CAssetData& assetData = payload->GetAssetData();
+                if(payload->fBody)
                 {
-                    uint256 assetId = assetData.GetHash();
+                    const uint256& assetId = payload->assetId;
 
                     mapAssetId_AssetInfo.insert(make_pair(assetId, CAssetId_AssetInfo_IndexValue(CBitcoinAddress(dest).ToString(), assetData, -1)));
                     assetId_inserted.push_back(assetId);
@@ -1031,6 +1049,21 @@ bool CAssetTx_IndexKeyCompare::operator()(const CAssetTx_IndexKey& a, const CAss
     return a.assetId < b.assetId;
 }
 
+bool CAssetTx_AddressKeyCompare::operator()(const CAssetTx_IndexKey& a, const CAssetTx_IndexKey& b) const
+{
+    if(a.strAddress == b.strAddress)
+    {
+        if(a.assetId == b.assetId)
+        {
+            if(a.nTxClass == b.nTxClass)
+                return a.out < b.out;
+            return a.nTxClass < b.nTxClass;
+        }
+        return a.assetId < b.assetId;
+    }
+    return a.strAddress < b.strAddress;
+}
+
 void CTxMemPool::add_AssetTx_Index(const CTxMemPoolEntry& entry, const CCoinsViewCache& view)
 {
     LOCK(cs);
@@ -1042,39 +1075,43 @@ void CTxMemPool::add_AssetTx_Index(const CTxMemPoolEntry& entry, const CCoinsVie
     {
         const CTxOut& txout = tx.vout[i];
 
-        CAppHeader header;
-        std::vector<unsigned char> vData;
-        if(ParseReserve(txout.vReserve, header, vData))
+        CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+        if(payload)
         {
+            const CAppHeader& header = payload->header;
+
             CTxDestination dest;
             if(!ExtractDestination(txout.scriptPubKey, dest))
                 continue;
 
             if(header.nAppCmd == ISSUE_ASSET_CMD)
             {
-                CAssetData assetData;
-                if(ParseIssueData(vData, assetData))
+                const CAssetData& assetData = payload->GetAssetData();
+                if(payload->fBody)
                 {
-                    CAssetTx_IndexKey key(assetData.GetHash(), CBitcoinAddress(dest).ToString(), ISSUE_TXOUT, COutPoint(txhash, i));
+                    CAssetTx_IndexKey key(payload->assetId, CBitcoinAddress(dest).ToString(), ISSUE_TXOUT, COutPoint(txhash, i));
                     mapAssetTx.insert(make_pair(key, -1));
+                    setAssetTx_Address.insert(key);
                     inserted.push_back(key);
                 }
             }
             else if(header.nAppCmd == ADD_ASSET_CMD || header.nAppCmd == TRANSFER_ASSET_CMD || header.nAppCmd == DESTORY_ASSET_CMD)
             {
-                CCommonData commonData;
-                if(ParseCommonData(vData, commonData))
+                const CCommonData& commonData = payload->GetCommonData();
+                if(payload->fBody)
                 {
                     if (header.nAppCmd == ADD_ASSET_CMD)
                     {
                         CAssetTx_IndexKey key(commonData.assetId, CBitcoinAddress(dest).ToString(), ADD_ISSUE_TXOUT, COutPoint(txhash, i));
                         mapAssetTx.insert(make_pair(key, -1));
+                        setAssetTx_Address.insert(key);
                         inserted.push_back(key);
                     }
                     else if (header.nAppCmd == DESTORY_ASSET_CMD)
                     {
                         CAssetTx_IndexKey key(commonData.assetId, CBitcoinAddress(dest).ToString(), DESTORY_TXOUT, COutPoint(txhash, i));
                         mapAssetTx.insert(make_pair(key, -1));
+                        setAssetTx_Address.insert(key);
                         inserted.push_back(key);
                     }
                     else if(header.nAppCmd == TRANSFER_ASSET_CMD)
@@ -1083,12 +1120,14 @@ void CTxMemPool::add_AssetTx_Index(const CTxMemPoolEntry& entry, const CCoinsVie
                         {
                             CAssetTx_IndexKey key(commonData.assetId, CBitcoinAddress(dest).ToString(), LOCKED_TXOUT, COutPoint(txhash, i));
                             mapAssetTx.insert(make_pair(key, -1));
+                            setAssetTx_Address.insert(key);
                             inserted.push_back(key);
                         }
                         else
                         {
                             CAssetTx_IndexKey key(commonData.assetId, CBitcoinAddress(dest).ToString(), TRANSFER_TXOUT, COutPoint(txhash, i));
                             mapAssetTx.insert(make_pair(key, -1));
+                            setAssetTx_Address.insert(key);
                             inserted.push_back(key);
                         }
                     }
@@ -1096,21 +1135,23 @@ void CTxMemPool::add_AssetTx_Index(const CTxMemPoolEntry& entry, const CCoinsVie
             }
             else if(header.nAppCmd == PUT_CANDY_CMD)
             {
-                CPutCandyData candyData;
-                if(ParsePutCandyData(vData, candyData))
+                const CPutCandyData& candyData = payload->GetPutCandyData();
+                if(payload->fBody)
                 {
                     CAssetTx_IndexKey key(candyData.assetId, CBitcoinAddress(dest).ToString(), PUT_CANDY_TXOUT, COutPoint(txhash, i));
                     mapAssetTx.insert(make_pair(key, -1));
+                    setAssetTx_Address.insert(key);
                     inserted.push_back(key);
                 }
             }
             else if(header.nAppCmd == GET_CANDY_CMD)
             {
-                CGetCandyData candyData;
-                if(ParseGetCandyData(vData, candyData))
+                const CGetCandyData& candyData = payload->GetGetCandyData();
+                if(payload->fBody)
                 {
                     CAssetTx_IndexKey key(candyData.assetId, CBitcoinAddress(dest).ToString(), GET_CANDY_TXOUT, COutPoint(txhash, i));
                     mapAssetTx.insert(make_pair(key, -1));
+                    setAssetTx_Address.insert(key);
                     inserted.push_back(key);
                 }
             }
@@ -1124,76 +1165,48 @@ void CTxMemPool::add_AssetTx_Index(const CTxMemPoolEntry& entry, const CCoinsVie
 bool CTxMemPool::get_AssetTx_Index(const uint256& assetId, const uint8_t& nTxClass, std::vector<COutPoint>& vOut)
 {
     LOCK(cs);
-    multimap<int, COutPoint> tmpMap;
-    for(mapAssetTx_Index::const_iterator it = mapAssetTx.begin(); it != mapAssetTx.end(); it++)
+    for(mapAssetTx_Index::const_iterator it = mapAssetTx.lower_bound(CAssetTx_IndexKey(assetId)); it != mapAssetTx.end() && it->first.assetId == assetId; it++)
     {
-        if(it->first.assetId != assetId)
-            continue;
         if(nTxClass == ALL_TXOUT)
-        {
-            tmpMap.insert(make_pair(it->second, it->first.out));
-        }
+            vOut.push_back(it->first.out);
         else if(nTxClass == UNLOCKED_TXOUT)
         {
-            if(it->first.nTxClass == LOCKED_TXOUT)
-                continue;
-            tmpMap.insert(make_pair(it->second, it->first.out));
+            if(it->first.nTxClass != LOCKED_TXOUT)
+                vOut.push_back(it->first.out);
         }
         else if(it->first.nTxClass == nTxClass)
-        {
-            tmpMap.insert(make_pair(it->second, it->first.out));
-        }
+            vOut.push_back(it->first.out);
     }
-
-    for(multimap<int, COutPoint>::iterator iter = tmpMap.begin(); iter != tmpMap.end(); ++iter)
-        vOut.push_back(iter->second);
-
-    multimap<int,COutPoint>().swap(tmpMap);
-
     return vOut.size();
 }
 
 bool CTxMemPool::get_AssetTx_Index(const uint256& assetId, const std::string& strAddress, const uint8_t& nTxClass, std::vector<COutPoint>& vOut)
 {
     LOCK(cs);
-    multimap<int, COutPoint> tmpMap;
-    for(mapAssetTx_Index::const_iterator it = mapAssetTx.begin(); it != mapAssetTx.end(); it++)
+    for(mapAssetTx_Index::const_iterator it = mapAssetTx.lower_bound(CAssetTx_IndexKey(assetId, strAddress)); it != mapAssetTx.end(); it++)
     {
         if(it->first.assetId != assetId || it->first.strAddress != strAddress)
-            continue;
-
+            break;
         if(nTxClass == ALL_TXOUT)
-        {
-            tmpMap.insert(make_pair(it->second, it->first.out));
-        }
+            vOut.push_back(it->first.out);
         else if(nTxClass == UNLOCKED_TXOUT)
         {
-            if(it->first.nTxClass == LOCKED_TXOUT)
-                continue;
-            tmpMap.insert(make_pair(it->second, it->first.out));
+            if(it->first.nTxClass != LOCKED_TXOUT)
+                vOut.push_back(it->first.out);
         }
         else if(it->first.nTxClass == nTxClass)
-        {
-            tmpMap.insert(make_pair(it->second, it->first.out));
-        }
-    }
-
-    for(multimap<int, COutPoint>::iterator iter = tmpMap.begin(); iter != tmpMap.end(); ++iter){
-        vOut.push_back(iter->second);
+            vOut.push_back(it->first.out);
     }
-
-    multimap<int, COutPoint>().swap(tmpMap);
-
     return vOut.size();
 }
 
 bool CTxMemPool::getAssetList(const std::string& strAddress, std::vector<uint256>& vAssetId)
 {
     LOCK(cs);
-    for(mapAssetTx_Index::const_iterator it = mapAssetTx.begin(); it != mapAssetTx.end(); it++)
+    for(setAssetTx_AddressIndex::const_iterator it = setAssetTx_Address.lower_bound(CAssetTx_IndexKey(uint256(), strAddress)); it != setAssetTx_Address.end() && it->strAddress == strAddress; it++)
     {
-        if (it->first.strAddress == strAddress)
-            vAssetId.push_back(it->first.assetId);
+        if(vAssetId.empty() || vAssetId.back() != it->assetId)
+            vAssetId.push_back(it->assetId);
     }
     return vAssetId.size();
 }
@@ -1207,8 +1220,8 @@ bool CTxMemPool::remove_AssetTx_Index(const uint256& txhash)
         std::vector<CAssetTx_IndexKey> keys = (*it).second;
         for(std::vector<CAssetTx_IndexKey>::iterator mit = keys.begin(); mit != keys.end(); mit++)
         {
-            if(mapAssetTx.find(*mit) != mapAssetTx.end())
-                mapAssetTx.erase(*mit);
+            mapAssetTx.erase(*mit);
+            setAssetTx_Address.erase(*mit);
         }
         mapAssetTx_Inserted.erase(it);
     }
@@ -1219,10 +1232,10 @@ int CTxMemPool::get_PutCandy_count(const uint256 &assetId)
 {
     LOCK(cs);
     int nCount = 0;
-    for(mapAssetTx_Index::const_iterator it = mapAssetTx.begin(); it != mapAssetTx.end(); it++)
+    for(mapAssetTx_Index::const_iterator it = mapAssetTx.lower_bound(CAssetTx_IndexKey(assetId, g_strPutCandyAddress, PUT_CANDY_TXOUT)); it != mapAssetTx.end(); it++)
     {
         if(it->first.assetId != assetId || it->first.strAddress != g_strPutCandyAddress || it->first.nTxClass != PUT_CANDY_TXOUT)
-            continue;
+            break;
         nCount++;
     }
     return nCount;
@@ -1259,17 +1272,18 @@ void CTxMemPool::add_GetCandy_Index(const CTxMemPoolEntry& entry, const CCoinsVi
     {
         const CTxOut& txout = tx.vout[i];
 
-        CAppHeader header;
-        std::vector<unsigned char> vData;
-        if(ParseReserve(txout.vReserve, header, vData))
+        CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+        if(payload)
         {
+            const CAppHeader& header = payload->header;
+
             CTxDestination dest;
             if(!ExtractDestination(txout.scriptPubKey, dest))
                 continue;
             if(header.nAppCmd == GET_CANDY_CMD)
             {
-                CGetCandyData candyData;
-                if(ParseGetCandyData(vData, candyData))
+                const CGetCandyData& candyData = payload->GetGetCandyData();
+                if(payload->fBody)
                 {
                     for(unsigned int m = 0; m < tx.vin.size(); m++)
                     {
@@ -1297,17 +1311,12 @@ void CTxMemPool::add_GetCandy_Index(const CTxMemPoolEntry& entry, const CCoinsVi
 bool CTxMemPool::get_GetCandy_Index(const uint256& assetId, const COutPoint& out, const std::string& strAddress, CAmount& nAmount)
 {
     LOCK(cs);
-    for(mapGetCandy_Index::const_iterator it = mapGetCandy.begin(); it != mapGetCandy.end(); it++)
-    {
-        const CGetCandy_IndexKey& key = it->first;
-        if(key.assetId == assetId && key.out == out && key.strAddress == strAddress)
-        {
-            nAmount = it->second.nAmount;
-            return true;
-        }
-    }
+    mapGetCandy_Index::const_iterator it = mapGetCandy.find(CGetCandy_IndexKey(assetId, out, strAddress));
+    if(it == mapGetCandy.end())
+        return false;
 
-    return false;
+    nAmount = it->second.nAmount;
+    return true;
 }
 
 bool CTxMemPool::remove_GetCandy_Index(const uint256& txhash)
@@ -1340,17 +1349,18 @@ void CTxMemPool::add_GetCandyCount_Index(const CTxMemPoolEntry& entry, const CCo
     {
         const CTxOut& txout = tx.vout[i];
 
-        CAppHeader header;
-        std::vector<unsigned char> vData;
-        if(ParseReserve(txout.vReserve, header, vData))
+        CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+        if(payload)
         {
+            const CAppHeader& header = payload->header;
+
             CTxDestination dest;
             if(!ExtractDestination(txout.scriptPubKey, dest))
                 continue;
             if(header.nAppCmd == GET_CANDY_CMD)
             {
-                CGetCandyData candyData;
-                if(ParseGetCandyData(vData, candyData))
+                const CGetCandyData& candyData = payload->GetGetCandyData();
+                if(payload->fBody)
                 {
                     for(unsigned int m = 0; m < tx.vin.size(); m++)
                     {
@@ -278,6 +278,12 @@ struct CAppTx_IndexKeyCompare
     bool operator()(const CAppTx_IndexKey& a, const CAppTx_IndexKey& b) const;
 };
 
+/** Order app tx keys by address first, then by app id, class and outpoint */
+struct CAppTx_AddressKeyCompare
+{
+    bool operator()(const CAppTx_IndexKey& a, const CAppTx_IndexKey& b) const;
+};
+
 struct CAuth_IndexKeyCompare
 {
     bool operator()(const CAuth_IndexKey& a, const CAuth_IndexKey& b) const;
@@ -288,6 +294,12 @@ struct CAssetTx_IndexKeyCompare
     bool operator()(const CAssetTx_IndexKey& a, const CAssetTx_IndexKey& b) const;
 };
 
+/** Order asset tx keys by address first, then by asset id, class and outpoint */
+struct CAssetTx_AddressKeyCompare
+{
+    bool operator()(const CAssetTx_IndexKey& a, const CAssetTx_IndexKey& b) const;
+};
+
 struct CGetCandy_IndexKeyCompare
 {
     bool operator()(const CGetCandy_IndexKey& a, const CGetCandy_IndexKey& b) const;
@@ -483,6 +495,8 @@ private:
 
     typedef std::map<CAppTx_IndexKey, int, CAppTx_IndexKeyCompare> mapAppTx_Index;
     mapAppTx_Index mapAppTx;
+    typedef std::set<CAppTx_IndexKey, CAppTx_AddressKeyCompare> setAppTx_AddressIndex;
+    setAppTx_AddressIndex setAppTx_Address; // the keys of mapAppTx ordered by address
     typedef std::map<uint256, std::vector<CAppTx_IndexKey> > mapAppTx_IndexInserted;
     mapAppTx_IndexInserted mapAppTx_Inserted;
 
@@ -508,6 +522,8 @@ private:
 
     typedef std::map<CAssetTx_IndexKey, int, CAssetTx_IndexKeyCompare> mapAssetTx_Index;
     mapAssetTx_Index mapAssetTx;
+    typedef std::set<CAssetTx_IndexKey, CAssetTx_AddressKeyCompare> setAssetTx_AddressIndex;
+    setAssetTx_AddressIndex setAssetTx_Address; // the keys of mapAssetTx ordered by address
     typedef std::map<uint256, std::vector<CAssetTx_IndexKey> > mapAssetTx_IndexInserted;
     mapAssetTx_IndexInserted mapAssetTx_Inserted;
 
@@ -772,17 +788,4 @@ public:
     bool HaveCoins(const uint256 &txid) const;
 };
 
-// We want to sort transactions by coin age priority
-typedef std::pair<double, CTxMemPool::txiter> TxCoinAgePriority;
-
-struct TxCoinAgePriorityCompare
-{
-    bool operator()(const TxCoinAgePriority& a, const TxCoinAgePriority& b)
-    {
-        if (a.first == b.first)
-            return CompareTxMemPoolEntryByScore()(*(b.second), *(a.second)); //Reverse order to make sort less than
-        return a.first < b.first;
-    }
-};
-
 #endif // BITCOIN_TXMEMPOOL_H
@@ -40,7 +40,9 @@
 #include "validationinterface.h"
 #include "versionbits.h"
 #include "base58.h"
+#include "candysnapshot.h"
 #include "main.h"
+#include "miner.h"
 #include "rpc/server.h"
 #include "masternode-sync.h"
 #include "messagesigner.h"
@@ -52,6 +54,8 @@
 #endif
 
 #include "instantx.h"
+#include "limitedmap.h"
+#include "lrucache.h"
 #include "masternodeman.h"
 #include "masternode-payments.h"
 #include "activemasternode.h"
@@ -74,6 +78,15 @@ using namespace std;
 #define BATCH_COUNT         10000
 #define HANDLE_COUNT        20000
 
+/** Maximum number of threads building missing candy change info at startup */
+static const int MAX_CHANGE_INFO_THREADS = 8;
+/** Blocks each thread builds per batch before the batch is committed in order */
+static const int CHANGE_INFO_BLOCKS_PER_THREAD = 16;
+/** Number of recent transaction heights kept to resolve spent outputs without the transaction index */
+static const size_t CHANGE_INFO_TX_HEIGHT_CACHE = 1000000;
+/** Number of confirmed transactions kept decoded for GetTransaction */
+static const size_t TX_LOOKUP_CACHE_SIZE = 20000;
+
 /**
  * Global state
  */
@@ -93,6 +106,7 @@ bool fTxIndex = true;
 bool fAddressIndex = false;
 bool fTimestampIndex = false;
 bool fSpentIndex = false;
+bool fAddressAssetBalanceIndex = false;
 bool fHavePruned = false;
 bool fPruneMode = false;
 bool fIsBareMultisigStd = DEFAULT_PERMIT_BAREMULTISIG;
@@ -169,9 +183,6 @@ extern bool g_fReceiveBlock;
 std::mutex g_mutexAllPayeeInfo;
 std::map<std::string,CMasternodePayee_IndexValue> gAllPayeeInfoMap;
 
-const static int M = 2000; //Maximum number of digits
-int numA[M];
-int numB[M];
 
 std::atomic<bool> fDIP0001WasLockedIn{false};
 std::atomic<bool> fDIP0001ActiveAtTip{false};
@@ -736,7 +747,7 @@ bool CheckTransaction(const CTransaction& tx, CValidationState &state, const enu
             }
         }
 
-        const std::vector<unsigned char>& vReserve = txout.vReserve;
+        const CTxOutReserve& vReserve = txout.vReserve;
         if(tx.IsCoinBase())
         {
             if(IsProtocolV0(nTxHeight))
@@ -762,7 +773,7 @@ bool CheckTransaction(const CTransaction& tx, CValidationState &state, const enu
             }
             else if(tx.nVersion >= SAFE_TX_VERSION_2)
             {
-                const std::vector<unsigned char>& vReserve = txout.vReserve;
+                const CTxOutReserve& vReserve = txout.vReserve;
                 if(txout.nUnlockedHeight < 0 ||
                    vReserve.size() < TXOUT_RESERVE_MIN_SIZE || vReserve.size() > TXOUT_RESERVE_MAX_SIZE ||
                    vReserve[0] != 's' || vReserve[1] != 'a' || vReserve[2] != 'f' || vReserve[3] != 'e')
@@ -847,10 +858,10 @@ bool CheckAppTransaction(const CTransaction& tx, CValidationState &state, const
     for(unsigned int i = 0; i < tx.vout.size(); i++)
     {
         const CTxOut& txout = tx.vout[i];
-        CAppHeader header;
-        vector<unsigned char> vData;
-        if(!ParseReserve(txout.vReserve, header, vData))
+        CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+        if(!payload)
             continue;
+        const CAppHeader& header = payload->header;
 
         if(header.appId.IsNull())
             return state.DoS(50, false, REJECT_INVALID, "app_tx/asset_tx: app id is null");
@@ -859,18 +870,18 @@ bool CheckAppTransaction(const CTransaction& tx, CValidationState &state, const
 
         if(header.nAppCmd == ISSUE_ASSET_CMD)
         {
-            CAssetData assetData;
-            if(!ParseIssueData(vData, assetData))
+            const CAssetData& assetData = payload->GetAssetData();
+            if(!payload->fBody)
                 return state.DoS(50, false, REJECT_INVALID, "asset_tx: parse issue txout reserve failed");
-            uint256 assetId = assetData.GetHash();
+            const uint256& assetId = payload->assetId;
             if(assetId.IsNull())
                 return state.DoS(50, false, REJECT_INVALID, "issue_asset: asset id is null, " + strprintf("%s-%d", tx.GetHash().GetHex(), i));
             mapAssetId[assetId]++;
         }
         else if(header.nAppCmd == ADD_ASSET_CMD)
         {
-            CCommonData addData;
-            if(!ParseCommonData(vData, addData))
+            const CCommonData& addData = payload->GetCommonData();
+            if(!payload->fBody)
                 return state.DoS(50, false, REJECT_INVALID, "asset_tx: parse add txout reserve failed");
             if(addData.assetId.IsNull())
                 return state.DoS(50, false, REJECT_INVALID, "add_asset: asset id is null, " + strprintf("%s-%d", tx.GetHash().GetHex(), i));
@@ -878,8 +889,8 @@ bool CheckAppTransaction(const CTransaction& tx, CValidationState &state, const
         }
         else if(header.nAppCmd == TRANSFER_ASSET_CMD)
         {
-            CCommonData transferData;
-            if(!ParseCommonData(vData, transferData))
+            const CCommonData& transferData = payload->GetCommonData();
+            if(!payload->fBody)
                 return state.DoS(50, false, REJECT_INVALID, "asset_tx: parse transfer txout reserve failed");
             if(transferData.assetId.IsNull())
                 return state.DoS(50, false, REJECT_INVALID, "transfer_asset: asset id is null, " + strprintf("%s-%d", tx.GetHash().GetHex(), i));
@@ -887,8 +898,8 @@ bool CheckAppTransaction(const CTransaction& tx, CValidationState &state, const
         }
         else if(header.nAppCmd == DESTORY_ASSET_CMD)
         {
-            CCommonData destoryData;
-            if(!ParseCommonData(vData, destoryData))
+            const CCommonData& destoryData = payload->GetCommonData();
+            if(!payload->fBody)
                 return state.DoS(50, false, REJECT_INVALID, "asset_tx: parse destory txout reserve failed");
             if(destoryData.assetId.IsNull())
                 return state.DoS(50, false, REJECT_INVALID, "destory_asset: asset id is null, " + strprintf("%s-%d", tx.GetHash().GetHex(), i));
@@ -896,8 +907,8 @@ bool CheckAppTransaction(const CTransaction& tx, CValidationState &state, const
         }
         else if(header.nAppCmd == CHANGE_ASSET_CMD)
         {
-            CCommonData changeData;
-            if(!ParseCommonData(vData, changeData))
+            const CCommonData& changeData = payload->GetCommonData();
+            if(!payload->fBody)
                 return state.DoS(50, false, REJECT_INVALID, "asset_tx: parse change txout reserve failed");
             if(changeData.assetId.IsNull())
                 return state.DoS(50, false, REJECT_INVALID, "change_asset: asset id is null, " + strprintf("%s-%d", tx.GetHash().GetHex(), i));
@@ -905,8 +916,8 @@ bool CheckAppTransaction(const CTransaction& tx, CValidationState &state, const
         }
         else if(header.nAppCmd == PUT_CANDY_CMD)
         {
-            CPutCandyData putData;
-            if(!ParsePutCandyData(vData, putData))
+            const CPutCandyData& putData = payload->GetPutCandyData();
+            if(!payload->fBody)
                 return state.DoS(50, false, REJECT_INVALID, "asset_tx: parse putcandy txout reserve failed");
             if(putData.assetId.IsNull())
                 return state.DoS(50, false, REJECT_INVALID, "put_candy: asset id is null, " + strprintf("%s-%d", tx.GetHash().GetHex(), i));
@@ -923,8 +934,8 @@ bool CheckAppTransaction(const CTransaction& tx, CValidationState &state, const
             else
                return state.DoS(50, false, REJECT_INVALID, "get_candy: the output address already exists.");
 
-            CGetCandyData getData;
-            if(!ParseGetCandyData(vData, getData))
+            const CGetCandyData& getData = payload->GetGetCandyData();
+            if(!payload->fBody)
                 return state.DoS(50, false, REJECT_INVALID, "asset_tx: parse getcandy txout reserve failed");
             if(getData.assetId.IsNull())
                 return state.DoS(50, false, REJECT_INVALID, "get_candy: asset id is null, " + strprintf("%s-%d", tx.GetHash().GetHex(), i));
@@ -2755,7 +2766,10 @@ bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState &state, const C
     }
 
     if(!fDryRun)
+    {
         GetMainSignals().SyncTransaction(tx, NULL);
+        GetMainSignals().TransactionAddedToMempool(tx);
+    }
 
     return true;
 }
@@ -2825,18 +2839,56 @@ bool GetAddressUnspent(uint160 addressHash, int type,
     return true;
 }
 
-/** Return transaction in tx, and if it was found inside a block, its hash is placed in hashBlock */
-bool GetTransaction(const uint256 &hash, CTransaction &txOut, const Consensus::Params& consensusParams, uint256 &hashBlock, bool fAllowSlow)
+struct CTxidShardHasher
 {
-    CBlockIndex *pindexSlow = NULL;
+    size_t operator()(const uint256& txid) const { return txid.GetCheapHash(); }
+};
+
+/** Recently read confirmed transactions with the hash of their block */
+static CShardedLRUCache<uint256, std::pair<boost::shared_ptr<const CTransaction>, uint256>, CTxidShardHasher> txLookupCache(TX_LOOKUP_CACHE_SIZE);
 
+/** Hash of the active chain block whose header is header and whose data is at pos, without hashing the header */
+static bool GetActiveBlockHash(const CBlockHeader& header, const CDiskBlockPos& pos, uint256& hashBlock)
+{
     LOCK(cs_main);
+    BlockMap::const_iterator mi = mapBlockIndex.find(header.hashPrevBlock);
+    if(mi == mapBlockIndex.end() || !chainActive.Contains(mi->second))
+        return false;
+    const CBlockIndex* pindex = chainActive.Next(mi->second);
+    if(!pindex || !(pindex->nStatus & BLOCK_HAVE_DATA) || pindex->nFile != pos.nFile || pindex->nDataPos != pos.nPos)
+        return false;
+    hashBlock = pindex->GetBlockHash();
+    return true;
+}
 
+/**
+ * Return transaction in txOut, and if it was found inside a block, its hash is placed in hashBlock.
+ * With the transaction index, cs_main is only held for short block index lookups and
+ * the transaction is read from disk outside of it.
+ */
+bool GetTransaction(const uint256 &hash, CTransaction &txOut, const Consensus::Params& consensusParams, uint256 &hashBlock, bool fAllowSlow)
+{
     if (mempool.lookup(hash, txOut))
     {
         return true;
     }
 
+    std::pair<boost::shared_ptr<const CTransaction>, uint256> cached;
+    if (txLookupCache.Get(hash, cached)) {
+        bool fActive = false;
+        {
+            LOCK(cs_main);
+            BlockMap::const_iterator mi = mapBlockIndex.find(cached.second);
+            fActive = mi != mapBlockIndex.end() && chainActive.Contains(mi->second);
+        }
+        if (fActive) {
+            txOut = *cached.first;
+            hashBlock = cached.second;
+            return true;
+        }
+        txLookupCache.Erase(hash);
+    }
+
     if (fTxIndex) {
         CDiskTxPos postx;
         if (pblocktree->ReadTxIndex(hash, postx)) {
@@ -2851,14 +2903,21 @@ bool GetTransaction(const uint256 &hash, CTransaction &txOut, const Consensus::P
             } catch (const std::exception& e) {
                 return error("%s: Deserialize or I/O error - %s", __func__, e.what());
             }
-            hashBlock = header.GetHash();
             if (txOut.GetHash() != hash)
                 return error("%s: txid mismatch", __func__);
+            // only transactions of the active chain are cached, a stale block has to be hashed
+            if (GetActiveBlockHash(header, postx, hashBlock))
+                txLookupCache.Insert(hash, std::make_pair(boost::shared_ptr<const CTransaction>(new CTransaction(txOut)), hashBlock));
+            else
+                hashBlock = header.GetHash();
             return true;
         }
     }
 
     if (fAllowSlow) { // use coin database to locate block that contains transaction, and scan it
+        // reading a block checks its header against mapBlockIndex, so the slow path keeps cs_main
+        LOCK(cs_main);
+        CBlockIndex *pindexSlow = NULL;
         int nHeight = -1;
         {
             CCoinsViewCache &view = *pcoinsTip;
@@ -2868,15 +2927,14 @@ bool GetTransaction(const uint256 &hash, CTransaction &txOut, const Consensus::P
         }
         if (nHeight > 0)
             pindexSlow = chainActive[nHeight];
-    }
 
-    if (pindexSlow) {
         CBlock block;
-        if (ReadBlockFromDisk(block, pindexSlow, consensusParams)) {
+        if (pindexSlow && ReadBlockFromDisk(block, pindexSlow, consensusParams)) {
             BOOST_FOREACH(const CTransaction &tx, block.vtx) {
                 if (tx.GetHash() == hash) {
                     txOut = tx;
                     hashBlock = pindexSlow->GetBlockHash();
+                    txLookupCache.Insert(hash, std::make_pair(boost::shared_ptr<const CTransaction>(new CTransaction(txOut)), hashBlock));
                     return true;
                 }
             }
@@ -3638,6 +3696,71 @@ static bool ApplyTxInUndo(const CTxInUndo& undo, CCoinsViewCache& view, const CO
     return fClean;
 }
 
+static bool GetTxOutAddressAsset(const CTxOut& txout, std::string& strAddress, uint256& assetId)
+{
+    if(!txout.IsAsset())
+        return false;
+
+    CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+    if(!payload || !payload->fBody || payload->assetId.IsNull())
+        return false;
+
+    assetId = payload->assetId;
+    return GetTxOutAddress(txout, &strAddress);
+}
+
+/**
+ * Add the asset outputs and spent asset inputs of tx to the per address asset
+ * balance deltas of a block, negated when the block is disconnected. The inputs
+ * of tx must be available in view.
+ */
+static bool UpdateAddressAssetBalance(const CTransaction& tx, const CCoinsViewCache& view, const bool fDisconnect,
+                                      std::map<CAddressAssetBalance_IndexKey, CAddressAssetBalance_IndexValue>& mapBalance,
+                                      std::map<CAddressAssetLocked_IndexKey, CAssetAmount>& mapLocked)
+{
+    std::string strAddress;
+    uint256 assetId;
+    for(unsigned int m = 0; m < tx.vout.size(); m++)
+    {
+        const CTxOut& txout = tx.vout[m];
+        if(!GetTxOutAddressAsset(txout, strAddress, assetId))
+            continue;
+
+        CAssetAmount& nReceived = mapBalance[CAddressAssetBalance_IndexKey(strAddress, assetId)].nReceived;
+        if(!(fDisconnect ? nReceived.Sub(txout.nValue) : nReceived.Add(txout.nValue)))
+            return false;
+
+        if(txout.nUnlockedHeight > 0)
+        {
+            int nUnlockedHeight = (int)std::min(txout.nUnlockedHeight, (int64_t)std::numeric_limits<int>::max());
+            CAssetAmount& nLocked = mapLocked[CAddressAssetLocked_IndexKey(strAddress, assetId, nUnlockedHeight)];
+            if(!(fDisconnect ? nLocked.Sub(txout.nValue) : nLocked.Add(txout.nValue)))
+                return false;
+        }
+    }
+
+    if(tx.IsCoinBase())
+        return true;
+
+    BOOST_FOREACH(const CTxIn& txin, tx.vin)
+    {
+        const CTxOut& prevout = view.GetOutputFor(txin);
+        if(!GetTxOutAddressAsset(prevout, strAddress, assetId))
+            continue;
+
+        // get candy inputs only refer to the put candy output, they do not spend it
+        uint32_t nAppCmd = 0;
+        if(prevout.IsAsset(&nAppCmd) && nAppCmd == PUT_CANDY_CMD && txin.scriptSig.empty() && strAddress == g_strPutCandyAddress)
+            continue;
+
+        CAssetAmount& nSent = mapBalance[CAddressAssetBalance_IndexKey(strAddress, assetId)].nSent;
+        if(!(fDisconnect ? nSent.Sub(prevout.nValue) : nSent.Add(prevout.nValue)))
+            return false;
+    }
+
+    return true;
+}
+
 bool DisconnectBlock(const CBlock& block, CValidationState& state, const CBlockIndex* pindex, CCoinsViewCache& view, bool* pfClean)
 {
     assert(pindex->GetBlockHash() == view.GetBestBlock());
@@ -3669,6 +3792,8 @@ bool DisconnectBlock(const CBlock& block, CValidationState& state, const CBlockI
     std::vector<std::pair<CPutCandy_IndexKey, CPutCandy_IndexValue> > putCandy_index;
     std::vector<std::pair<CGetCandy_IndexKey, CGetCandy_IndexValue> > getCandy_index;
     std::vector<std::pair<CAssetTx_IndexKey, int> > assetTx_index;
+    std::map<CAddressAssetBalance_IndexKey, CAddressAssetBalance_IndexValue> addressAssetBalance_index;
+    std::map<CAddressAssetLocked_IndexKey, CAssetAmount> addressAssetLocked_index;
     std::map<CGetCandyCount_IndexKey,CGetCandyCount_IndexValue> getCandyCount_index;
     std::string strPubKeyCollateralAddress = "";
     CMasternodePayee_IndexValue masternodePayment_IndexValue;
@@ -3677,6 +3802,7 @@ bool DisconnectBlock(const CBlock& block, CValidationState& state, const CBlockI
     for (int i = block.vtx.size() - 1; i >= 0; i--) {
         const CTransaction &tx = block.vtx[i];
         uint256 hash = tx.GetHash();
+        UncacheTxHeight(hash);
 
         if (fAddressIndex) {
 
@@ -3839,6 +3965,9 @@ bool DisconnectBlock(const CBlock& block, CValidationState& state, const CBlockI
             }
         }
 
+        if (fAddressAssetBalanceIndex && !UpdateAddressAssetBalance(tx, view, true, addressAssetBalance_index, addressAssetLocked_index))
+            return error("DisconnectBlock(): address asset balance of %s out of range", hash.ToString());
+
         for(unsigned int m = tx.vout.size(); m-- > 0;)
         {
             const CTxOut& txout = tx.vout[m];
@@ -3988,45 +4117,30 @@ bool DisconnectBlock(const CBlock& block, CValidationState& state, const CBlockI
         return true;
     }
 
+    // all index changes of the block go to the database in a single write
+    CDBBatch batch(&pblocktree->GetObfuscateKey());
+
     if (fAddressIndex) {
-        if (!pblocktree->EraseAddressIndex(addressIndex)) {
-            return AbortNode(state, "Failed to delete address index");
-        }
-        if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex)) {
-            return AbortNode(state, "Failed to write address unspent index");
-        }
+        pblocktree->EraseAddressIndex(batch, addressIndex);
+        pblocktree->UpdateAddressUnspentIndex(batch, addressUnspentIndex);
     }
 
     if (fSpentIndex)
-        if (!pblocktree->UpdateSpentIndex(spentIndex))
-            return AbortNode(state, "Failed to delete spent index");
-
-    if(appId_appInfo_index.size() && !pblocktree->Erase_AppId_AppInfo_Index(appId_appInfo_index))
-        return AbortNode(state, "Failed to delete appId_appInfo index");
-
-    if(appName_appId_index.size() && !pblocktree->Erase_AppName_AppId_Index(appName_appId_index))
-        return AbortNode(state, "Failed to delete appName_appId index");
-
-    if(appTx_index.size() && !pblocktree->Erase_AppTx_Index(appTx_index))
-        return AbortNode(state, "Failed to delete appTx index");
-
-    if(assetId_assetInfo_index.size() && !pblocktree->Erase_AssetId_AssetInfo_Index(assetId_assetInfo_index))
-        return AbortNode(state, "Failed to delete assetId_assetInfo index");
-
-    if(shortName_assetId_index.size() && !pblocktree->Erase_ShortName_AssetId_Index(shortName_assetId_index))
-        return AbortNode(state, "Failed to delete shortName_assetId index");
-
-    if(assetName_assetId_index.size() && !pblocktree->Erase_AssetName_AssetId_Index(assetName_assetId_index))
-        return AbortNode(state, "Failed to delete assetName_assetId index");
-
-    if(putCandy_index.size() && !pblocktree->Erase_PutCandy_Index(putCandy_index))
-        return AbortNode(state, "Failed to delete putcandy index");
-
-    if(getCandy_index.size() && !pblocktree->Erase_GetCandy_Index(getCandy_index))
-        return AbortNode(state, "Failed to delete getCandy index");
-
-    if(assetTx_index.size() && !pblocktree->Erase_AssetTx_Index(assetTx_index))
-        return AbortNode(state, "Failed to delete assetTx index");
+        pblocktree->UpdateSpentIndex(batch, spentIndex);
+
+    pblocktree->Erase_AppId_AppInfo_Index(batch, appId_appInfo_index);
+    pblocktree->Erase_AppName_AppId_Index(batch, appName_appId_index);
+    pblocktree->Erase_AppTx_Index(batch, appTx_index);
+    pblocktree->Erase_AssetId_AssetInfo_Index(batch, assetId_assetInfo_index);
+    pblocktree->Erase_ShortName_AssetId_Index(batch, shortName_assetId_index);
+    pblocktree->Erase_AssetName_AssetId_Index(batch, assetName_assetId_index);
+    pblocktree->Erase_PutCandy_Index(batch, putCandy_index);
+    pblocktree->Erase_GetCandy_Index(batch, getCandy_index);
+    pblocktree->Erase_AssetTx_Index(batch, assetTx_index);
+
+    if (fAddressAssetBalanceIndex && (!pblocktree->Update_AddressAssetBalance_Index(batch, addressAssetBalance_index)
+                                      || !pblocktree->Update_AddressAssetLocked_Index(batch, addressAssetLocked_index)))
+        return AbortNode(state, "Failed to update address asset balance index");
 
     if(getCandyCount_index.size())
     {
@@ -4047,16 +4161,14 @@ bool DisconnectBlock(const CBlock& block, CValidationState& state, const CBlockI
                     LogPrintf("disconnect getCandyAmountError:currCount:%d,deltaCount:%d",value.nGetCandyCount,deltaValue.nGetCandyCount);
                     value.nGetCandyCount = 0;
                 }
-                if(!pblocktree->Erase_GetCandyCount_Index(key))
-                    return AbortNode(state, "Failed to erase getCandyCount index");
-                if(!pblocktree->Write_GetCandyCount_Index(key,value))
-                    return AbortNode(state, "Failed to write getCandyCount index");
+                pblocktree->Write_GetCandyCount_Index(batch,key,value);
             }
             ++iter;
         }
     }
 
     //remove masternode payee
+    bool fRemovePayee = false;
     if(strPubKeyCollateralAddress.size())
     {
         if(pblocktree->Is_Exists_MasternodePayee_Key(strPubKeyCollateralAddress))
@@ -4064,21 +4176,26 @@ bool DisconnectBlock(const CBlock& block, CValidationState& state, const CBlockI
             CMasternodePayee_IndexValue value;
             if(!pblocktree->Read_MasternodePayee_Index(strPubKeyCollateralAddress,value))
                 return AbortNode(state, "SPOS_Error:Failed to read masternode payee index when disconnect block");
-            if(!pblocktree->Erase_MasternodePayee_Index(strPubKeyCollateralAddress))
-                return AbortNode(state, "SPOS_Error:Failed to erase masternode payee index when disconnect block");
             masternodePayment_IndexValue.nPayeeTimes = value.nPayeeTimes - 1;
             if(masternodePayment_IndexValue.nPayeeTimes>0)
-            {
-                if(!pblocktree->Write_MasternodePayee_Index(strPubKeyCollateralAddress,masternodePayment_IndexValue))
-                    return AbortNode(state, "SPOS_Error:Failed to write masternode payee index when disconnect block");
-            }
-            {
-                std::lock_guard<std::mutex> lock(g_mutexAllPayeeInfo);
-                gAllPayeeInfoMap[strPubKeyCollateralAddress] = masternodePayment_IndexValue;
-            }
-            LogPrint("masternode","remove masternode payee:strPubKeyCollateralAddress:%s,nHeight:%d,nPayeeTimes:%d,blockTime:%lld\n",strPubKeyCollateralAddress,
-                     masternodePayment_IndexValue.nHeight,masternodePayment_IndexValue.nPayeeTimes,masternodePayment_IndexValue.blockTime);
+                pblocktree->Write_MasternodePayee_Index(batch,strPubKeyCollateralAddress,masternodePayment_IndexValue);
+            else
+                pblocktree->Erase_MasternodePayee_Index(batch,strPubKeyCollateralAddress);
+            fRemovePayee = true;
+        }
+    }
+
+    if (!pblocktree->WriteBatch(batch))
+        return AbortNode(state, "Failed to write block indexes when disconnect block");
+
+    if(fRemovePayee)
+    {
+        {
+            std::lock_guard<std::mutex> lock(g_mutexAllPayeeInfo);
+            gAllPayeeInfoMap[strPubKeyCollateralAddress] = masternodePayment_IndexValue;
         }
+        LogPrint("masternode","remove masternode payee:strPubKeyCollateralAddress:%s,nHeight:%d,nPayeeTimes:%d,blockTime:%lld\n",strPubKeyCollateralAddress,
+                 masternodePayment_IndexValue.nHeight,masternodePayment_IndexValue.nPayeeTimes,masternodePayment_IndexValue.blockTime);
     }
     return fClean;
 }
@@ -4349,6 +4466,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     std::vector<std::pair<CPutCandy_IndexKey, CPutCandy_IndexValue> > putCandy_index;
     std::vector<std::pair<CGetCandy_IndexKey, CGetCandy_IndexValue> > getCandy_index;
     std::vector<std::pair<CAssetTx_IndexKey, int> > assetTx_index;
+    std::map<CAddressAssetBalance_IndexKey, CAddressAssetBalance_IndexValue> addressAssetBalance_index;
+    std::map<CAddressAssetLocked_IndexKey, CAssetAmount> addressAssetLocked_index;
     std::map<CGetCandyCount_IndexKey,CGetCandyCount_IndexValue> getCandyCount_index;
     std::string strPubKeyCollateralAddress = "";
     CMasternodePayee_IndexValue masternodePayment_IndexValue;
@@ -4534,10 +4653,11 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         {
             const CTxOut& txout = tx.vout[m];
 
-            CAppHeader header;
-            std::vector<unsigned char> vData;
-            if(ParseReserve(txout.vReserve, header, vData))
+            CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+            if(payload)
             {
+                const CAppHeader& header = payload->header;
+
                 CTxDestination dest;
                 if(!ExtractDestination(txout.scriptPubKey, dest))
                     continue;
@@ -4546,8 +4666,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
 
                 if(header.nAppCmd == REGISTER_APP_CMD)
                 {
-                    CAppData appData;
-                    if(ParseRegisterData(vData, appData))
+                    const CAppData& appData = payload->GetAppData();
+                    if(payload->fBody)
                     {
                         appId_appInfo_index.push_back(make_pair(header.appId, CAppId_AppInfo_IndexValue(strAddress, appData, pindex->nHeight)));
                         appName_appId_index.push_back(make_pair(appData.strAppName, CName_Id_IndexValue(header.appId, pindex->nHeight)));
@@ -4556,8 +4676,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
                 }
                 else if(header.nAppCmd == ADD_AUTH_CMD)
                 {
-                    CAuthData authData;
-                    if(ParseAuthData(vData, authData))
+                    const CAuthData& authData = payload->GetAuthData();
+                    if(payload->fBody)
                     {
                         appTx_index.push_back(make_pair(CAppTx_IndexKey(header.appId, strAddress, ADD_AUTH_TXOUT, COutPoint(txhash, m)), pindex->nHeight));
 
@@ -4583,8 +4703,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
                 }
                 else if(header.nAppCmd == DELETE_AUTH_CMD)
                 {
-                    CAuthData authData;
-                    if(ParseAuthData(vData, authData))
+                    const CAuthData& authData = payload->GetAuthData();
+                    if(payload->fBody)
                     {
                         appTx_index.push_back(make_pair(CAppTx_IndexKey(header.appId, strAddress, DELETE_AUTH_TXOUT, COutPoint(txhash, m)), pindex->nHeight));
 
@@ -4600,10 +4720,10 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
                 }
                 else if(header.nAppCmd == ISSUE_ASSET_CMD)
                 {
-                    CAssetData assetData;
-                    if(ParseIssueData(vData, assetData))
+                    const CAssetData& assetData = payload->GetAssetData();
+                    if(payload->fBody)
                     {
-                        uint256 assetId = assetData.GetHash();
+                        const uint256& assetId = payload->assetId;
                         assetId_assetInfo_index.push_back(make_pair(assetId, CAssetId_AssetInfo_IndexValue(strAddress, assetData, pindex->nHeight)));
                         shortName_assetId_index.push_back(make_pair(assetData.strShortName, CName_Id_IndexValue(assetId, pindex->nHeight)));
                         assetName_assetId_index.push_back(make_pair(assetData.strAssetName, CName_Id_IndexValue(assetId, pindex->nHeight)));
@@ -4612,20 +4732,20 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
                 }
                 else if(header.nAppCmd == ADD_ASSET_CMD)
                 {
-                    CCommonData addData;
-                    if(ParseCommonData(vData, addData))
+                    const CCommonData& addData = payload->GetCommonData();
+                    if(payload->fBody)
                         assetTx_index.push_back(make_pair(CAssetTx_IndexKey(addData.assetId, strAddress, ADD_ISSUE_TXOUT, COutPoint(txhash, m)), pindex->nHeight));
                 }
                 else if (header.nAppCmd == CHANGE_ASSET_CMD)
                 {
-                    CCommonData changeData;
-                    if(ParseCommonData(vData, changeData))
+                    const CCommonData& changeData = payload->GetCommonData();
+                    if(payload->fBody)
                         assetTx_index.push_back(make_pair(CAssetTx_IndexKey(changeData.assetId, strAddress, CHANGE_ASSET_TXOUT, COutPoint(txhash, m)), pindex->nHeight));
                 }
                 else if(header.nAppCmd == TRANSFER_ASSET_CMD)
                 {
-                    CCommonData transferData;
-                    if(ParseCommonData(vData, transferData))
+                    const CCommonData& transferData = payload->GetCommonData();
+                    if(payload->fBody)
                     {
                         if(txout.nUnlockedHeight > 0)
                             assetTx_index.push_back(make_pair(CAssetTx_IndexKey(transferData.assetId, strAddress, LOCKED_TXOUT, COutPoint(txhash, m)), pindex->nHeight));
@@ -4647,8 +4767,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
                 }
                 else if(header.nAppCmd == DESTORY_ASSET_CMD)
                 {
-                    CCommonData destoryData;
-                    if(ParseCommonData(vData, destoryData))
+                    const CCommonData& destoryData = payload->GetCommonData();
+                    if(payload->fBody)
                     {
                         assetTx_index.push_back(make_pair(CAssetTx_IndexKey(destoryData.assetId, strAddress, DESTORY_TXOUT, COutPoint(txhash, m)), pindex->nHeight));
                         for(unsigned int x = 0; x < tx.vin.size(); x++)
@@ -4666,8 +4786,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
                 }
                 else if(header.nAppCmd == PUT_CANDY_CMD)
                 {
-                    CPutCandyData candyData;
-                    if(ParsePutCandyData(vData, candyData))
+                    const CPutCandyData& candyData = payload->GetPutCandyData();
+                    if(payload->fBody)
                     {
                         putCandy_index.push_back(make_pair(CPutCandy_IndexKey(candyData.assetId, COutPoint(txhash, m), CCandyInfo(candyData.nAmount, candyData.nExpired)), CPutCandy_IndexValue(pindex->nHeight, blockHash, i)));
                         assetTx_index.push_back(make_pair(CAssetTx_IndexKey(candyData.assetId, strAddress, PUT_CANDY_TXOUT, COutPoint(txhash, m)), pindex->nHeight));
@@ -4679,8 +4799,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
                 }
                 else if(header.nAppCmd == GET_CANDY_CMD)
                 {
-                    CGetCandyData candyData;
-                    if(ParseGetCandyData(vData, candyData))
+                    const CGetCandyData& candyData = payload->GetGetCandyData();
+                    if(payload->fBody)
                     {
                         CGetCandyCount_IndexKey key(candyData.assetId,tx.vin.back().prevout);
                         CGetCandyCount_IndexValue& value = getCandyCount_index[key];
@@ -4692,6 +4812,9 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
             }
         }
 
+        if (fAddressAssetBalanceIndex && !fJustCheck && !UpdateAddressAssetBalance(tx, view, false, addressAssetBalance_index, addressAssetLocked_index))
+            return error("ConnectBlock(): address asset balance of %s out of range", txhash.ToString());
+
         CTxUndo undoDummy;
         if (i > 0) {
             blockundo.vtxundo.push_back(CTxUndo());
@@ -4789,57 +4912,37 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         setDirtyBlockIndex.insert(pindex);
     }
 
+    // all index changes of the block go to the database in a single write
+    CDBBatch batch(&pblocktree->GetObfuscateKey());
+
     if (fTxIndex)
-        if (!pblocktree->WriteTxIndex(vPos))
-            return AbortNode(state, "Failed to write transaction index");
+        pblocktree->WriteTxIndex(batch, vPos);
 
     if (fAddressIndex) {
-        if (!pblocktree->WriteAddressIndex(addressIndex)) {
-            return AbortNode(state, "Failed to write address index");
-        }
-
-        if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex)) {
-            return AbortNode(state, "Failed to write address unspent index");
-        }
+        pblocktree->WriteAddressIndex(batch, addressIndex);
+        pblocktree->UpdateAddressUnspentIndex(batch, addressUnspentIndex);
     }
 
     if (fSpentIndex)
-        if (!pblocktree->UpdateSpentIndex(spentIndex))
-            return AbortNode(state, "Failed to write transaction index");
+        pblocktree->UpdateSpentIndex(batch, spentIndex);
 
     if (fTimestampIndex)
-        if (!pblocktree->WriteTimestampIndex(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())))
-            return AbortNode(state, "Failed to write timestamp index");
-
-    if(appId_appInfo_index.size() && !pblocktree->Write_AppId_AppInfo_Index(appId_appInfo_index))
-        return AbortNode(state, "Failed to write appId_appInfo index");
-
-    if(appName_appId_index.size() && !pblocktree->Write_AppName_AppId_Index(appName_appId_index))
-        return AbortNode(state, "Failed to write appName_appId index");
-
-    if(auth_index.size() && !pblocktree->Update_Auth_Index(auth_index))
-        return AbortNode(state, "Failed to update auth index");
-
-    if(appTx_index.size() && !pblocktree->Write_AppTx_Index(appTx_index))
-        return AbortNode(state, "Failed to write appTx index");
-
-    if(assetId_assetInfo_index.size() && !pblocktree->Write_AssetId_AssetInfo_Index(assetId_assetInfo_index))
-        return AbortNode(state, "Failed to write assetId_assetInfo index");
-
-    if(shortName_assetId_index.size() && !pblocktree->Write_ShortName_AssetId_Index(shortName_assetId_index))
-        return AbortNode(state, "Failed to write shortName_assetId index");
-
-    if(assetName_assetId_index.size() && !pblocktree->Write_AssetName_AssetId_Index(assetName_assetId_index))
-        return AbortNode(state, "Failed to write assetName_assetId index");
-
-    if(putCandy_index.size() && !pblocktree->Write_PutCandy_Index(putCandy_index))
-        return AbortNode(state, "Failed to write putcandy index");
-
-    if(getCandy_index.size() && !pblocktree->Write_GetCandy_Index(getCandy_index))
-        return AbortNode(state, "Failed to write getCandy index");
-
-    if(assetTx_index.size() && !pblocktree->Write_AssetTx_Index(assetTx_index))
-        return AbortNode(state, "Failed to write assetTx index");
+        pblocktree->WriteTimestampIndex(batch, CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash()));
+
+    pblocktree->Write_AppId_AppInfo_Index(batch, appId_appInfo_index);
+    pblocktree->Write_AppName_AppId_Index(batch, appName_appId_index);
+    pblocktree->Update_Auth_Index(batch, auth_index);
+    pblocktree->Write_AppTx_Index(batch, appTx_index);
+    pblocktree->Write_AssetId_AssetInfo_Index(batch, assetId_assetInfo_index);
+    pblocktree->Write_ShortName_AssetId_Index(batch, shortName_assetId_index);
+    pblocktree->Write_AssetName_AssetId_Index(batch, assetName_assetId_index);
+    pblocktree->Write_PutCandy_Index(batch, putCandy_index);
+    pblocktree->Write_GetCandy_Index(batch, getCandy_index);
+    pblocktree->Write_AssetTx_Index(batch, assetTx_index);
+
+    if (fAddressAssetBalanceIndex && (!pblocktree->Update_AddressAssetBalance_Index(batch, addressAssetBalance_index)
+                                      || !pblocktree->Update_AddressAssetLocked_Index(batch, addressAssetLocked_index)))
+        return AbortNode(state, "Failed to update address asset balance index");
 
     if(getCandyCount_index.size())
     {
@@ -4853,27 +4956,20 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
             {
                 if(!pblocktree->Read_GetCandyCount_Index(key.assetId,key.out,value))
                     return AbortNode(state, "Failed to get getCandyCount index");
-                if(!pblocktree->Erase_GetCandyCount_Index(key))
-                    return AbortNode(state, "Failed to erase getCandyCount index");
             }
             value.nGetCandyCount += deltaValue.nGetCandyCount;
-            if(!pblocktree->Write_GetCandyCount_Index(key,value))
-                return AbortNode(state, "Failed to write getCandyCount index");
+            pblocktree->Write_GetCandyCount_Index(batch,key,value);
             ++iter;
             LogPrint("asset","check-getcandy:leveldb_add_candy:%s,%s,currAmount:%d,totalAmount:%d\n",key.assetId.ToString(),key.out.ToString()
                       ,deltaValue.nGetCandyCount,value.nGetCandyCount);
         }
     }
 
+    bool fStartSavePayee = false;
     if(g_nLocalStartSavePayeeHeight==0&&pindex->nHeight>=g_nSaveMasternodePayeeHeight)
     {
-        if(!pblocktree->Write_LocalStartSavePayeeHeight_Index(masternodePayment_IndexValue.nHeight))
-            return AbortNode(state, "SPOS_Error:Failed to write local start save payee height");
-        else
-        {
-            g_nLocalStartSavePayeeHeight = masternodePayment_IndexValue.nHeight;
-            LogPrintf("SPOS_Message:write local start save payee height:%d\n",masternodePayment_IndexValue.nHeight);
-        }
+        pblocktree->Write_LocalStartSavePayeeHeight_Index(batch,masternodePayment_IndexValue.nHeight);
+        fStartSavePayee = true;
     }
 
     //add masternode payee
@@ -4884,13 +4980,28 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
             CMasternodePayee_IndexValue value;
             if(!pblocktree->Read_MasternodePayee_Index(strPubKeyCollateralAddress,value))
                 return AbortNode(state, "SPOS_Error:Failed to read masternode payee index when connect block");
-            if(!pblocktree->Erase_MasternodePayee_Index(strPubKeyCollateralAddress))
-                return AbortNode(state, "SPOS_Error:Failed to erase masternode payee index when connect block");
             masternodePayment_IndexValue.nPayeeTimes = value.nPayeeTimes + 1;
         }
-        if(!pblocktree->Write_MasternodePayee_Index(strPubKeyCollateralAddress,masternodePayment_IndexValue))
-            return AbortNode(state, "SPOS_Error:Failed to write masternode payee index when connect block");
+        pblocktree->Write_MasternodePayee_Index(batch,strPubKeyCollateralAddress,masternodePayment_IndexValue);
+    }
+
+    if (!pblocktree->WriteBatch(batch))
+        return AbortNode(state, "Failed to write block indexes when connect block");
+
+    // lock checks of these outputs need the height and version of their transaction,
+    // they are cached once the block is written so that a failed block leaves none
+    const uint256 hashBlock = pindex->GetBlockHash();
+    BOOST_FOREACH(const CTransaction& tx, block.vtx)
+        CacheTxHeight(tx.GetHash(), pindex->nHeight, tx.nVersion, hashBlock);
+
+    if(fStartSavePayee)
+    {
+        g_nLocalStartSavePayeeHeight = masternodePayment_IndexValue.nHeight;
+        LogPrintf("SPOS_Message:write local start save payee height:%d\n",masternodePayment_IndexValue.nHeight);
+    }
 
+    if(strPubKeyCollateralAddress.size())
+    {
         {
             std::lock_guard<std::mutex> lock(g_mutexAllPayeeInfo);
             gAllPayeeInfoMap[strPubKeyCollateralAddress] = masternodePayment_IndexValue;
@@ -5135,6 +5246,7 @@ bool static DisconnectTip(CValidationState& state, const Consensus::Params& cons
     // Write the chain state to disk, if necessary.
     if (!FlushStateToDisk(state, FLUSH_STATE_IF_NEEDED))
         return false;
+    GetMainSignals().BlockDisconnected(block, pindexDelete);
     // Resurrect mempool transactions from the disconnected block.
     std::vector<uint256> vHashUpdate;
     BOOST_FOREACH(const CTransaction &tx, block.vtx) {
@@ -5298,6 +5410,7 @@ bool static ConnectTip(CValidationState& state, const CChainParams& chainparams,
     BOOST_FOREACH(const CTransaction &tx, pblock->vtx) {
         GetMainSignals().SyncTransaction(tx, pblock);
     }
+    GetMainSignals().BlockConnected(*pblock, pindexNew);
 
     int64_t nTime6 = GetTimeMicros(); nTimePostConnect += nTime6 - nTime5; nTimeTotal += nTime6 - nTime1;
     LogPrint("bench", "  - Connect postprocess: %.2fms [%.2fs]\n", (nTime6 - nTime5) * 0.001, nTimePostConnect * 0.000001);
@@ -5877,7 +5990,7 @@ bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, bool f
 }
 
 
-bool ParseCoinBaseReserve(const std::vector<unsigned char> &vReserve, std::vector<unsigned char> &vchKeyId, std::vector<unsigned char> &vchSig, std::vector<unsigned char> &vchConAlg, uint16_t &nSPOSVersion, string &strSigMessage)
+bool ParseCoinBaseReserve(const CTxOutReserve &vReserve, std::vector<unsigned char> &vchKeyId, std::vector<unsigned char> &vchSig, std::vector<unsigned char> &vchConAlg, uint16_t &nSPOSVersion, string &strSigMessage)
 {
     unsigned int nFixedLen = TXOUT_RESERVE_MIN_SIZE + nConsensusAlgorithmLen + sizeof(nSPOSVersion) + nKeyIdSize;
 
@@ -6759,6 +6872,14 @@ bool static LoadBlockIndexDB()
     pblocktree->ReadFlag("spentindex", fSpentIndex);
     LogPrintf("%s: spent index %s\n", __func__, fSpentIndex ? "enabled" : "disabled");
 
+    // The address asset balance index is only complete when it was kept from the genesis block
+    pblocktree->ReadFlag("addressassetbalanceindex", fAddressAssetBalanceIndex);
+    LogPrintf("%s: address asset balance index %s\n", __func__, fAddressAssetBalanceIndex ? "enabled" : "disabled, reindex to build it");
+
+    // Build the address keyed asset and app indexes if the database predates them
+    if (!pblocktree->Upgrade_AddressTx_Index())
+        return error("%s: upgrade address keyed asset and app indexes failed", __func__);
+
     // Load pointer to end of best chain
     BlockMap::iterator it = mapBlockIndex.find(pcoinsTip->GetBestBlock());
     if (it == mapBlockIndex.end())
@@ -6924,6 +7045,11 @@ bool InitBlockIndex(const CChainParams& chainparams)
     fSpentIndex = GetBoolArg("-spentindex", DEFAULT_SPENTINDEX);
     pblocktree->WriteFlag("spentindex", fSpentIndex);
 
+    // A new database maintains the address keyed asset and app indexes from the start
+    pblocktree->WriteFlag("addresstxindex", true);
+    fAddressAssetBalanceIndex = true;
+    pblocktree->WriteFlag("addressassetbalanceindex", true);
+
     LogPrintf("Initializing databases...\n");
 
     // Only add the genesis block if not reindexing (in which case we reuse the one already on disk)
@@ -7402,6 +7528,88 @@ bool GetTxInfoByAppIdAddress(const uint256& appId, const string& strAddress, vec
     return vOut.size();
 }
 
+std::string CTxIdCursor::ToString() const
+{
+    return strprintf("%d:%s", nHeight, txid.GetHex());
+}
+
+bool CTxIdCursor::Parse(const std::string& str, CTxIdCursor& cursor)
+{
+    size_t nPos = str.find(':');
+    if(nPos == std::string::npos)
+        return false;
+
+    int32_t nHeight = 0;
+    std::string strTxId = str.substr(nPos + 1);
+    if(!ParseInt32(str.substr(0, nPos), &nHeight) || nHeight < 0 || strTxId.size() != 64 || !IsHex(strTxId))
+        return false;
+
+    cursor = CTxIdCursor(nHeight, uint256S(strTxId));
+    return true;
+}
+
+void CTxIdPage::Add(const int& nHeight, const uint256& txid)
+{
+    fEmpty = false;
+
+    CTxIdCursor cursor(nHeight, txid);
+    if(!after.IsNull() && !(after < cursor))
+        return;
+    if(nCount && setTxId.size() > nCount && !(cursor < *setTxId.rbegin()))
+        return;
+
+    // the index lists a transaction once per output, the filter may read it from disk
+    if(setTxId.count(cursor) || setFiltered.count(txid))
+        return;
+    if(fnFilter && !fnFilter(txid))
+    {
+        setFiltered.insert(txid);
+        return;
+    }
+
+    setTxId.insert(cursor);
+    if(nCount && setTxId.size() > nCount + 1)
+        setTxId.erase(--setTxId.end());
+}
+
+void CTxIdPage::Get(std::vector<uint256>& vTxId, CTxIdCursor& cursorNext) const
+{
+    cursorNext = CTxIdCursor();
+
+    // a transaction mined while the index was read may be listed at two heights
+    std::set<uint256> setSeen;
+    unsigned int nTaken = 0;
+    for(std::set<CTxIdCursor>::const_iterator it = setTxId.begin(); it != setTxId.end(); ++it)
+    {
+        if(nCount && nTaken == nCount)
+        {
+            cursorNext = *(--it);
+            break;
+        }
+        nTaken++;
+        if(setSeen.insert(it->txid).second)
+            vTxId.push_back(it->txid);
+    }
+}
+
+bool GetTxIdsByAppId(const uint256& appId, const string& strAddress, CTxIdPage& page, const bool fWithMempool)
+{
+    if(!pblocktree->Read_AppTx_Index(appId, strAddress, page))
+        return false;
+    if(!fWithMempool)
+        return true;
+
+    vector<COutPoint> vMempoolOut;
+    if(strAddress.empty())
+        mempool.get_AppTx_Index(appId, vMempoolOut);
+    else
+        mempool.get_AppTx_Index(appId, strAddress, vMempoolOut);
+    BOOST_FOREACH(const COutPoint& out, vMempoolOut)
+        page.Add(TXID_PAGE_MEMPOOL_HEIGHT, out.hash);
+
+    return true;
+}
+
 bool GetAppListInfo(std::vector<uint256>& vAppId, const bool fWithMempool)
 {
     if(!fWithMempool)
@@ -7547,6 +7755,38 @@ bool GetTxInfoByAssetIdAddressTxClass(const uint256& assetId, const string& strA
     return vOut.size();
 }
 
+bool GetAddressAssetBalance(const std::string& strAddress, const uint256& assetId, CAssetAmount& nReceived, CAssetAmount& nSent, CAssetAmount& nLocked)
+{
+    if(!fAddressAssetBalanceIndex)
+        return false;
+
+    CAddressAssetBalance_IndexValue value;
+    if(!pblocktree->Read_AddressAssetBalance_Index(strAddress, assetId, g_nChainHeight, value, nLocked))
+        return false;
+
+    nReceived = value.nReceived;
+    nSent = value.nSent;
+    return true;
+}
+
+bool GetTxIdsByAssetIdTxClass(const uint256& assetId, const string& strAddress, const uint8_t& nTxClass, CTxIdPage& page, const bool fWithMempool)
+{
+    if(!pblocktree->Read_AssetTx_Index(assetId, strAddress, nTxClass, page))
+        return false;
+    if(!fWithMempool)
+        return true;
+
+    vector<COutPoint> vMempoolOut;
+    if(strAddress.empty())
+        mempool.get_AssetTx_Index(assetId, nTxClass, vMempoolOut);
+    else
+        mempool.get_AssetTx_Index(assetId, strAddress, nTxClass, vMempoolOut);
+    BOOST_FOREACH(const COutPoint& out, vMempoolOut)
+        page.Add(TXID_PAGE_MEMPOOL_HEIGHT, out.hash);
+
+    return true;
+}
+
 bool GetAssetIdCandyInfo(const uint256& assetId, map<COutPoint, CCandyInfo>& mapCandyInfo)
 {
     return pblocktree->Read_PutCandy_Index(assetId, mapCandyInfo);
@@ -7765,11 +8005,8 @@ bool GetRangeChangeHeight(const int nCandyHeight, vector<int>& vChangeHeight)
     return true;
 }
 
-static int BinarySearchFromFile(const string& strFile, const string& strAddress, CAmount& nAmount, long* pPos = NULL);
-bool GetAddressAmountByHeight(const int& nHeight, const std::string& strAddress, CAmount& nAmount)
+static bool CheckAddressAmountHeight(const int& nHeight)
 {
-    std::lock_guard<std::mutex> lock(g_mutexChangeFile);
-
     uint64_t nDetailFileSize = boost::filesystem::file_size(GetDataDir() / "height/detail.dat");
 
     if (nHeight >= g_nStartSPOSHeight)
@@ -7793,6 +8030,17 @@ bool GetAddressAmountByHeight(const int& nHeight, const std::string& strAddress,
         }
     }
 
+    return true;
+}
+
+static int BinarySearchFromFile(const string& strFile, const string& strAddress, CAmount& nAmount, long* pPos = NULL);
+bool GetAddressAmountByHeight(const int& nHeight, const std::string& strAddress, CAmount& nAmount)
+{
+    std::lock_guard<std::mutex> lock(g_mutexChangeFile);
+
+    if(!CheckAddressAmountHeight(nHeight))
+        return false;
+
     vector<int> vChangeHeight;
     if(!GetRangeChangeHeight(nHeight, vChangeHeight))
         return error("%s: get change files failed at %d", __func__, nHeight);
@@ -7812,34 +8060,79 @@ bool GetAddressAmountByHeight(const int& nHeight, const std::string& strAddress,
         nAmount -= nChangeAmount;
     }
 
+    // 3. add the pending deltas which are not compacted yet
+    if(!candyLedger.FindPending(nHeight, strAddress, nAmount))
+        return error("%s: search %s from pending deltas failed at %d", __func__, strAddress, nHeight);
+
     if(nAmount < 0)
         return false;
 
     return true;
 }
 
-bool GetTotalAmountByHeight(const int& nHeight, CAmount& nTotalAmount)
+bool GetAddressAmountsByHeight(const int& nHeight, const std::vector<std::string>& vAddress, std::vector<CAmount>& vAmount)
 {
-    return pblocktree->Read_CandyHeight_TotalAmount_Index(nHeight, nTotalAmount);
-}
+    vAmount.assign(vAddress.size(), 0);
+    if(vAddress.empty())
+        return true;
 
-bool GetCOutPointAddress(const uint256& assetId, std::map<COutPoint, std::vector<std::string>> &moutpointaddress)
-{
-    if (assetId.IsNull())
-        return false;
+    if(!std::is_sorted(vAddress.begin(), vAddress.end()))
+        return error("%s: address list is not sorted", __func__);
 
-    return pblocktree->Read_GetCandy_Index(assetId, moutpointaddress);
-}
+    std::lock_guard<std::mutex> lock(g_mutexChangeFile);
 
-bool GetCOutPointList(const uint256& assetId, const std::string& strAddress, std::vector<COutPoint> &vcoutpoint)
-{
-    if (assetId.IsNull() || strAddress.empty())
+    if(!CheckAddressAmountHeight(nHeight))
         return false;
 
-    return pblocktree->Read_GetCandy_Index(assetId, strAddress, vcoutpoint);
-}
-
-bool GetIssueAssetInfo(std::map<uint256, CAssetData>& mapissueassetinfo)
+    vector<int> vChangeHeight;
+    if(!GetRangeChangeHeight(nHeight, vChangeHeight))
+        return error("%s: get change files failed at %d", __func__, nHeight);
+
+    // 1. merge all.dat
+    boost::shared_ptr<const CAddressAmountView> pView = candySnapshotStore.Get("all.dat");
+    if(!pView)
+        return error("%s: map all.dat failed at %d", __func__, nHeight);
+    pView->MergeAmounts(vAddress, vAmount, 1);
+
+    // 2. merge change files
+    BOOST_FOREACH(const int& nChangeHeight, vChangeHeight)
+    {
+        const string strFile = itostr(nChangeHeight) + ".change";
+        pView = candySnapshotStore.Get(strFile);
+        if(!pView)
+            return error("%s: map %s failed at %d", __func__, strFile, nHeight);
+        pView->MergeAmounts(vAddress, vAmount, -1);
+    }
+
+    // 3. merge the pending deltas which are not compacted yet
+    if(!candyLedger.MergePending(nHeight, vAddress, vAmount))
+        return error("%s: merge pending deltas failed at %d", __func__, nHeight);
+
+    return true;
+}
+
+bool GetTotalAmountByHeight(const int& nHeight, CAmount& nTotalAmount)
+{
+    return pblocktree->Read_CandyHeight_TotalAmount_Index(nHeight, nTotalAmount);
+}
+
+bool GetCOutPointAddress(const uint256& assetId, std::map<COutPoint, std::vector<std::string>> &moutpointaddress)
+{
+    if (assetId.IsNull())
+        return false;
+
+    return pblocktree->Read_GetCandy_Index(assetId, moutpointaddress);
+}
+
+bool GetCOutPointList(const uint256& assetId, const std::string& strAddress, std::vector<COutPoint> &vcoutpoint)
+{
+    if (assetId.IsNull() || strAddress.empty())
+        return false;
+
+    return pblocktree->Read_GetCandy_Index(assetId, strAddress, vcoutpoint);
+}
+
+bool GetIssueAssetInfo(std::map<uint256, CAssetData>& mapissueassetinfo)
 {
     if (!pwalletMain)
         return false;
@@ -7889,6 +8182,242 @@ bool GetIssueAssetInfo(std::map<uint256, CAssetData>& mapissueassetinfo)
     return true;
 }
 
+static bool IsCandyExpired(const CCandyInfo& candyInfo, const int& nTxHeight, const int& nCurrentHeight)
+{
+    if (nTxHeight >= g_nStartSPOSHeight)
+        return candyInfo.nExpired * SPOS_BLOCKS_PER_MONTH + nTxHeight - 3 * SPOS_BLOCKS_PER_DAY < nCurrentHeight;
+
+    if (candyInfo.nExpired * BLOCKS_PER_MONTH + nTxHeight >= g_nStartSPOSHeight)
+    {
+        int nSPOSLaveHeight = (candyInfo.nExpired * BLOCKS_PER_MONTH + nTxHeight - g_nStartSPOSHeight) * (Params().GetConsensus().nPowTargetSpacing / Params().GetConsensus().nSPOSTargetSpacing);
+        int nTrueBlockHeight = g_nStartSPOSHeight + nSPOSLaveHeight;
+        return nTrueBlockHeight < nCurrentHeight;
+    }
+
+    return candyInfo.nExpired * BLOCKS_PER_MONTH + nTxHeight < nCurrentHeight;
+}
+
+/**
+ * Candies the wallet addresses can claim, keyed by the put-candy output. The
+ * table is stored in the wallet and covers every candy height up to
+ * nCandyEligibilityHeight for the wallet keys hashed as hashCandyEligibilityKeys,
+ * so that the candy list is available right after a restart.
+ */
+static std::mutex g_mutexCandyEligibility;
+static std::map<COutPoint, CCandyEligibility> mapCandyEligibility;
+static int nCandyEligibilityHeight = -1;
+static uint256 hashCandyEligibilityKeys;
+
+void LoadCandyEligibility(const CCandyEligibility& eligibility)
+{
+    std::lock_guard<std::mutex> lock(g_mutexCandyEligibility);
+    mapCandyEligibility[eligibility.info.outpoint] = eligibility;
+}
+
+void LoadCandyEligibilityMarker(const int& nHeight, const uint256& hashKeys)
+{
+    std::lock_guard<std::mutex> lock(g_mutexCandyEligibility);
+    nCandyEligibilityHeight = nHeight;
+    hashCandyEligibilityKeys = hashKeys;
+}
+
+void EraseCandyEligibility(const COutPoint& out)
+{
+    std::lock_guard<std::mutex> lock(g_mutexCandyEligibility);
+    if (!mapCandyEligibility.erase(out))
+        return;
+
+    CWalletDB walletdb(pwalletMain->strWalletFile);
+    if (!walletdb.EraseCandyEligibility(out))
+        LogPrintf("%s: erase candy %s failed\n", __func__, out.ToString());
+}
+
+static void AddCandyEligibility(const CCandyEligibility& eligibility)
+{
+    std::lock_guard<std::mutex> lock(g_mutexCandyEligibility);
+    mapCandyEligibility[eligibility.info.outpoint] = eligibility;
+
+    CWalletDB walletdb(pwalletMain->strWalletFile);
+    if (!walletdb.WriteCandyEligibility(eligibility.info.outpoint, eligibility))
+        LogPrintf("%s: write candy %s failed\n", __func__, eligibility.info.outpoint.ToString());
+}
+
+/** Store an entry whose claimed addresses were removed, unless the candy was erased meanwhile */
+static void UpdateCandyEligibility(const CCandyEligibility& eligibility)
+{
+    std::lock_guard<std::mutex> lock(g_mutexCandyEligibility);
+    std::map<COutPoint, CCandyEligibility>::iterator it = mapCandyEligibility.find(eligibility.info.outpoint);
+    if (it == mapCandyEligibility.end())
+        return;
+    it->second = eligibility;
+
+    CWalletDB walletdb(pwalletMain->strWalletFile);
+    if (!walletdb.WriteCandyEligibility(eligibility.info.outpoint, eligibility))
+        LogPrintf("%s: write candy %s failed\n", __func__, eligibility.info.outpoint.ToString());
+}
+
+/** Replace the whole table after a full scan of the candies up to nHeight */
+static void ResetCandyEligibility(const std::map<COutPoint, CCandyEligibility>& mapEligibility, const int& nHeight, const uint256& hashKeys)
+{
+    std::lock_guard<std::mutex> lock(g_mutexCandyEligibility);
+
+    CWalletDB walletdb(pwalletMain->strWalletFile);
+    for (std::map<COutPoint, CCandyEligibility>::const_iterator it = mapCandyEligibility.begin(); it != mapCandyEligibility.end(); it++)
+        walletdb.EraseCandyEligibility(it->first);
+    for (std::map<COutPoint, CCandyEligibility>::const_iterator it = mapEligibility.begin(); it != mapEligibility.end(); it++)
+        walletdb.WriteCandyEligibility(it->first, it->second);
+    walletdb.WriteCandyEligibilityMarker(nHeight, hashKeys);
+
+    mapCandyEligibility = mapEligibility;
+    nCandyEligibilityHeight = nHeight;
+    hashCandyEligibilityKeys = hashKeys;
+}
+
+/** Advance the covered height once the candies of nHeight were added, if nPrevHeight was covered */
+static void UpdateCandyEligibilityMarker(const int& nPrevHeight, const int& nHeight)
+{
+    std::lock_guard<std::mutex> lock(g_mutexCandyEligibility);
+    if (nCandyEligibilityHeight < 0 || nCandyEligibilityHeight != nPrevHeight)
+        return;
+
+    CWalletDB walletdb(pwalletMain->strWalletFile);
+    if (walletdb.WriteCandyEligibilityMarker(nHeight, hashCandyEligibilityKeys))
+        nCandyEligibilityHeight = nHeight;
+}
+
+uint256 GetCandyEligibilityKeysHash(const std::map<CKeyID, int64_t>& mapKeyBirth, const std::set<CKeyID>& setReserveKeys)
+{
+    CHashWriter ss(SER_GETHASH, 0);
+    for (std::map<CKeyID, int64_t>::const_iterator it = mapKeyBirth.begin(); it != mapKeyBirth.end(); it++)
+    {
+        if (!setReserveKeys.count(it->first))
+            ss << it->first;
+    }
+    return ss.GetHash();
+}
+
+/** Fill mapKeyBirth with the wallet keys and return the hash of those outside the key pool */
+static uint256 GetWalletCandyKeys(std::map<CKeyID, int64_t>& mapKeyBirth)
+{
+    {
+        LOCK(pwalletMain->cs_wallet);
+        pwalletMain->GetKeyBirthTimes(mapKeyBirth);
+    }
+
+    // GetAllReserveKeys takes cs_main, which must not be taken under cs_wallet
+    std::set<CKeyID> setReserveKeys;
+    pwalletMain->GetAllReserveKeys(setReserveKeys);
+    return GetCandyEligibilityKeysHash(mapKeyBirth, setReserveKeys);
+}
+
+static int GetLastCandyHeight()
+{
+    vector<int> vHeight;
+    if (!pblocktree->Read_CandyHeight_TotalAmount_Index(vHeight) || vHeight.empty())
+        return 0;
+    return *max_element(vHeight.begin(), vHeight.end());
+}
+
+bool GetCandyEligibility(std::vector<CCandy_BlockTime_Info>& vInfo, const int& nLastCandyHeight, const uint256& hashKeys)
+{
+    std::map<COutPoint, CCandyEligibility> mapEligibility;
+    {
+        std::lock_guard<std::mutex> lock(g_mutexCandyEligibility);
+        if (nCandyEligibilityHeight < 0 || nCandyEligibilityHeight < nLastCandyHeight || hashCandyEligibilityKeys != hashKeys)
+            return false;
+        mapEligibility = mapCandyEligibility;
+    }
+
+    // the stored entries may be outdated by claims made while the wallet was
+    // not loaded, so they are checked as GetAllCandyInfo checks a full scan
+    int nCurrentHeight = g_nChainHeight;
+    vInfo.clear();
+    for (std::map<COutPoint, CCandyEligibility>::iterator it = mapEligibility.begin(); it != mapEligibility.end(); it++)
+    {
+        boost::this_thread::interruption_point();
+        CCandyEligibility& eligibility = it->second;
+        const CCandy_BlockTime_Info& info = eligibility.info;
+        if (IsCandyExpired(info.candyinfo, info.nHeight, nCurrentHeight))
+        {
+            EraseCandyEligibility(it->first);
+            continue;
+        }
+
+        bool fClaimed = false;
+        CAmount nNowGetCandyTotalAmount = 0;
+        for (std::map<std::string, CAmount>::iterator addrIt = eligibility.mapAddressAmount.begin(); addrIt != eligibility.mapAddressAmount.end(); )
+        {
+            CAmount nTempAmount = 0;
+            if (GetGetCandyAmount(info.assetId, it->first, addrIt->first, nTempAmount))
+            {
+                eligibility.mapAddressAmount.erase(addrIt++);
+                fClaimed = true;
+                continue;
+            }
+            nNowGetCandyTotalAmount += addrIt->second;
+            addrIt++;
+        }
+
+        if (eligibility.mapAddressAmount.empty())
+        {
+            EraseCandyEligibility(it->first);
+            continue;
+        }
+        if (fClaimed)
+            UpdateCandyEligibility(eligibility);
+
+        CAmount dbamount = 0;
+        CAmount memamount = 0;
+        if (!GetGetCandyTotalAmount(info.assetId, it->first, dbamount, memamount))
+            continue;
+        if (nNowGetCandyTotalAmount + dbamount + memamount > info.candyinfo.nAmount)
+            continue;
+
+        vInfo.push_back(info);
+    }
+
+    // newest candies first, as GetAllCandyInfo lists them
+    sort(vInfo.begin(), vInfo.end(), [](const CCandy_BlockTime_Info& a, const CCandy_BlockTime_Info& b) { return a.nHeight > b.nHeight; });
+    return true;
+}
+
+/** Fill gAllCandyInfoVec from the eligibility table, fails if the table is missing or outdated */
+static bool GetAllCandyInfoFromEligibility(const uint256& hashKeys)
+{
+    int nLastCandyHeight = GetLastCandyHeight();
+
+    vector<CCandy_BlockTime_Info> vInfo;
+    if (!GetCandyEligibility(vInfo, nLastCandyHeight, hashKeys))
+        return false;
+
+    {
+        std::lock_guard<std::mutex> lock(g_mutexAllCandyInfo);
+        gAllCandyInfoVec = vInfo;
+
+        // candies of heights finalized meanwhile are already in the table
+        std::lock_guard<std::mutex> lockTmp(g_mutexTmpAllCandyInfo);
+        BOOST_FOREACH(const CCandy_BlockTime_Info& tmpInfo, gTmpAllCandyInfoVec)
+        {
+            bool fExist = false;
+            BOOST_FOREACH(const CCandy_BlockTime_Info& info, gAllCandyInfoVec)
+            {
+                if (info.outpoint == tmpInfo.outpoint)
+                {
+                    fExist = true;
+                    break;
+                }
+            }
+            if (!fExist)
+                gAllCandyInfoVec.insert(gAllCandyInfoVec.begin(), tmpInfo);
+        }
+    }
+
+    LogPrintf("%s: loaded %u candies up to height %d\n", __func__, vInfo.size(), nLastCandyHeight);
+    if (fHaveGUI)
+        uiInterface.CandyVecPut();
+    return true;
+}
+
 static bool GetAllCandyInfo()
 {
     unsigned int icounter = 0;
@@ -7905,10 +8434,14 @@ static bool GetAllCandyInfo()
     sort(vallassetidcandyinfolist.begin(), vallassetidcandyinfolist.end(), CompareCandyInfo());
 
     map<CKeyID, int64_t> mapKeyBirth;
-    {
-        LOCK(pwalletMain->cs_wallet);
-        pwalletMain->GetKeyBirthTimes(mapKeyBirth);
-    }
+    uint256 hashKeys = GetWalletCandyKeys(mapKeyBirth);
+
+    if (GetAllCandyInfoFromEligibility(hashKeys))
+        return true;
+
+    // heights finalized from now on are added by GetHeightAddressAmount
+    int nLastCandyHeight = GetLastCandyHeight();
+    std::map<COutPoint, CCandyEligibility> mapEligibility;
 
     int keyBirthCount = 0;
     std::vector<std::string> vaddress;
@@ -7923,6 +8456,10 @@ static bool GetAllCandyInfo()
         std::string saddress = CBitcoinAddress(tempit->first).ToString();
         vaddress.push_back(saddress);
     }
+    sort(vaddress.begin(), vaddress.end());
+
+    // candies put at the same height share the address amounts
+    map<int, vector<CAmount> > mapHeightAmounts;
 
     int nCurrentHeight = g_nChainHeight;
 
@@ -7963,26 +8500,8 @@ static bool GetAllCandyInfo()
 
         int64_t nTimeBegin = mapBlockIndex[candyInfoValue.blockHash]->GetBlockTime();
 
-        if (nTxHeight >= g_nStartSPOSHeight)
-        {
-            if (candyInfo.nExpired * SPOS_BLOCKS_PER_MONTH + nTxHeight - 3 * SPOS_BLOCKS_PER_DAY < nCurrentHeight)
-                continue;
-        }
-        else
-        {
-            if (candyInfo.nExpired * BLOCKS_PER_MONTH + nTxHeight >= g_nStartSPOSHeight)
-            {
-                int nSPOSLaveHeight = (candyInfo.nExpired * BLOCKS_PER_MONTH + nTxHeight - g_nStartSPOSHeight) * (Params().GetConsensus().nPowTargetSpacing / Params().GetConsensus().nSPOSTargetSpacing);
-                int nTrueBlockHeight = g_nStartSPOSHeight + nSPOSLaveHeight;
-                if (nTrueBlockHeight < nCurrentHeight)
-                    continue;
-            }
-            else
-            {
-                if (candyInfo.nExpired * BLOCKS_PER_MONTH + nTxHeight < nCurrentHeight)
-                    continue;
-            }
-        }
+        if (IsCandyExpired(candyInfo, nTxHeight, nCurrentHeight))
+            continue;
 
         CAmount nTotalSafe = 0;
         if(!GetTotalAmountByHeight(nTxHeight, nTotalSafe))
@@ -7991,16 +8510,25 @@ static bool GetAllCandyInfo()
         if (nTotalSafe <= 0)
             continue;
 
+        map<int, vector<CAmount> >::iterator amountIt = mapHeightAmounts.find(nTxHeight);
+        if (amountIt == mapHeightAmounts.end())
+        {
+            vector<CAmount> vAmount;
+            if (!GetAddressAmountsByHeight(nTxHeight, vaddress, vAmount))
+                continue;
+            amountIt = mapHeightAmounts.insert(make_pair(nTxHeight, vAmount)).first;
+        }
+        const vector<CAmount>& vAddressAmount = amountIt->second;
+
         bool relust = false;
+        CCandyEligibility eligibility;
         int addressSize = vaddress.size();
         for (int addrCount = 0; addrCount<addressSize;addrCount++)
         {
             boost::this_thread::interruption_point();
             if(addrCount%50==0&&addrCount!=0)
                 MilliSleep(10);
-            CAmount nSafe = 0;
-            if(!GetAddressAmountByHeight(nTxHeight, vaddress[addrCount], nSafe))
-                continue;
+            const CAmount& nSafe = vAddressAmount[addrCount];
             if (nSafe < 1 * COIN || nSafe > nTotalSafe)
                 continue;
 
@@ -8011,6 +8539,7 @@ static bool GetAllCandyInfo()
             {
                 relust = true;
                 nNowGetCandyTotalAmount += nCandyAmount;
+                eligibility.mapAddressAmount[vaddress[addrCount]] = nCandyAmount;
             }
         }
 
@@ -8021,6 +8550,8 @@ static bool GetAllCandyInfo()
         {
             fRet = true;
             CCandy_BlockTime_Info tempcandybolcktimeinfo(assetId,assetInfo.assetData,candyInfo,out,nTimeBegin,nTxHeight);
+            eligibility.info = tempcandybolcktimeinfo;
+            mapEligibility[out] = eligibility;
 
             icounter++;
             if (icounter <= nCandyPageCount && fHaveGUI)
@@ -8088,6 +8619,8 @@ static bool GetAllCandyInfo()
 			uiInterface.CandyVecPut();
     }
 
+    ResetCandyEligibility(mapEligibility, nLastCandyHeight, hashKeys);
+
     return fRet;
 }
 
@@ -8177,242 +8710,26 @@ static bool GetCandyHeightFromList(int& nCandyHeight)
     }
 
     if(listCandyHeight.empty())
-        return false;
-
-    nCandyHeight = listCandyHeight.front();
-    listCandyHeight.pop_front();
-    return true;
-}
-
-
-static void CloseFiles(vector<FILE**> vFiles)
-{
-    for(vector<FILE**>::iterator it = vFiles.begin(); it != vFiles.end(); it++)
-    {
-        if(**it)
-        {
-            fclose(**it);
-            **it = NULL;
-        }
-    }
-}
-
-static int BinarySearchFromFile(FILE* pFile, const string& strAddress, CAmount& nAmount, long* pPos = NULL);
-static bool MergeFileAndMap(const string& strSrcFile, const map<string, CAmount>& mapAddressAmount, const string& strDestFile)
-{
-    FILE *pSrcFile, *pDestFile;
-    pSrcFile = pDestFile = NULL;
-    vector<FILE**> vFiles;
-    vFiles.push_back(&pSrcFile);
-    vFiles.push_back(&pDestFile);
-
-    if(!(pSrcFile = fopen(strSrcFile.data(), "rb")))
-        return error("%s: open %s failed", __func__, strSrcFile);
-
-    if(!(pDestFile = fopen(strDestFile.data(), "wb")))
-    {
-        CloseFiles(vFiles);
-        return error("%s: open %s failed", __func__, strDestFile);
-    }
-
-    CAmount nAmount = 0;
-    long nPos = 0;
-    long nNextPos = 0;
-    int nRet = 0;
-    CAddressAmount arr[BATCH_COUNT];
-    map<string, CAmount>::const_iterator it = mapAddressAmount.begin();
-    for(; it != mapAddressAmount.end(); it++)
-    {
-        nRet = BinarySearchFromFile(pSrcFile, it->first, nAmount, &nPos);
-        if(nRet == -1)
-        {
-            CloseFiles(vFiles);
-            return error("%s: search %s from %s failed", __func__, it->first, strSrcFile);
-        }
-
-        if(fseek(pSrcFile, nNextPos * sizeof(CAddressAmount), SEEK_SET))
-        {
-            CloseFiles(vFiles);
-            return error("%s: fseek %s failed", __func__, strSrcFile);
-        }
-
-        long nCount = nPos - nNextPos;
-        if(nCount < 0)
-        {
-            CloseFiles(vFiles);
-            return error("%s: unorder data from %s and map", __func__, strSrcFile);
-        }
-
-        for(long i = 0; i < nCount / BATCH_COUNT; i++)
-        {
-            if(fread(arr, sizeof(CAddressAmount), BATCH_COUNT, pSrcFile) != BATCH_COUNT)
-            {
-                CloseFiles(vFiles);
-                return error("%s: 1-read %s failed", __func__, strSrcFile);
-            }
-            if(fwrite(arr, sizeof(CAddressAmount), BATCH_COUNT, pDestFile) != BATCH_COUNT)
-            {
-                CloseFiles(vFiles);
-                return error("%s: 1-write %s failed", __func__, strDestFile);
-            }
-        }
-        size_t nSize = nCount % BATCH_COUNT;
-        if(nSize)
-        {
-            if(fread(arr, sizeof(CAddressAmount), nSize, pSrcFile) != nSize)
-            {
-                CloseFiles(vFiles);
-                return error("%s: 2-read %s failed", __func__, strSrcFile);
-            }
-            if(fwrite(arr, sizeof(CAddressAmount), nSize, pDestFile) != nSize)
-            {
-                CloseFiles(vFiles);
-                return error("%s: 2-write %s failed", __func__, strDestFile);
-            }
-        }
-
-        CAddressAmount temp;
-        if(nRet == 0)
-        {
-            nNextPos = nPos + 1;
-            if(fread(&temp, sizeof(CAddressAmount), 1, pSrcFile) != 1)
-            {
-                CloseFiles(vFiles);
-                return error("%s: 3-read: %s failed", __func__, strSrcFile);
-            }
-            temp.nAmount += it->second;
-            if(temp.nAmount == 0)
-                continue;
-        }
-        else if(nRet == 1)
-        {
-            temp = CAddressAmount(it->first, it->second);
-            nNextPos = nPos;
-        }
-        else
-            break;
-
-        if(fwrite(&temp, sizeof(CAddressAmount), 1, pDestFile) != 1)
-        {
-            CloseFiles(vFiles);
-            return error("%s: 3-write %s failed", __func__, strDestFile);
-        }
-    }
-
-    if(nRet == 2)
-    {
-        for(; it != mapAddressAmount.end(); it++)
-        {
-            CAddressAmount temp(it->first, it->second);
-            if(fwrite(&temp, sizeof(CAddressAmount), 1, pDestFile) != 1)
-            {
-                CloseFiles(vFiles);
-                return error("%s: 5-write %s failed", __func__, strDestFile);
-            }
-        }
-    }
-    else
-    {
-        size_t nSize = 0;
-        while(!feof(pSrcFile))
-        {
-            if((nSize = fread(arr, sizeof(CAddressAmount), BATCH_COUNT, pSrcFile)) == 0)
-            {
-                if(feof(pSrcFile))
-                    break;
-                CloseFiles(vFiles);
-                return error("%s: 6-read from %s failed", __func__, strSrcFile);
-            }
-            if(nSize != fwrite(arr, sizeof(CAddressAmount), nSize, pDestFile))
-            {
-                CloseFiles(vFiles);
-                return error("%s: 6-write to %s failed", __func__, strDestFile);
-            }
-        }
-    }
-
-    CloseFiles(vFiles);
-    return true;
-}
-
-/*
- * error: < 0
- * found: = 0
- * none: > 0 (2: strAdress is more than all of file, 1: strAddress is a median)
- */
-static int BinarySearchFromFile(const string& strFile, const string& strAddress, CAmount& nAmount, long* pPos)
-{
-    const string strFullName = GetDataDir().string() + "/height/" + strFile;
-    FILE* pFile = fopen(strFullName.data(), "rb");
-    if(!pFile)
-        return false;
-
-    int nRet = BinarySearchFromFile(pFile, strAddress, nAmount, pPos);
-    fclose(pFile);
-    return nRet;
-}
-
-static int BinarySearchFromFile(FILE* pFile, const string& strAddress, CAmount& nAmount, long* pPos)
-{
-    if(!pFile) // error
-        return -1;
-
-    if(fseek(pFile, 0L, SEEK_END))
-    {
-        LogPrintf("%s: fseek failed\n", __func__);
-        return -1;
-    }
-
-    long nFileLen = ftell(pFile);
-    if(nFileLen < 0) // error
-    {
-        LogPrintf("%s: ftell failed\n", __func__);
-        return -1;
-    }
-
-    CAddressAmount data;
-
-    long high = nFileLen / sizeof(CAddressAmount);
-    long low = 0;
-    long mid = 0;
-    int nCmp = 0;
-    while(low <= high)
-    {
-        mid = (low + high) / 2;
-
-        if(fseek(pFile, mid * sizeof(CAddressAmount), SEEK_SET))
-        {
-            LogPrintf("%s: fseek failed\n", __func__);
-            return -1;
-        }
+        return false;
 
-        if(1 != fread(&data, sizeof(CAddressAmount), 1, pFile))
-        {
-            if(feof(pFile))
-            {
-                if(pPos) *pPos = high;
-                return 2;
-            }
+    nCandyHeight = listCandyHeight.front();
+    listCandyHeight.pop_front();
+    return true;
+}
 
-            LogPrintf("%s: fread failed\n", __func__);
-            return -1;
-        }
 
-        nCmp = strcmp(data.szAddress, strAddress.data());
-        if(nCmp < 0)
-            low = mid + 1;
-        else if(nCmp > 0)
-            high = mid - 1;
-        else // found
-        {
-            nAmount = data.nAmount;
-            if(pPos) *pPos = mid;
-            return 0;
-        }
-    }
+/*
+ * error: < 0
+ * found: = 0
+ * none: > 0 (2: strAdress is more than all of file, 1: strAddress is a median)
+ */
+static int BinarySearchFromFile(const string& strFile, const string& strAddress, CAmount& nAmount, long* pPos)
+{
+    boost::shared_ptr<const CAddressAmountView> pView = candySnapshotStore.Get(strFile);
+    if(!pView)
+        return -1;
 
-    if(pPos) *pPos = low;
-    return 1;
+    return pView->Find(strAddress, nAmount, pPos);
 }
 
 static bool GetChangeFilterAmount(const int& nStartHeight, const int& nEndHeight, CAmount& nChangeAmount, CAmount& nFilterAmount)
@@ -8531,6 +8848,11 @@ static bool GetHeightAddressAmount(const int& nCandyHeight)
         std::string saddress = CBitcoinAddress(tempit->first).ToString();
         vaddress.push_back(saddress);
     }
+    sort(vaddress.begin(), vaddress.end());
+
+    vector<CAmount> vAddressAmount;
+    if(!GetAddressAmountsByHeight(nCandyHeight, vaddress, vAddressAmount))
+        vAddressAmount.assign(vaddress.size(), 0);
 
     int nCurrentHeight = g_nChainHeight;
     BOOST_FOREACH(const CTransaction& tx, candyBlock.vtx)
@@ -8561,53 +8883,33 @@ static bool GetHeightAddressAmount(const int& nCandyHeight)
             COutPoint out(tx.GetHash(), i);
             CCandy_BlockTime_Info candyblocktimeinfo(assetId, assetInfo.assetData, CCandyInfo(candyData.nAmount, candyData.nExpired),out , candyBlock.nTime, nCandyHeight);
 
-            if (nCandyHeight >= g_nStartSPOSHeight)
-            {
-                if (candyData.nExpired * SPOS_BLOCKS_PER_MONTH + nCandyHeight - 3 * SPOS_BLOCKS_PER_DAY< nCurrentHeight)
-                    continue;
-            }
-            else
-            {
-                if (candyData.nExpired * BLOCKS_PER_MONTH + nCandyHeight >= g_nStartSPOSHeight)
-                {
-                    int nSPOSLaveHeight = (candyData.nExpired * BLOCKS_PER_MONTH + nCandyHeight - g_nStartSPOSHeight) * (Params().GetConsensus().nPowTargetSpacing / Params().GetConsensus().nSPOSTargetSpacing);
-                    int nTrueBlockHeight = g_nStartSPOSHeight + nSPOSLaveHeight;
-                    if (nTrueBlockHeight < nCurrentHeight)
-                        continue;
-                }
-                else
-                {
-                    if (candyData.nExpired * BLOCKS_PER_MONTH + nCandyHeight < nCurrentHeight)
-                        continue;
-                }
-            }
+            if (IsCandyExpired(CCandyInfo(candyData.nAmount, candyData.nExpired), nCandyHeight, nCurrentHeight))
+                continue;
 
             if(nCandyHeight > nCurrentHeight)
                 continue;
 
-            bool result = false;
-            for (std::vector<std::string>::iterator addit = vaddress.begin(); addit != vaddress.end(); addit++)
+            CCandyEligibility eligibility;
+            eligibility.info = candyblocktimeinfo;
+            for (unsigned int i = 0; i < vaddress.size(); i++)
             {
                 boost::this_thread::interruption_point();
 
-                CAmount nSafe = 0;
-                if(!GetAddressAmountByHeight(nCandyHeight, *addit, nSafe))
-                    continue;
+                const CAmount& nSafe = vAddressAmount[i];
                 if (nSafe < 1 * COIN || nSafe > nTotalAmount)
                     continue;
 
                 CAmount nTempAmount = 0;
                 CAmount nCandyAmount = (CAmount)(1.0 * nSafe / nTotalAmount * candyData.nAmount);
-                if (nCandyAmount >= AmountFromValue("0.0001", assetInfo.assetData.nDecimals, true) && !GetGetCandyAmount(assetId, out, *addit, nTempAmount,false))
-                {
-                    result = true;
-                    break;
-                }
+                if (nCandyAmount >= AmountFromValue("0.0001", assetInfo.assetData.nDecimals, true) && !GetGetCandyAmount(assetId, out, vaddress[i], nTempAmount,false))
+                    eligibility.mapAddressAmount[vaddress[i]] = nCandyAmount;
             }
 
-            if(!result)
+            if(eligibility.mapAddressAmount.empty())
                 continue;
 
+            AddCandyEligibility(eligibility);
+
             if(fUpdateAllCandyInfoFinished)
             {
                 if(gAllCandyInfoVec.size()<nCandyPageCount)
@@ -8625,6 +8927,8 @@ static bool GetHeightAddressAmount(const int& nCandyHeight)
     if(fUpdateUI && fHaveGUI)
 		uiInterface.CandyVecPut();
 
+    UpdateCandyEligibilityMarker(nLastCandyHeight, nCandyHeight);
+
     return true;
 }
 
@@ -8726,42 +9030,187 @@ static bool WriteDetailFile(const string& strFile, const CBlockDetail& detail)
     return bRet;
 }
 
-static bool WriteChangeFile(const string& strFile, const map<string, CAmount>& mapAddressAmount)
+/** Address amount changes of one block, built off the main thread by LoadChangeInfoToList */
+struct CBlockChangeData
+{
+    CBlockIndex* pindex;
+    CAmount nReward;
+    bool fCandy;
+    std::map<std::string, CAmount> mapAddressAmount;
+    std::vector<uint256> vTxHash;
+    bool fValid;
+    std::string strError;
+
+    CBlockChangeData() : pindex(NULL), nReward(0), fCandy(false), fValid(false) {}
+};
+
+/**
+ * Get the creation height of a spent output. The undo record only carries it when the
+ * last output of the transaction was spent, otherwise try the recently built blocks,
+ * the UTXO set and finally the transaction index.
+ */
+static bool GetSpentTxHeight(const uint256& txid, const CTxInUndo& undo, const limitedmap<uint256, int>& mapTxHeight, int& nTxHeight)
+{
+    if(undo.nHeight > 0)
+    {
+        nTxHeight = undo.nHeight;
+        return true;
+    }
+
+    limitedmap<uint256, int>::const_iterator it = mapTxHeight.find(txid);
+    if(it != mapTxHeight.end())
+    {
+        nTxHeight = it->second;
+        return true;
+    }
+
+    {
+        LOCK(cs_main);
+        const CCoins* coins = pcoinsTip->AccessCoins(txid);
+        if(coins && !coins->IsPruned())
+        {
+            nTxHeight = coins->nHeight;
+            return true;
+        }
+    }
+
+    CTransaction tx;
+    uint256 blockHash;
+    if(!GetTransaction(txid, tx, Params().GetConsensus(), blockHash, true) || blockHash.IsNull())
+        return false;
+
+    LOCK(cs_main);
+    BlockMap::iterator mi = mapBlockIndex.find(blockHash);
+    if(mi == mapBlockIndex.end())
+        return false;
+
+    nTxHeight = mi->second->nHeight;
+    return true;
+}
+
+static void AddAddressAmount(std::map<std::string, CAmount>& mapAddressAmount, const std::string& strAddress, const CAmount& nAmount)
+{
+    CAmount& nTotal = mapAddressAmount[strAddress];
+    nTotal += nAmount;
+    if(nTotal == 0)
+        mapAddressAmount.erase(strAddress);
+}
+
+static bool BuildBlockChangeData(CBlockChangeData& data, const limitedmap<uint256, int>& mapTxHeight)
 {
-    string strTempFile = strFile + ".temp";
-    boost::filesystem::remove(strTempFile);
-    if(!MergeFileAndMap(strFile, mapAddressAmount, strTempFile))
+    CBlockIndex* pindex = data.pindex;
+
+    CBlock block;
+    if(!ReadBlockFromDisk(block, pindex, Params().GetConsensus()))
+    {
+        data.strError = strprintf("read block from disk failed, hash=%s", pindex->GetBlockHash().ToString());
+        return false;
+    }
+
+    // spent outputs come from the undo data instead of one transaction lookup per input
+    CBlockUndo blockUndo;
+    if(block.vtx.size() > 1)
     {
-        boost::filesystem::remove(strTempFile);
-        return error("%s: merge address information to %s failed", __func__, strFile);
+        CDiskBlockPos pos = pindex->GetUndoPos();
+        if(pos.IsNull() || !UndoReadFromDisk(blockUndo, pos, pindex->pprev->GetBlockHash()))
+        {
+            data.strError = strprintf("read undo data failed, hash=%s", pindex->GetBlockHash().ToString());
+            return false;
+        }
+        if(blockUndo.vtxundo.size() + 1 != block.vtx.size())
+        {
+            data.strError = strprintf("undo data mismatch, hash=%s", pindex->GetBlockHash().ToString());
+            return false;
+        }
     }
 
-    string strBakFile = strFile + ".bak";
-    boost::filesystem::remove(strBakFile);
-    if(!RenameOver(strFile, strBakFile))
+    string strAddress = "";
+    for(size_t i = 0; i < block.vtx.size(); i++)
     {
-        boost::filesystem::remove(strTempFile);
-        return error("%s: backup %s to %s failed", __func__, strFile, strBakFile);
+        const CTransaction& tx = block.vtx[i];
+        data.vTxHash.push_back(tx.GetHash());
+
+        // vin
+        if(!tx.IsCoinBase())
+        {
+            const CTxUndo& txundo = blockUndo.vtxundo[i - 1];
+            if(txundo.vprevout.size() != tx.vin.size())
+            {
+                data.strError = strprintf("undo data mismatch, txid=%s", tx.GetHash().ToString());
+                return false;
+            }
+
+            for(size_t j = 0; j < tx.vin.size(); j++)
+            {
+                const CTxInUndo& undo = txundo.vprevout[j];
+                if(undo.txout.IsAsset() || !GetTxOutAddress(undo.txout, &strAddress))
+                    continue;
+
+                int nTxHeight = 0;
+                if(!GetSpentTxHeight(tx.vin[j].prevout.hash, undo, mapTxHeight, nTxHeight))
+                {
+                    data.strError = strprintf("get height of txin transaction failed, hash=%s", tx.vin[j].prevout.hash.ToString());
+                    return false;
+                }
+
+                if(nTxHeight < g_nCriticalHeight)
+                    continue;
+
+                AddAddressAmount(data.mapAddressAmount, strAddress, -undo.txout.nValue);
+            }
+        }
+
+        for(size_t j = 0; j < tx.vout.size(); j++)
+        {
+            const CTxOut& txout = tx.vout[j];
+            uint32_t nAppCmd = 0;
+            if(txout.IsAsset(&nAppCmd))
+            {
+                if(nAppCmd == PUT_CANDY_CMD)
+                    data.fCandy = true;
+                continue;
+            }
+
+            if(!GetTxOutAddress(txout, &strAddress))
+                continue;
+
+            AddAddressAmount(data.mapAddressAmount, strAddress, txout.nValue);
+        }
     }
 
-    if(!RenameOver(strTempFile, strFile))
+    if(CheckCriticalBlock(block))
+        data.nReward = g_nCriticalReward;
+    else
     {
-        boost::filesystem::remove(strTempFile);
-        if(!RenameOver(strBakFile, strFile))
-            throw std::runtime_error(strprintf("%s: Restore %s to %s faield, missing address information", __func__, strBakFile, strFile));
-        boost::filesystem::remove(strBakFile);
-        return error("%s: rename %s to %s failed", __func__, strTempFile, strFile);
+        if (pindex->nHeight >= g_nStartSPOSHeight)
+            data.nReward = GetSPOSBlockSubsidy(pindex->pprev->nHeight, Params().GetConsensus());
+        else
+            data.nReward = GetBlockSubsidy(pindex->pprev->nBits, pindex->pprev->nHeight, Params().GetConsensus());
     }
 
-    boost::filesystem::remove(strBakFile);
     return true;
 }
 
+static void BuildBlockChangeRange(std::vector<CBlockChangeData>& vData, const int nOffset, const int nStride, const limitedmap<uint256, int>& mapTxHeight)
+{
+    RenameThread("safe-loadchange");
+
+    for(size_t i = nOffset; i < vData.size(); i += nStride)
+        vData[i].fValid = BuildBlockChangeData(vData[i], mapTxHeight);
+}
+
 static int g_nLastCandyHeight = 0;
+
 bool LoadChangeInfoToList()
 {
     boost::filesystem::path heightDir = GetDataDir() / "height";
 
+    {
+        std::lock_guard<std::mutex> lock(g_mutexChangeFile);
+        if(!candyLedger.Load())
+            return error("%s: load candy ledger failed", __func__);
+    }
+
     string strAllFile = heightDir.string() + "/all.dat";
     if(!boost::filesystem::exists(strAllFile))
     {
@@ -8811,106 +9260,42 @@ bool LoadChangeInfoToList()
             g_nLastCandyHeight = detail.nLastCandyHeight;
     }
 
-    for(int nHeight = nLastHeight + 1; nHeight <= chainActive.Height(); nHeight++)
-    {
-        CBlockIndex* pindex = chainActive[nHeight];
-
-        CBlock block;
-        if(!ReadBlockFromDisk(block, pindex, Params().GetConsensus()))
-        {
-            fclose(pFile);
-            return error("%s: read block from disk failed at %d, hash=%s", __func__, pindex->nHeight, pindex->GetBlockHash().ToString());
-        }
-
-        map<string, CAmount> mapAddressAmount;
-        string strAddress = "";
-        bool bExistCandy = false;
-
-        for(size_t i = 0; i < block.vtx.size(); i++)
-        {
-            const CTransaction& tx = block.vtx[i];
-
-            // vin
-            if(!tx.IsCoinBase())
-            {
-                for(size_t j = 0; j < tx.vin.size(); j++)
-                {
-                    const CTxIn& txin = tx.vin[j];
+    fclose(pFile);
 
-                    CTransaction in_tx;
-                    uint256 in_blockHash;
-                    if(!GetTransaction(txin.prevout.hash, in_tx, Params().GetConsensus(), in_blockHash, true) || in_blockHash.IsNull())
-                    {
-                        fclose(pFile);
-                        return error("%s: read txin transaction failed, hash=%s", __func__, txin.prevout.hash.ToString());
-                    }
+    // Build the change info of missing blocks in parallel batches and commit them in height order
+    const int nThreads = std::max(1, std::min(GetNumCores(), MAX_CHANGE_INFO_THREADS));
+    const int nBatchSize = nThreads * CHANGE_INFO_BLOCKS_PER_THREAD;
+    limitedmap<uint256, int> mapTxHeight(CHANGE_INFO_TX_HEIGHT_CACHE);
 
-                    const CTxOut& in_txout = in_tx.vout[txin.prevout.n];
-                    if(in_txout.IsAsset() || !GetTxOutAddress(in_txout, &strAddress))
-                        continue;
+    for(int nStartHeight = nLastHeight + 1; nStartHeight <= chainActive.Height(); nStartHeight += nBatchSize)
+    {
+        int nEndHeight = std::min(nStartHeight + nBatchSize - 1, chainActive.Height());
 
-                    if(mapBlockIndex.count(in_blockHash) == 0 || mapBlockIndex[in_blockHash]->nHeight < g_nCriticalHeight)
-                        continue;
+        std::vector<CBlockChangeData> vData(nEndHeight - nStartHeight + 1);
+        for(unsigned int i = 0; i < vData.size(); i++)
+            vData[i].pindex = chainActive[nStartHeight + i];
 
-                    if(mapAddressAmount.count(strAddress))
-                    {
-                        mapAddressAmount[strAddress] += -in_txout.nValue;
-                        if(mapAddressAmount[strAddress] == 0)
-                            mapAddressAmount.erase(strAddress);
-                    }
-                    else
-                        mapAddressAmount[strAddress] = -in_txout.nValue;
-                }
-            }
+        boost::thread_group threadGroup;
+        for(int i = 0; i < nThreads; i++)
+            threadGroup.create_thread(boost::bind(&BuildBlockChangeRange, boost::ref(vData), i, nThreads, boost::cref(mapTxHeight)));
+        threadGroup.join_all();
 
-            for(size_t j = 0; j < tx.vout.size(); j++)
-            {
-                const CTxOut& txout = tx.vout[j];
-                if(txout.IsAsset() || !GetTxOutAddress(txout, &strAddress))
-                    continue;
+        for(unsigned int i = 0; i < vData.size(); i++)
+        {
+            const CBlockChangeData& data = vData[i];
+            if(!data.fValid)
+                return error("%s: build change info failed at %d: %s", __func__, data.pindex->nHeight, data.strError);
 
-                if(mapAddressAmount.count(strAddress))
-                {
-                    mapAddressAmount[strAddress] += txout.nValue;
-                    if(mapAddressAmount[strAddress] == 0)
-                        mapAddressAmount.erase(strAddress);
-                }
-                else
-                    mapAddressAmount[strAddress] = txout.nValue;
-            }
+            g_listChangeInfo.push_back(CChangeInfo(data.pindex->nHeight, g_nLastCandyHeight, data.nReward, data.fCandy, data.mapAddressAmount));
 
-            for(size_t j = 0; j < tx.vout.size(); j++)
-            {
-                const CTxOut& txout = tx.vout[j];
-                uint32_t nAppCmd = 0;
-                if(!txout.IsAsset(&nAppCmd))
-                    continue;
-                if(nAppCmd == PUT_CANDY_CMD)
-                {
-                    bExistCandy = true;
-                    break;
-                }
-            }
-        }
+            if(data.fCandy)
+                g_nLastCandyHeight = data.pindex->nHeight;
 
-        CAmount blockReward = 0;
-        if(CheckCriticalBlock(block))
-            blockReward = g_nCriticalReward;
-        else
-        {
-            if (pindex->nHeight >= g_nStartSPOSHeight)
-                blockReward = GetSPOSBlockSubsidy(pindex->pprev->nHeight, Params().GetConsensus());
-            else
-                blockReward = GetBlockSubsidy(pindex->pprev->nBits, pindex->pprev->nHeight, Params().GetConsensus());
+            BOOST_FOREACH(const uint256& txid, data.vTxHash)
+                mapTxHeight.insert(std::make_pair(txid, data.pindex->nHeight));
         }
-
-        g_listChangeInfo.push_back(CChangeInfo(pindex->nHeight, g_nLastCandyHeight, blockReward, bExistCandy, mapAddressAmount));
-
-        if(bExistCandy)
-            g_nLastCandyHeight = pindex->nHeight;
     }
 
-    fclose(pFile);
     return true;
 }
 
@@ -9056,6 +9441,7 @@ static void DeleteFilesToHeight(const int& nHeight)
         if(nTempHeight >= nHeight)
             continue;
 
+        candySnapshotStore.Release(strFileName);
         boost::filesystem::remove(iter->path());
     }
 }
@@ -9071,44 +9457,20 @@ static bool WriteChangeInfo(const CChangeInfo& changeInfo)
 
     static int nStep = 0;
 
-    // 1. write all.dat
+    // 1. append the changed address amount as a pending delta, compaction moves it to all.dat and the change file
     if(nStep == 0)
     {
-        string strAllFile = heightDir.string() + "/all.dat";
         try {
-            if(!WriteChangeFile(strAllFile, changeInfo.mapAddressAmount))
-                return error("%s: write all.dat at %d failed", __func__, changeInfo.nHeight);
+            if(!candyLedger.AppendDelta(changeInfo.nHeight, changeInfo.nLastCandyHeight, changeInfo.mapAddressAmount))
+                return error("%s: append changed address amount in block %d failed", __func__, changeInfo.nHeight);
         } catch (const boost::filesystem::filesystem_error& e) {
-            return error("%s: write all.dat at %d throw exception", __func__, changeInfo.nHeight);
+            return error("%s: append changed address amount in block %d throw exception", __func__, changeInfo.nHeight);
         }
         nStep = 1;
     }
 
-    // 2. write change file
+    // 2. write detail.dat
     if(nStep == 1)
-    {
-        if(changeInfo.nLastCandyHeight > 0)
-        {
-            string strChangeFile = heightDir.string() + "/" + itostr(changeInfo.nLastCandyHeight) + ".change";
-            if(changeInfo.nHeight == changeInfo.nLastCandyHeight + 1)
-            {
-                FILE* pChangeFile = fopen(strChangeFile.data(), "ab+");
-                if(!pChangeFile)
-                    return error("%s: create empty change file %s at %d failed", strChangeFile, changeInfo.nHeight);
-                fclose(pChangeFile);
-            }
-            try {
-                if(!WriteChangeFile(strChangeFile, changeInfo.mapAddressAmount))
-                    return error("%s: write changed address amount in block %d to %s failed", __func__, changeInfo.nHeight, strChangeFile);
-            } catch (const boost::filesystem::filesystem_error& e) {
-                return error("%s: write changed address amount in block %d to %s throw exception", __func__, changeInfo.nHeight, strChangeFile);
-            }
-        }
-        nStep = 2;
-    }
-
-    // 3. write detail.dat
-    if(nStep == 2)
     {
         string strDetailFile = heightDir.string() + "/detail.dat";
 
@@ -9129,19 +9491,19 @@ static bool WriteChangeInfo(const CChangeInfo& changeInfo)
         CBlockDetail detail(changeInfo.nHeight, changeInfo.nLastCandyHeight, changeInfo.nReward, nFilterAmount, changeInfo.fCandy);
         if(!WriteDetailFile(strDetailFile, detail))
             return error("%s: write %d to detail.dat failed", __func__, changeInfo.nHeight);
-        nStep = 3;
+        nStep = 2;
     }
 
-    // 4. write candy information
-    if(nStep == 3)
+    // 3. write candy information
+    if(nStep == 2)
     {
         if(changeInfo.fCandy && !PutCandyHeightToList(changeInfo.nHeight))
             return error("%s: put candy height %d to list failed", __func__, changeInfo.nHeight);
-        nStep = 4;
+        nStep = 3;
     }
 
-    // 5. remove change file before 3 month
-    if(nStep == 4)
+    // 4. remove change file before 3 month
+    if(nStep == 3)
     {
         int nEndHeight = 0;
         if (changeInfo.nHeight >= g_nStartSPOSHeight)
@@ -9162,6 +9524,7 @@ static bool WriteChangeInfo(const CChangeInfo& changeInfo)
         DeleteFilesToHeight(nEndHeight);
     }
 
+    candyLedger.CloseDelta();
     nStep = 0;
     return true;
 }
@@ -9187,38 +9550,16 @@ void ThreadWriteChangeInfo()
 		}
 		else
 			MilliSleep(10);
-	}
-}
-
-void resetNumA(std::string numAStr)
-{
-    memset(numA, 0, M * sizeof(int));
-
-    for (uint32_t i = 0; i < numAStr.length(); i++)
-        numA[i] = numAStr[numAStr.length() - i - 1] - '0';
-}
-
-void resetNumB(std::string numBStr)
-{
-    memset(numB, 0, M * sizeof(int));
 
-    for (uint32_t i = 0; i < numBStr.length(); i++)
-        numB[i] = numBStr[numBStr.length()-i-1] - '0';
-}
-
-std::string getNumString(int* num)
-{
-    std::string numString = "";
-    bool isBegin = false;
-    for (int i = M - 1; i >= 0 ; i--)
-    {
-        if(num[i] != 0)
-            isBegin = true;
-
-        if (isBegin)
-            numString += num[i] + '0';
-    }
-    return numString;
+		bool fCompact = false;
+		{
+			std::lock_guard<std::mutex> lock(g_mutexChangeFile);
+			fCompact = candyLedger.NeedCompact();
+		}
+		// the ledger takes the lock itself, only to swap in the compacted files
+		if (fCompact && !candyLedger.Compact(g_mutexChangeFile))
+			LogPrintf("ThreadWriteChangeInfo: compact candy ledger failed\n");
+	}
 }
 
 int comparestring(std::string numAStr, std::string numBStr)
@@ -9302,91 +9643,6 @@ int compareFloatString(const std::string& numAStr,const std::string& numBStr,boo
     return comparestring(posAFloatStr,posBFloatStr);
 }
 
-std::string plusstring(std::string numAStr, std::string numBStr)
-{
-    resetNumA(numAStr);
-    resetNumB(numBStr);
-
-    for (int i = 0; i < M; i++)
-    {
-        numA[i] += numB[i];
-
-        if(numA[i] > 9)
-        {
-            numA[i] -= 10;
-            numA[i+1]++;
-        }
-    }
-
-    return getNumString(numA);
-}
-
-std::string minusstring(std::string numAStr, std::string numBStr)
-{
-    bool isNegative = false;
-
-    if (comparestring(numAStr,numBStr)==-1)
-    {
-        isNegative = true;
-        string temp = numAStr;
-        numAStr = numBStr;
-        numBStr = temp;
-    }
-    else if (comparestring(numAStr,numBStr)==0)
-        return "0";
-
-    resetNumA(numAStr);
-    resetNumB(numBStr);
-
-    for (int i = 0; i < M; i++)
-    {
-        if (numA[i]<numB[i])
-        {
-            numA[i] = numA[i]+10-numB[i];
-            numA[i+1]--;
-        }
-        else
-            numA[i] -= numB[i];
-    }
-
-    if (isNegative)
-        return "-"+  getNumString(numA);
-    else
-        return getNumString(numA);
-}
-
-std::string mulstring(std::string numAStr, std::string numBStr)
-{
-    resetNumA(numAStr);
-    resetNumB(numBStr);
-
-    vector<string> vnums;
-    for (uint32_t i = 0; i < numBStr.length(); i++)
-    {
-        int tempnum[M];
-        memset(tempnum, 0, M * sizeof(int));
-
-        for (uint32_t j = i; j < numAStr.length() + i; j++)
-        {
-            tempnum[j] += numA[j - i] * numB[i] % 10;
-            tempnum[j + 1] = numA[j - i] * numB[i] /10;
-            if (tempnum[j] > 9)
-            {
-                tempnum[j] -= 10;
-                tempnum[j + 1]++;
-            }
-        }
-
-        vnums.push_back(getNumString(tempnum));
-    }
-
-    string strresult = vnums[0];
-    for (uint32_t i = 1; i < vnums.size(); i++)
-        strresult = plusstring(strresult, vnums[i]);
-
-    return strresult;
-}
-
 std::string numtofloatstring(std::string numstr, int32_t Decimals)
 {
     if (numstr.empty())
@@ -9538,28 +9794,28 @@ void CalculateIncreaseMasternode(int& nRemainNum,int& nIncrease,unsigned int vec
     }
 }
 
-void SortMasternodeByScore(std::map<COutPoint, CMasternode> &mapMasternodes, std::vector<CMasternode>& vecResultMasternodes,uint32_t nScoreTime,
+void SortMasternodeByScore(const std::map<COutPoint, const CMasternode*> &mapMasternodes, std::vector<CMasternode>& vecResultMasternodes,uint32_t nScoreTime,
                            std::string strArrName,std::map<std::string,CMasternodePayee_IndexValue>& mapAllPayeeInfo)
 {
     //sort by score
-    std::map<uint256, CMasternode> scoreMasternodes;
-    for (std::map<COutPoint, CMasternode>::const_reverse_iterator mnpair = mapMasternodes.rbegin(); mnpair != mapMasternodes.rend(); ++mnpair)
+    std::map<uint256, const CMasternode*> scoreMasternodes;
+    for (std::map<COutPoint, const CMasternode*>::const_reverse_iterator mnpair = mapMasternodes.rbegin(); mnpair != mapMasternodes.rend(); ++mnpair)
     {
-        const CMasternode& mn = (*mnpair).second;
+        const CMasternode& mn = *(*mnpair).second;
 
         uint256 hash = mn.pubKeyCollateralAddress.GetHash();
         CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
         ss << hash;
         ss << nScoreTime;
         uint256 score = ss.GetHash();
-        scoreMasternodes[score] = mn;
+        scoreMasternodes[score] = &mn;
     }
 
     int logErrorCnt = 0, logNormalCnt = 0;
     LogPrintf("SPOS_Message:%s(size:%d) after sort:\n",strArrName,scoreMasternodes.size());
     for (auto& mnpair : scoreMasternodes)
     {
-        std::string strPubKeyCollateralAddress = mnpair.second.pubKeyCollateralAddress.GetID().ToString();
+        std::string strPubKeyCollateralAddress = mnpair.second->pubKeyCollateralAddress.GetID().ToString();
         std::map<std::string,CMasternodePayee_IndexValue>::iterator tempit = mapAllPayeeInfo.find(strPubKeyCollateralAddress);
         logErrorCnt++;
         logNormalCnt++;
@@ -9568,34 +9824,33 @@ void SortMasternodeByScore(std::map<COutPoint, CMasternode> &mapMasternodes, std
             if(logErrorCnt<=g_nLogMaxCnt)
             {
                 LogPrintf("SPOS_Error:SortMasternodeByScore,payee not found,ip:%s,strPubKeyCollateralAddress:%s\n",
-                      mnpair.second.addr.ToStringIP(),strPubKeyCollateralAddress);
+                      mnpair.second->addr.ToStringIP(),strPubKeyCollateralAddress);
             }else
             {
                 LogPrint("sposinfo","SPOS_Error:extra SortMasternodeByScore,payee not found,ip:%s,strPubKeyCollateralAddress:%s\n",
-                      mnpair.second.addr.ToStringIP(),strPubKeyCollateralAddress);
+                      mnpair.second->addr.ToStringIP(),strPubKeyCollateralAddress);
             }
         }else
         {
             if(logNormalCnt<=g_nLogMaxCnt)
             {
                 LogPrintf("SPOS_Info:%s[%d]:ip:%s,collateralAddress:%s,nScoreTime:%d,nPayeeBlockTime:%d,nPayeeTimes:%d,"
-                          "lastHeight:%d,nState:%d\n",strArrName,logErrorCnt-1,mnpair.second.addr.ToStringIP(),strPubKeyCollateralAddress,
+                          "lastHeight:%d,nState:%d\n",strArrName,logErrorCnt-1,mnpair.second->addr.ToStringIP(),strPubKeyCollateralAddress,
                           nScoreTime,tempit->second.blockTime,tempit->second.nPayeeTimes,tempit->second.nHeight,
-                          mnpair.second.nActiveState);
+                          mnpair.second->nActiveState);
             }else
             {
                 LogPrint("sposinfo","SPOS_Info:extra %s[%d]:ip:%s,collateralAddress:%s,nScoreTime:%d,nPayeeBlockTime:%d,nPayeeTimes:%d,"
-                                    "lastHeight:%d,nState:%d\n",strArrName,logErrorCnt-1,mnpair.second.addr.ToStringIP(),strPubKeyCollateralAddress,
+                                    "lastHeight:%d,nState:%d\n",strArrName,logErrorCnt-1,mnpair.second->addr.ToStringIP(),strPubKeyCollateralAddress,
                                     nScoreTime,tempit->second.blockTime,tempit->second.nPayeeTimes,tempit->second.nHeight,
-                                    mnpair.second.nActiveState);
+                                    mnpair.second->nActiveState);
             }
         }
     }
 
     for (auto& mnpair : scoreMasternodes)
     {
-        CMasternode& mn = mnpair.second;
-        vecResultMasternodes.push_back(mn);
+        vecResultMasternodes.push_back(*mnpair.second);
     }
 
     //random the master node
@@ -9633,6 +9888,7 @@ void UpdateMasternodeGlobalData(const std::vector<CMasternode>& tmpVecMasternode
         g_nSposGeneratedIndex = nSposGeneratedIndex;
     if(nStartNewLoopTime!=g_nSelectGlobalDefaultValue)
         g_nStartNewLoopTimeMS = nStartNewLoopTime;
+    WakeSposMiner();
 }
 
 void UpdateGlobalTimeoutCount(int nTimeoutCount)
@@ -9769,8 +10025,11 @@ void SelectMasterNodeByPayee(int nCurrBlockHeight, uint32_t nTime,uint32_t nScor
 
     if (nSporkSelectLoop==SPORK_SELECT_LOOP_1||nSporkSelectLoop==SPORK_SELECT_LOOP_OVER_TIMEOUT_LIMIT)
     {
+        std::map<COutPoint, const CMasternode*> mapOfficialMasternodes;
+        for (auto& mnpair : mapMeetedMasternodes)
+            mapOfficialMasternodes[mnpair.first] = &mnpair.second;
         std::vector<CMasternode> vecResultAllOfficialMasternodes;
-        SortMasternodeByScore(mapMeetedMasternodes, vecResultAllOfficialMasternodes, nScoreTime, "Official", mapAllPayeeInfo);
+        SortMasternodeByScore(mapOfficialMasternodes, vecResultAllOfficialMasternodes, nScoreTime, "Official", mapAllPayeeInfo);
         
         uint32_t nAllOfficialMasternodecount = vecResultAllOfficialMasternodes.size();
         for (uint32_t i = 0; i < nAllOfficialMasternodecount; ++i)
@@ -9815,7 +10074,7 @@ void SelectMasterNodeByPayee(int nCurrBlockHeight, uint32_t nTime,uint32_t nScor
     unsigned int nMeetedMasternodeSize = mapMeetedMasternodes.size();
     unsigned int intervalHeight = nMeetedMasternodeSize / 2;
 
-    std::map<COutPoint, CMasternode> mapMasternodesL1,mapMasternodesL2,mapMasternodesL3;
+    std::map<COutPoint, const CMasternode*> mapMasternodesL1,mapMasternodesL2,mapMasternodesL3;
 
     std::map<COutPoint, CMasternode>::iterator it = mapMeetedMasternodes.begin();
     for (; it != mapMeetedMasternodes.end(); it++)
@@ -9831,11 +10090,11 @@ void SelectMasterNodeByPayee(int nCurrBlockHeight, uint32_t nTime,uint32_t nScor
         {
             uint32_t nIntervalHeight = nCurrBlockHeight - tempit->second.nHeight;
             if (nIntervalHeight <= intervalHeight)
-                mapMasternodesL1[it->first] = it->second;
+                mapMasternodesL1[it->first] = &it->second;
             else if (nIntervalHeight > intervalHeight && nIntervalHeight <=  2 *intervalHeight)
-                mapMasternodesL2[it->first] = it->second;
+                mapMasternodesL2[it->first] = &it->second;
             else
-                mapMasternodesL3[it->first] = it->second;
+                mapMasternodesL3[it->first] = &it->second;
         }
     }
 
@@ -26,6 +26,7 @@
 
 #include <algorithm>
 #include <exception>
+#include <limits>
 #include <map>
 #include <set>
 #include <stdint.h>
@@ -35,6 +36,7 @@
 
 #include <atomic>
 
+#include <boost/function.hpp>
 #include <boost/unordered_map.hpp>
 #include <boost/filesystem/path.hpp>
 
@@ -470,6 +472,50 @@ struct CIterator_IdAddressKey
     }
 };
 
+struct CIterator_AddressKey
+{
+    std::string strAddress;
+
+    CIterator_AddressKey(const std::string& strAddress = "") : strAddress(strAddress) {
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
+    {
+        READWRITE(LIMITED_STRING(strAddress, MAX_ADDRESS_SIZE));
+    }
+};
+
+/** CAppTx_IndexKey ordered by address first, for the app list of an address */
+struct CAddressAppTx_IndexKey
+{
+    std::string strAddress;
+    uint256 appId;
+    uint8_t nTxClass;
+    COutPoint out;
+
+    CAddressAppTx_IndexKey(const std::string& strAddress = "", const uint256& appId = uint256(), const uint8_t& nTxClass = 0, const COutPoint& out = COutPoint())
+        : strAddress(strAddress), appId(appId), nTxClass(nTxClass), out(out) {
+    }
+
+    CAddressAppTx_IndexKey(const CAppTx_IndexKey& key)
+        : strAddress(key.strAddress), appId(key.appId), nTxClass(key.nTxClass), out(key.out) {
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
+    {
+        READWRITE(LIMITED_STRING(strAddress, MAX_ADDRESS_SIZE));
+        READWRITE(appId);
+        READWRITE(nTxClass);
+        READWRITE(out);
+    }
+};
+
 struct CAssetId_AssetInfo_IndexValue
 {
     std::string strAdminAddress;
@@ -519,6 +565,34 @@ struct CAssetTx_IndexKey
     }
 };
 
+/** CAssetTx_IndexKey ordered by address first, for the asset list of an address */
+struct CAddressAssetTx_IndexKey
+{
+    std::string strAddress;
+    uint256 assetId;
+    uint8_t nTxClass;
+    COutPoint out;
+
+    CAddressAssetTx_IndexKey(const std::string& strAddress = "", const uint256& assetId = uint256(), const uint8_t& nTxClass = 0, const COutPoint& out = COutPoint())
+        : strAddress(strAddress), assetId(assetId), nTxClass(nTxClass), out(out) {
+    }
+
+    CAddressAssetTx_IndexKey(const CAssetTx_IndexKey& key)
+        : strAddress(key.strAddress), assetId(key.assetId), nTxClass(key.nTxClass), out(key.out) {
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
+    {
+        READWRITE(LIMITED_STRING(strAddress, MAX_ADDRESS_SIZE));
+        READWRITE(assetId);
+        READWRITE(nTxClass);
+        READWRITE(out);
+    }
+};
+
 struct CCandyInfo
 {
     CAmount nAmount;
@@ -638,6 +712,91 @@ struct CIterator_IdOutKey
     }
 };
 
+/** Key of the per address asset balance index */
+struct CAddressAssetBalance_IndexKey
+{
+    std::string strAddress;
+    uint256 assetId;
+
+    CAddressAssetBalance_IndexKey(const std::string& strAddress = "", const uint256& assetId = uint256())
+        : strAddress(strAddress), assetId(assetId) {
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
+    {
+        READWRITE(LIMITED_STRING(strAddress, MAX_ADDRESS_SIZE));
+        READWRITE(assetId);
+    }
+
+    friend bool operator<(const CAddressAssetBalance_IndexKey& a, const CAddressAssetBalance_IndexKey& b)
+    {
+        if(a.strAddress == b.strAddress)
+            return a.assetId < b.assetId;
+        return a.strAddress < b.strAddress;
+    }
+};
+
+/** Asset amounts an address received and sent over the active chain */
+struct CAddressAssetBalance_IndexValue
+{
+    CAssetAmount nReceived;
+    CAssetAmount nSent;
+
+    CAddressAssetBalance_IndexValue() {
+    }
+
+    bool IsNull() const { return nReceived == CAssetAmount() && nSent == CAssetAmount(); }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
+    {
+        READWRITE(nReceived);
+        READWRITE(nSent);
+    }
+};
+
+/** Asset amount an address received in outputs locked until nUnlockedHeight, the height is big endian so records sort by it */
+struct CAddressAssetLocked_IndexKey
+{
+    std::string strAddress;
+    uint256 assetId;
+    int nUnlockedHeight;
+
+    CAddressAssetLocked_IndexKey(const std::string& strAddress = "", const uint256& assetId = uint256(), const int& nUnlockedHeight = 0)
+        : strAddress(strAddress), assetId(assetId), nUnlockedHeight(nUnlockedHeight) {
+    }
+
+    size_t GetSerializeSize(int nType, int nVersion) const {
+        return ::GetSerializeSize(strAddress, nType, nVersion) + 32 + 4;
+    }
+    template<typename Stream>
+    void Serialize(Stream& s, int nType, int nVersion) const {
+        ::Serialize(s, strAddress, nType, nVersion);
+        assetId.Serialize(s, nType, nVersion);
+        ser_writedata32be(s, nUnlockedHeight);
+    }
+    template<typename Stream>
+    void Unserialize(Stream& s, int nType, int nVersion) {
+        ::Unserialize(s, LIMITED_STRING(strAddress, MAX_ADDRESS_SIZE), nType, nVersion);
+        assetId.Unserialize(s, nType, nVersion);
+        nUnlockedHeight = ser_readdata32be(s);
+    }
+
+    friend bool operator<(const CAddressAssetLocked_IndexKey& a, const CAddressAssetLocked_IndexKey& b)
+    {
+        if(a.strAddress != b.strAddress)
+            return a.strAddress < b.strAddress;
+        if(a.assetId != b.assetId)
+            return a.assetId < b.assetId;
+        return a.nUnlockedHeight < b.nUnlockedHeight;
+    }
+};
+
 struct CGetCandyCount_IndexKey
 {
     uint256 assetId;
@@ -735,6 +894,32 @@ struct CGetCandy_IndexValue
     }
 };
 
+/** CGetCandy_IndexKey ordered by address before outpoint, for the candy got by an address */
+struct CAddressGetCandy_IndexKey
+{
+    uint256 assetId;
+    std::string strAddress;
+    COutPoint out;
+
+    CAddressGetCandy_IndexKey(const uint256& assetId = uint256(), const std::string& strAddress = "", const COutPoint& out = COutPoint())
+        : assetId(assetId), strAddress(strAddress), out(out) {
+    }
+
+    CAddressGetCandy_IndexKey(const CGetCandy_IndexKey& key)
+        : assetId(key.assetId), strAddress(key.strAddress), out(key.out) {
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
+    {
+        READWRITE(assetId);
+        READWRITE(LIMITED_STRING(strAddress, MAX_ADDRESS_SIZE));
+        READWRITE(out);
+    }
+};
+
 struct CIterator_MasternodePayeeKey
 {
     std::string strPubKeyCollateralAddress;
@@ -796,6 +981,9 @@ struct CCandy_BlockTime_Info
     int64_t blocktime;
     int nHeight;
 
+    CCandy_BlockTime_Info() : blocktime(0), nHeight(0) {
+    }
+
     CCandy_BlockTime_Info(const uint256& assetIdIn, const CAssetData& assetDataIn, const CCandyInfo& candyinfoIn, const COutPoint& outpointIn, const int64_t& blocktimeIn,int height)
     {
         assetId = assetIdIn;
@@ -819,6 +1007,35 @@ struct CCandy_BlockTime_Info
         nHeight = info.nHeight;
         return *this;
     }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
+    {
+        READWRITE(assetId);
+        READWRITE(assetData);
+        READWRITE(candyinfo);
+        READWRITE(outpoint);
+        READWRITE(blocktime);
+        READWRITE(nHeight);
+    }
+};
+
+/** Candy of a put-candy output with the amount each wallet address can still claim, kept in the wallet */
+struct CCandyEligibility
+{
+    CCandy_BlockTime_Info info;
+    std::map<std::string, CAmount> mapAddressAmount;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
+    {
+        READWRITE(info);
+        READWRITE(mapAddressAmount);
+    }
 };
 
 struct CCandy_BlockTime_InfoVec
@@ -1292,6 +1509,15 @@ enum SPORK_SELECT_LOOP
   SPORK_SELECT_LOOP_OVER_TIMEOUT_LIMIT = 3
 };
 
+/** Check that a transaction spending asset txouts also pays asset txouts */
+bool CheckAssetTxInputAndOutput(const CTransaction& tx, CValidationState &state, const CCoinsViewCache& view);
+
+/** Check the app and asset txouts of a transaction, candy claimed by earlier transactions of the block are passed in mapAssetGetCandy */
+bool CheckAppTransaction(const CTransaction& tx, CValidationState &state, const CCoinsViewCache& view, std::map<CPutCandy_IndexKey, CAmount>& mapAssetGetCandy, const bool &fWithMempool);
+
+/** Get the address string paid by txout, false for non standard scripts */
+bool GetTxOutAddress(const CTxOut& txout, std::string* pAddress = NULL);
+
 bool CheckUnlockedHeight(const int32_t& nTxVersion, const int64_t& nOffset);
 
 /** Context-independent validity checks */
@@ -1412,6 +1638,8 @@ bool TestBlockValidity(CValidationState& state, const CChainParams& chainparams,
 
 /**Get a map of the amount corresponding to the address according to the height*/
 bool GetAddressAmountByHeight(const int& nHeight, const std::string& strAddress, CAmount& nAmount);
+/**Get the amounts of a sorted address list according to the height in one pass, a negative amount has no valid balance*/
+bool GetAddressAmountsByHeight(const int& nHeight, const std::vector<std::string>& vAddress, std::vector<CAmount>& vAmount);
 bool GetTotalAmountByHeight(const int& nHeight, CAmount& nTotalAmount);
 
 class CBlockFileInfo
@@ -1526,10 +1754,73 @@ static const unsigned int REJECT_ALREADY_KNOWN = 0x101;
 /** Transaction conflicts with a transaction already known */
 static const unsigned int REJECT_CONFLICT = 0x102;
 
+/** Height given to mempool transactions in a CTxIdPage, they follow all confirmed ones */
+static const int TXID_PAGE_MEMPOOL_HEIGHT = std::numeric_limits<int>::max();
+
+/** Position of a transaction in the height ordered txid lists of the app and asset rpcs */
+struct CTxIdCursor
+{
+    int nHeight;
+    uint256 txid;
+
+    CTxIdCursor(const int& nHeight = -1, const uint256& txid = uint256()) : nHeight(nHeight), txid(txid) {
+    }
+
+    bool IsNull() const { return nHeight < 0; }
+
+    /** Opaque continuation string handed to rpc clients */
+    std::string ToString() const;
+    static bool Parse(const std::string& str, CTxIdCursor& cursor);
+
+    friend bool operator<(const CTxIdCursor& a, const CTxIdCursor& b)
+    {
+        if(a.nHeight == b.nHeight)
+            return a.txid < b.txid;
+        return a.nHeight < b.nHeight;
+    }
+};
+
+/**
+ * One page of a txid list: the first nCount distinct transactions following the
+ * cursor in (height, txid) order. Only nCount + 1 entries are kept while the
+ * index is scanned, nCount 0 means no limit. The GetTxIdsBy* functions fill it
+ * without cs_main, block indexes are written in one batch.
+ */
+class CTxIdPage
+{
+private:
+    CTxIdCursor after;
+    unsigned int nCount;
+    std::set<CTxIdCursor> setTxId;
+    /** Transactions fnFilter rejected */
+    std::set<uint256> setFiltered;
+    bool fEmpty;
+
+public:
+    /** Optional filter, transactions it rejects are not listed */
+    boost::function<bool (const uint256&)> fnFilter;
+
+    CTxIdPage(const CTxIdCursor& after = CTxIdCursor(), const unsigned int& nCount = 0) : after(after), nCount(nCount), fEmpty(true) {
+    }
+
+    /** True when the page starts at the beginning of the list */
+    bool IsFirst() const { return after.IsNull(); }
+
+    /** True when nothing was added, whether or not the cursor or fnFilter dropped it */
+    bool IsEmpty() const { return fEmpty; }
+
+    void Add(const int& nHeight, const uint256& txid);
+
+    /** Ordered transactions of the page, cursorNext is set to the last one when more follow */
+    void Get(std::vector<uint256>& vTxId, CTxIdCursor& cursorNext) const;
+};
+
 bool GetAppInfoByAppId(const uint256& appId, CAppId_AppInfo_IndexValue& appInfo, const bool fWithMempool = true);
 bool GetAppIdByAppName(const std::string& strAppName, uint256& appId, const bool fWithMempool = true);
 bool GetTxInfoByAppId(const uint256& appId, std::vector<COutPoint>& vOut, const bool fWithMempool = true);
 bool GetTxInfoByAppIdAddress(const uint256& appId, const std::string& strAddress, std::vector<COutPoint>& vOut, const bool fWithMempool = true);
+/** Page of the app txids, strAddress empty means any address */
+bool GetTxIdsByAppId(const uint256& appId, const std::string& strAddress, CTxIdPage& page, const bool fWithMempool = true);
 bool GetAppListInfo(std::vector<uint256> &vappid, const bool fWithMempool = true);
 bool GetAppIDListByAddress(const std::string &strAddress, std::vector<uint256> &appIdlist, const bool fWithMempool = true);
 bool GetExtendDataByTxId(const uint256& txId, std::vector<std::pair<uint256, std::string> > &vExtendData);
@@ -1540,6 +1831,10 @@ bool GetAssetIdByShortName(const std::string& strShortName, uint256& assetId, co
 bool GetAssetIdByAssetName(const std::string& strAssetName, uint256& assetId, const bool fWithMempool = true);
 bool GetTxInfoByAssetIdTxClass(const uint256& assetId, const uint8_t& nTxClass, std::vector<COutPoint>& vOut, const bool fWithMempool = true);
 bool GetTxInfoByAssetIdAddressTxClass(const uint256& assetId, const std::string& strAddress, const uint8_t& nTxClass, std::vector<COutPoint>& vOut, const bool fWithMempool = true);
+/** Page of the asset txids of a transaction class, strAddress empty means any address */
+bool GetTxIdsByAssetIdTxClass(const uint256& assetId, const std::string& strAddress, const uint8_t& nTxClass, CTxIdPage& page, const bool fWithMempool = true);
+/** Confirmed asset amounts strAddress received, sent and still has locked, false when the balance index is not available */
+bool GetAddressAssetBalance(const std::string& strAddress, const uint256& assetId, CAssetAmount& nReceived, CAssetAmount& nSent, CAssetAmount& nLocked);
 bool GetAssetIdByAddress(const std::string & strAddress, std::vector<uint256> &assetIdlist, const bool fWithMempool = true);
 bool GetAssetIdCandyInfo(const uint256& assetId, std::map<COutPoint, CCandyInfo>& mapCandyInfo);
 bool GetAssetIdCandyInfo(const uint256& assetId, const COutPoint& out, CCandyInfo& candyInfo);
@@ -1550,6 +1845,19 @@ bool GetIssueAssetInfo(std::map<uint256, CAssetData> &mapissueassetinfo);
 CAmount GetAddedAmountByAssetId(const uint256& assetId, const bool fWithMempool = true);
 
 void ThreadGetAllCandyInfo();
+/** Restore the candy eligibility table from the wallet, nHeight is the last candy height it covers */
+void LoadCandyEligibility(const CCandyEligibility& eligibility);
+void LoadCandyEligibilityMarker(const int& nHeight, const uint256& hashKeys);
+/** Hash of the wallet keys the eligibility is computed for, the unused keys of the key pool are left out */
+uint256 GetCandyEligibilityKeysHash(const std::map<CKeyID, int64_t>& mapKeyBirth, const std::set<CKeyID>& setReserveKeys);
+/**
+ * Claimable candies of the eligibility table, newest first, without the
+ * addresses that claimed since it was stored. Fails if the table does not
+ * cover nLastCandyHeight for the keys hashed as hashKeys.
+ */
+bool GetCandyEligibility(std::vector<CCandy_BlockTime_Info>& vInfo, const int& nLastCandyHeight, const uint256& hashKeys);
+/** Drop a claimed candy from the eligibility table */
+void EraseCandyEligibility(const COutPoint& out);
 void ThreadWriteChangeInfo();
 void ThreadCalculateAddressAmount();
 bool VerifyDetailFile();
@@ -1561,14 +1869,8 @@ bool GetCOutPointList(const uint256& assetId, const std::string& strAddress, std
 
 bool GetAssetIdCandyInfoList(std::map<CPutCandy_IndexKey, CPutCandy_IndexValue>& mapCandy);
 
-std::string getNumString(int* num);
-void resetNumA(std::string numAStr);
-void resetNumB(std::string numBStr);
 int compareFloatString(const std::string& numAStr,const std::string& numBStr,bool fOnlyCompareInt=true);
 int comparestring(std::string numAStr,std::string numBStr);
-std::string plusstring(std::string numAStr, std::string numBStr);
-std::string minusstring(std::string numAStr, std::string numBStr);
-std::string mulstring(std::string numAStr, std::string numBStr);
 std::string numtofloatstring(std::string numstr, int32_t Decimals);
 
 bool ExistForbidTxin(const int nHeight, const std::vector<int>& prevheights);
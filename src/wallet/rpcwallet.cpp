@@ -2563,6 +2563,54 @@ UniValue getlockedtxinfo(const UniValue & params, bool fHelp)
     return result;
 }
 
+UniValue getrescaninfo(const UniValue& params, bool fHelp)
+{
+    if (!EnsureWalletIsAvailable(fHelp))
+        return NullUniValue;
+
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+            "getrescaninfo\n"
+            "Returns the progress of the running, or else the last, wallet rescan.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"running\": true|false,     (boolean) whether a rescan is in progress\n"
+            "  \"threads\": n,              (numeric) the number of block reading threads\n"
+            "  \"startheight\": n,          (numeric) the first scanned block height\n"
+            "  \"stopheight\": n,           (numeric) the chain height when the rescan started\n"
+            "  \"height\": n,               (numeric) the last scanned block height\n"
+            "  \"progress\": x.xxx,         (numeric) the scanned fraction of the blocks\n"
+            "  \"blocks\": n,               (numeric) the number of scanned blocks\n"
+            "  \"transactions\": n,         (numeric) the number of scanned transactions\n"
+            "  \"found\": n,                (numeric) the number of wallet transactions found\n"
+            "  \"elapsed\": n,              (numeric) the duration of the rescan in milliseconds\n"
+            "  \"blockspersecond\": x.xx,   (numeric) the rescan throughput\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getrescaninfo", "")
+            + HelpExampleRpc("getrescaninfo", "")
+        );
+
+    // no cs_main or cs_wallet, the rescan holds both
+    CRescanProgress progress = pwalletMain->GetRescanProgress();
+    int64_t nElapsed = (progress.fRunning ? GetTimeMillis() : progress.nEndTime) - progress.nStartTime;
+    int nTotal = progress.nStopHeight - progress.nStartHeight + 1;
+
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("running", progress.fRunning));
+    obj.push_back(Pair("threads", progress.nThreads));
+    obj.push_back(Pair("startheight", progress.nStartHeight));
+    obj.push_back(Pair("stopheight", progress.nStopHeight));
+    obj.push_back(Pair("height", progress.nHeight));
+    obj.push_back(Pair("progress", nTotal > 0 ? std::min(1.0, (double)progress.nBlocks / nTotal) : 0.0));
+    obj.push_back(Pair("blocks", progress.nBlocks));
+    obj.push_back(Pair("transactions", progress.nTransactions));
+    obj.push_back(Pair("found", progress.nFound));
+    obj.push_back(Pair("elapsed", progress.nStartTime > 0 ? nElapsed : 0));
+    obj.push_back(Pair("blockspersecond", nElapsed > 0 ? progress.nBlocks * 1000.0 / nElapsed : 0.0));
+    return obj;
+}
+
 UniValue getwalletinfo(const UniValue& params, bool fHelp)
 {
     if (!EnsureWalletIsAvailable(fHelp))
@@ -0,0 +1,107 @@
+// Copyright (c) 2018-2019 The Safe Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "txdb.h"
+#include "validation.h"
+#include "wallet/wallet.h"
+
+#include "test/test_safe.h"
+
+#include <boost/test/unit_test.hpp>
+
+extern CWallet* pwalletMain;
+
+BOOST_FIXTURE_TEST_SUITE(candyeligibility_tests, TestingSetup)
+
+static CCandyEligibility CreateEligibility(const COutPoint& out, const std::map<std::string, CAmount>& mapAddressAmount)
+{
+    CCandyEligibility eligibility;
+    eligibility.info = CCandy_BlockTime_Info(uint256S("0x01"), CAssetData(), CCandyInfo(1000 * COIN, 1), out, 0, 0);
+    eligibility.mapAddressAmount = mapAddressAmount;
+    return eligibility;
+}
+
+static uint256 GetWalletKeysHash(std::map<CKeyID, int64_t>& mapKeyBirth)
+{
+    mapKeyBirth.clear();
+    {
+        LOCK(pwalletMain->cs_wallet);
+        pwalletMain->GetKeyBirthTimes(mapKeyBirth);
+    }
+
+    std::set<CKeyID> setReserveKeys;
+    pwalletMain->GetAllReserveKeys(setReserveKeys);
+    return GetCandyEligibilityKeysHash(mapKeyBirth, setReserveKeys);
+}
+
+BOOST_AUTO_TEST_CASE(candyeligibility_keys_hash)
+{
+    std::map<CKeyID, int64_t> mapKeyBirth;
+    BOOST_CHECK(pwalletMain->TopUpKeyPool(5));
+    uint256 hashKeys = GetWalletKeysHash(mapKeyBirth);
+    size_t nKeys = mapKeyBirth.size();
+
+    // a key pool top-up only adds unused keys
+    BOOST_CHECK(pwalletMain->TopUpKeyPool(10));
+    BOOST_CHECK(GetWalletKeysHash(mapKeyBirth) == hashKeys);
+    BOOST_CHECK(mapKeyBirth.size() > nKeys);
+
+    // a key taken from the pool may receive coins
+    CReserveKey reservekey(pwalletMain);
+    CPubKey pubkey;
+    BOOST_CHECK(reservekey.GetReservedKey(pubkey, false));
+    reservekey.KeepKey();
+    BOOST_CHECK(GetWalletKeysHash(mapKeyBirth) != hashKeys);
+}
+
+BOOST_AUTO_TEST_CASE(candyeligibility_marker)
+{
+    uint256 hashKeys = uint256S("0x1234");
+    COutPoint out(uint256S("0xaa"), 0);
+    LoadCandyEligibility(CreateEligibility(out, {{"address1", 10 * COIN}}));
+    LoadCandyEligibilityMarker(100, hashKeys);
+
+    std::vector<CCandy_BlockTime_Info> vInfo;
+    BOOST_CHECK(GetCandyEligibility(vInfo, 100, hashKeys));
+    BOOST_CHECK(vInfo.size() == 1 && vInfo[0].outpoint == out);
+    BOOST_CHECK(GetCandyEligibility(vInfo, 90, hashKeys));
+
+    // a newer candy height or other wallet keys need a full scan
+    BOOST_CHECK(!GetCandyEligibility(vInfo, 101, hashKeys));
+    BOOST_CHECK(!GetCandyEligibility(vInfo, 100, uint256S("0x5678")));
+
+    EraseCandyEligibility(out);
+    BOOST_CHECK(GetCandyEligibility(vInfo, 100, hashKeys));
+    BOOST_CHECK(vInfo.empty());
+}
+
+BOOST_AUTO_TEST_CASE(candyeligibility_recheck_claims)
+{
+    uint256 hashKeys = uint256S("0x1234");
+    COutPoint outPartly(uint256S("0xbb"), 0);
+    COutPoint outClaimed(uint256S("0xcc"), 0);
+    CCandyEligibility eligibility = CreateEligibility(outPartly, {{"address1", COIN}, {"address2", COIN}});
+    LoadCandyEligibility(eligibility);
+    LoadCandyEligibility(CreateEligibility(outClaimed, {{"address1", COIN}}));
+    LoadCandyEligibilityMarker(100, hashKeys);
+
+    // address1 claimed both candies after the table was stored
+    std::vector<std::pair<CGetCandy_IndexKey, CGetCandy_IndexValue> > vGetCandy;
+    vGetCandy.push_back(std::make_pair(CGetCandy_IndexKey(eligibility.info.assetId, outPartly, "address1"), CGetCandy_IndexValue(COIN, 101)));
+    vGetCandy.push_back(std::make_pair(CGetCandy_IndexKey(eligibility.info.assetId, outClaimed, "address1"), CGetCandy_IndexValue(COIN, 101)));
+    CDBBatch batch(&pblocktree->GetObfuscateKey());
+    pblocktree->Write_GetCandy_Index(batch, vGetCandy);
+    BOOST_CHECK(pblocktree->WriteBatch(batch));
+
+    std::vector<CCandy_BlockTime_Info> vInfo;
+    BOOST_CHECK(GetCandyEligibility(vInfo, 100, hashKeys));
+    BOOST_CHECK(vInfo.size() == 1 && vInfo[0].outpoint == outPartly);
+
+    // the claimed candy was dropped from the table, not only from the list
+    EraseCandyEligibility(outPartly);
+    BOOST_CHECK(GetCandyEligibility(vInfo, 100, hashKeys));
+    BOOST_CHECK(vInfo.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
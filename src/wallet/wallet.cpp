@@ -892,6 +892,24 @@ int64_t CWallet::IncOrderPosNext(CWalletDB *pwalletdb)
     return nRet;
 }
 
+void CWalletTx::MarkDirty()
+{
+    fCreditCached = false;
+    fAvailableCreditCached = false;
+    fImmatureCreditCached = false;
+    fAnonymizedCreditCached = false;
+    fDenomUnconfCreditCached = false;
+    fDenomConfCreditCached = false;
+    fWatchDebitCached = false;
+    fWatchCreditCached = false;
+    fAvailableWatchCreditCached = false;
+    fImmatureWatchCreditCached = false;
+    fDebitCached = false;
+    fChangeCached = false;
+    if (pwallet)
+        pwallet->MarkTxDirty(GetHash());
+}
+
 void CWallet::MarkDirty()
 {
     {
@@ -905,6 +923,7 @@ void CWallet::MarkDirty()
 
     fAnonymizableTallyCached = false;
     fAnonymizableTallyCachedNonDenom = false;
+    fAssetBalancesCached = false;
 }
 
 bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFromLoadWallet, CWalletDB* pwalletdb)
@@ -917,6 +936,8 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFromLoadWallet, CWalletD
 		if (mi != mapBlockIndex.end() && (*mi).second)
 		{
 			nTxHeight = (*mi).second->nHeight;
+			if (chainActive.Contains((*mi).second))
+				CacheTxHeight(hash, nTxHeight, wtxIn.nVersion, wtxIn.hashBlock);
 		}
 		else
 		{
@@ -1311,43 +1332,11 @@ CAmount CWallet::GetDebit(const CTxIn &txin, const isminefilter& filter, const b
 
                 if(fAsset)
                 {
-                    CAppHeader header;
-                    std::vector<unsigned char> vData;
-                    if(!ParseReserve(txout.vReserve, header, vData))
+                    CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+                    if(!payload)
+                        return 0;
+                    if(payload->IsAssetCmd() && (!payload->fBody || payload->assetId != *pAssetId))
                         return 0;
-
-                    if(header.nAppCmd == ISSUE_ASSET_CMD)
-                    {
-                        CAssetData assetData;
-                        if(!ParseIssueData(vData, assetData))
-                            return 0;
-                        if(assetData.GetHash() != *pAssetId)
-                            return 0;
-                    }
-                    else if(header.nAppCmd == ADD_ASSET_CMD || header.nAppCmd == TRANSFER_ASSET_CMD || header.nAppCmd == DESTORY_ASSET_CMD || header.nAppCmd == CHANGE_ASSET_CMD)
-                    {
-                        CCommonData commonData;
-                        if(!ParseCommonData(vData, commonData))
-                            return 0;
-                        if(commonData.assetId != *pAssetId)
-                            return 0;
-                    }
-                    else if(header.nAppCmd == PUT_CANDY_CMD)
-                    {
-                        CPutCandyData candyData;
-                        if(!ParsePutCandyData(vData, candyData))
-                            return 0;
-                        if(candyData.assetId != *pAssetId)
-                            return 0;
-                    }
-                    else if(header.nAppCmd == GET_CANDY_CMD)
-                    {
-                        CGetCandyData candyData;
-                        if(!ParseGetCandyData(vData, candyData))
-                            return 0;
-                        if(candyData.assetId != *pAssetId)
-                            return 0;
-                    }
                 }
 
                 if (IsMine(txout) & filter)
@@ -1688,43 +1677,11 @@ CAmount CWallet::GetCredit(const CTransaction& tx, const isminefilter& filter, c
 
         if(fAsset)
         {
-            CAppHeader header;
-            std::vector<unsigned char> vData;
-            if(!ParseReserve(txout.vReserve, header, vData))
+            CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+            if(!payload)
+                continue;
+            if(payload->IsAssetCmd() && (!payload->fBody || payload->assetId != *pAssetId))
                 continue;
-
-            if(header.nAppCmd == ISSUE_ASSET_CMD)
-            {
-                CAssetData assetData;
-                if(!ParseIssueData(vData, assetData))
-                    continue;
-                if(assetData.GetHash() != *pAssetId)
-                    continue;
-            }
-            else if(header.nAppCmd == ADD_ASSET_CMD || header.nAppCmd == TRANSFER_ASSET_CMD || header.nAppCmd == DESTORY_ASSET_CMD || header.nAppCmd == CHANGE_ASSET_CMD)
-            {
-                CCommonData commonData;
-                if(!ParseCommonData(vData, commonData))
-                    continue;
-                if(commonData.assetId != *pAssetId)
-                    continue;
-            }
-            else if(header.nAppCmd == PUT_CANDY_CMD)
-            {
-                CPutCandyData candyData;
-                if(!ParsePutCandyData(vData, candyData))
-                    continue;
-                if(candyData.assetId != *pAssetId)
-                    continue;
-            }
-            else if(header.nAppCmd == GET_CANDY_CMD)
-            {
-                CGetCandyData candyData;
-                if(!ParseGetCandyData(vData, candyData))
-                    continue;
-                if(candyData.assetId != *pAssetId)
-                    continue;
-            }
         }
 
         nCredit += GetCredit(txout, filter, fAsset);
@@ -1912,10 +1869,71 @@ bool CWalletTx::WriteToDisk(CWalletDB *pwalletdb)
     return pwalletdb->WriteTx(GetHash(), *this);
 }
 
+/** Whether a transaction pays the wallet, as far as a rescan thread can tell without cs_wallet */
+enum RescanMatch
+{
+    RESCAN_NOT_MINE = 0,
+    RESCAN_MAYBE_MINE,
+    RESCAN_MINE
+};
+
+/** Block read ahead by a rescan thread, with a match per transaction */
+struct CRescanBlock
+{
+    CBlockIndex* pindex;
+    CBlock block;
+    std::vector<RescanMatch> vMatch;
+};
+
+/** Keys of the wallet copied before a rescan, so that threads can match outputs without cs_wallet */
+struct CRescanKeys
+{
+    std::set<CKeyID> setKeys;
+    bool fHaveWatchOnly;
+};
+
+static RescanMatch MatchRescanTx(const CRescanKeys& keys, const CTransaction& tx)
+{
+    RescanMatch match = RESCAN_NOT_MINE;
+    BOOST_FOREACH(const CTxOut& txout, tx.vout)
+    {
+        std::vector<std::vector<unsigned char> > vSolutions;
+        txnouttype whichType;
+        if (!Solver(txout.scriptPubKey, whichType, vSolutions))
+            whichType = TX_NONSTANDARD;
+
+        if (whichType == TX_PUBKEY && keys.setKeys.count(CPubKey(vSolutions[0]).GetID()))
+            return RESCAN_MINE;
+        if (whichType == TX_PUBKEYHASH && keys.setKeys.count(CKeyID(uint160(vSolutions[0]))))
+            return RESCAN_MINE;
+
+        // redeem scripts and watch-only scripts are left to IsMine on the wallet thread
+        if (whichType == TX_SCRIPTHASH || whichType == TX_MULTISIG || keys.fHaveWatchOnly)
+            match = RESCAN_MAYBE_MINE;
+    }
+    return match;
+}
+
+static void ReadRescanBlocks(const CRescanKeys* pkeys, std::vector<CRescanBlock>* pvBlocks, size_t nFirst, size_t nStep)
+{
+    RenameThread("safe-rescan");
+    for (size_t i = nFirst; i < pvBlocks->size(); i += nStep)
+    {
+        CRescanBlock& item = (*pvBlocks)[i];
+        if (!ReadBlockFromDisk(item.block, item.pindex, Params().GetConsensus()))
+            LogPrintf("ScanForWalletTransactions: failed to read block %d\n", item.pindex->nHeight);
+        item.vMatch.resize(item.block.vtx.size());
+        for (size_t j = 0; j < item.block.vtx.size(); j++)
+            item.vMatch[j] = MatchRescanTx(*pkeys, item.block.vtx[j]);
+    }
+}
+
 /**
  * Scan the block chain (starting in pindexStart) for transactions
  * from or to us. If fUpdate is true, found transactions that already
- * exist in the wallet will be updated.
+ * exist in the wallet will be updated. Blocks are read and matched against
+ * the wallet keys by -rescanthreads threads one batch ahead, while the
+ * transactions of the previous batch are added to the wallet in chain order.
  */
 int CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate)
 {
@@ -1923,6 +1941,12 @@ int CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate)
     int64_t nNow = GetTime();
     const CChainParams& chainParams = Params();
 
+    int nThreads = GetArg("-rescanthreads", DEFAULT_RESCAN_THREADS);
+    if (nThreads <= 0)
+        nThreads = GetNumCores();
+    nThreads = std::max(1, std::min(nThreads, MAX_RESCAN_THREADS));
+    size_t nBatchSize = nThreads * RESCAN_BLOCKS_PER_THREAD;
+
     CBlockIndex* pindex = pindexStart;
     {
         LOCK2(cs_main, cs_wallet);
@@ -1932,32 +1956,97 @@ int CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate)
         while (pindex && nTimeFirstKey && (pindex->GetBlockTime() < (nTimeFirstKey - 7200)))
             pindex = chainActive.Next(pindex);
 
+        CRescanKeys keys;
+        GetKeys(keys.setKeys);
+        for (std::map<CKeyID, CHDPubKey>::const_iterator it = mapHdPubKeys.begin(); it != mapHdPubKeys.end(); ++it)
+            keys.setKeys.insert(it->first);
+        keys.fHaveWatchOnly = HaveWatchOnly();
+
+        {
+            LOCK(cs_rescanProgress);
+            rescanProgress = CRescanProgress();
+            rescanProgress.fRunning = true;
+            rescanProgress.nThreads = nThreads;
+            rescanProgress.nStartHeight = pindex ? pindex->nHeight : -1;
+            rescanProgress.nStopHeight = chainActive.Height();
+            rescanProgress.nStartTime = GetTimeMillis();
+        }
+
         ShowProgress(_("Rescanning..."), 0); // show rescan progress in GUI as dialog or on splashscreen, if -rescan on startup
         double dProgressStart = Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), pindex, false);
         double dProgressTip = Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), chainActive.Tip(), false);
-        while (pindex)
-        {
-            if (pindex->nHeight % 100 == 0 && dProgressTip - dProgressStart > 0.0)
-                ShowProgress(_("Rescanning..."), std::max(1, std::min(99, (int)((Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), pindex, false) - dProgressStart) / (dProgressTip - dProgressStart) * 100))));
 
-            CBlock block;
-            ReadBlockFromDisk(block, pindex, Params().GetConsensus());
-            BOOST_FOREACH(CTransaction& tx, block.vtx)
+        std::vector<CRescanBlock> vCurrent, vNext;
+        while (pindex || !vNext.empty())
+        {
+            boost::thread_group readers;
+            // start reading the next batch, then add the transactions of the previous one
+            vCurrent.swap(vNext);
+            vNext.clear();
+            for (; pindex && vNext.size() < nBatchSize; pindex = chainActive.Next(pindex))
             {
-                if (AddToWalletIfInvolvingMe(tx, &block, fUpdate))
-                    ret++;
+                vNext.push_back(CRescanBlock());
+                vNext.back().pindex = pindex;
             }
-            pindex = chainActive.Next(pindex);
-            if (GetTime() >= nNow + 60) {
-                nNow = GetTime();
-                LogPrintf("Still rescanning. At block %d. Progress=%f\n", pindex->nHeight, Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), pindex));
+            for (int i = 0; i < nThreads && (size_t)i < vNext.size(); i++)
+                readers.create_thread(boost::bind(&ReadRescanBlocks, &keys, &vNext, i, nThreads));
+
+            try {
+                BOOST_FOREACH(const CRescanBlock& item, vCurrent)
+                {
+                    boost::this_thread::interruption_point();
+                    if (item.pindex->nHeight % 100 == 0 && dProgressTip - dProgressStart > 0.0)
+                        ShowProgress(_("Rescanning..."), std::max(1, std::min(99, (int)((Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), item.pindex, false) - dProgressStart) / (dProgressTip - dProgressStart) * 100))));
+
+                    for (size_t j = 0; j < item.block.vtx.size(); j++)
+                    {
+                        const CTransaction& tx = item.block.vtx[j];
+                        bool fRelevant = item.vMatch[j] != RESCAN_NOT_MINE || mapWallet.count(tx.GetHash());
+                        for (size_t k = 0; !fRelevant && k < tx.vin.size(); k++)
+                            fRelevant = mapWallet.count(tx.vin[k].prevout.hash) || mapTxSpends.count(tx.vin[k].prevout);
+                        if (fRelevant && AddToWalletIfInvolvingMe(tx, &item.block, fUpdate))
+                            ret++;
+                    }
+
+                    {
+                        LOCK(cs_rescanProgress);
+                        rescanProgress.nHeight = item.pindex->nHeight;
+                        rescanProgress.nBlocks++;
+                        rescanProgress.nTransactions += item.block.vtx.size();
+                        rescanProgress.nFound = ret;
+                    }
+
+                    if (GetTime() >= nNow + 60) {
+                        nNow = GetTime();
+                        LogPrintf("Still rescanning. At block %d. Progress=%f\n", item.pindex->nHeight, Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), item.pindex));
+                    }
+                }
+            } catch (...) {
+                readers.interrupt_all();
+                readers.join_all();
+                LOCK(cs_rescanProgress);
+                rescanProgress.fRunning = false;
+                rescanProgress.nEndTime = GetTimeMillis();
+                throw;
             }
+            readers.join_all();
         }
         ShowProgress(_("Rescanning..."), 100); // hide progress dialog in GUI
+
+        LOCK(cs_rescanProgress);
+        rescanProgress.fRunning = false;
+        rescanProgress.nEndTime = GetTimeMillis();
+        LogPrintf("Rescan of %d blocks with %d threads found %d transactions in %dms\n", rescanProgress.nBlocks, nThreads, ret, rescanProgress.nEndTime - rescanProgress.nStartTime);
     }
     return ret;
 }
 
+CRescanProgress CWallet::GetRescanProgress() const
+{
+    LOCK(cs_rescanProgress);
+    return rescanProgress;
+}
+
 void CWallet::ReacceptWalletTransactions()
 {
     // If transactions aren't being broadcasted, don't let them into local mempool either
@@ -2159,18 +2248,10 @@ CAmount CWalletTx::GetLockedCredit(const bool fAsset, const uint256* pAssetId, c
 
         if(fAsset)
         {
-            CAppHeader header;
-            std::vector<unsigned char> vData;
-            if(!ParseReserve(txout.vReserve, header, vData))
-                continue;
-
-            if(header.nAppCmd != TRANSFER_ASSET_CMD)
-                continue;
-
-            CCommonData transferData;
-            if(!ParseCommonData(vData, transferData))
+            CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+            if(!payload || payload->header.nAppCmd != TRANSFER_ASSET_CMD)
                 continue;
-            if(transferData.assetId != *pAssetId)
+            if(!payload->fBody || payload->assetId != *pAssetId)
                 continue;
         }
 
@@ -2258,43 +2339,11 @@ CAmount CWalletTx::GetAvailableCredit(const bool fAsset, const uint256* pAssetId
 
         if(fAsset)
         {
-            CAppHeader header;
-            std::vector<unsigned char> vData;
-            if(!ParseReserve(txout.vReserve, header, vData))
+            CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+            if(!payload)
+                continue;
+            if(payload->IsAssetCmd() && (!payload->fBody || payload->assetId != *pAssetId))
                 continue;
-
-            if(header.nAppCmd == ISSUE_ASSET_CMD)
-            {
-                CAssetData assetData;
-                if(!ParseIssueData(vData, assetData))
-                    continue;
-                if(assetData.GetHash() != *pAssetId)
-                    continue;
-            }
-            else if(header.nAppCmd == ADD_ASSET_CMD || header.nAppCmd == TRANSFER_ASSET_CMD || header.nAppCmd == DESTORY_ASSET_CMD || header.nAppCmd == CHANGE_ASSET_CMD)
-            {
-                CCommonData commonData;
-                if(!ParseCommonData(vData, commonData))
-                    continue;
-                if(commonData.assetId != *pAssetId)
-                    continue;
-            }
-            else if(header.nAppCmd == PUT_CANDY_CMD)
-            {
-                CPutCandyData candyData;
-                if(!ParsePutCandyData(vData, candyData))
-                    continue;
-                if(candyData.assetId != *pAssetId)
-                    continue;
-            }
-            else if(header.nAppCmd == GET_CANDY_CMD)
-            {
-                CGetCandyData candyData;
-                if(!ParseGetCandyData(vData, candyData))
-                    continue;
-                if(candyData.assetId != *pAssetId)
-                    continue;
-            }
         }
 
         nCredit += pwallet->GetCredit(txout, ISMINE_SPENDABLE,fAsset);
@@ -2364,18 +2413,10 @@ CAmount CWalletTx::GetLockedWatchOnlyCredit(const bool fAsset, const uint256* pA
 
         if(fAsset)
         {
-            CAppHeader header;
-            std::vector<unsigned char> vData;
-            if(!ParseReserve(txout.vReserve, header, vData))
-                continue;
-
-            if(header.nAppCmd != TRANSFER_ASSET_CMD)
-                continue;
-
-            CCommonData transferData;
-            if(!ParseCommonData(vData, transferData))
+            CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+            if(!payload || payload->header.nAppCmd != TRANSFER_ASSET_CMD)
                 continue;
-            if(transferData.assetId != *pAssetId)
+            if(!payload->fBody || payload->assetId != *pAssetId)
                 continue;
         }
 
@@ -2463,43 +2504,11 @@ CAmount CWalletTx::GetAvailableWatchOnlyCredit(const bool fAsset, const uint256*
 
         if(fAsset)
         {
-            CAppHeader header;
-            std::vector<unsigned char> vData;
-            if(!ParseReserve(txout.vReserve, header, vData))
+            CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+            if(!payload)
+                continue;
+            if(payload->IsAssetCmd() && (!payload->fBody || payload->assetId != *pAssetId))
                 continue;
-
-            if(header.nAppCmd == ISSUE_ASSET_CMD)
-            {
-                CAssetData assetData;
-                if(!ParseIssueData(vData, assetData))
-                    continue;
-                if(assetData.GetHash() != *pAssetId)
-                    continue;
-            }
-            else if(header.nAppCmd == ADD_ASSET_CMD || header.nAppCmd == TRANSFER_ASSET_CMD || header.nAppCmd == DESTORY_ASSET_CMD || header.nAppCmd == CHANGE_ASSET_CMD)
-            {
-                CCommonData commonData;
-                if(!ParseCommonData(vData, commonData))
-                    continue;
-                if(commonData.assetId != *pAssetId)
-                    continue;
-            }
-            else if(header.nAppCmd == PUT_CANDY_CMD)
-            {
-                CPutCandyData candyData;
-                if(!ParsePutCandyData(vData, candyData))
-                    continue;
-                if(candyData.assetId != *pAssetId)
-                    continue;
-            }
-            else if(header.nAppCmd == GET_CANDY_CMD)
-            {
-                CGetCandyData candyData;
-                if(!ParseGetCandyData(vData, candyData))
-                    continue;
-                if(candyData.assetId != *pAssetId)
-                    continue;
-            }
         }
 
         nCredit += pwallet->GetCredit(txout, ISMINE_WATCH_ONLY, fAsset);
@@ -2780,38 +2789,19 @@ CAmount CWallet::GetBalance(const bool fAsset, const uint256* pAssetId, const CB
 {
     CAmount nTotal = 0;
     {
-        if(bLock)
-        {
-            LOCK2(cs_main, cs_wallet);
-            for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
-            {
-                boost::this_thread::interruption_point();
-                const CWalletTx* pcoin = &(*it).second;
-
-                if(pcoin->IsForbid())
-                    continue;
-
-                if (pcoin->IsTrusted())
-                    nTotal += pcoin->GetAvailableCredit(fAsset, pAssetId, pAddress, !fAsset);
-            }
-        }else
+        LOCK2(cs_main, cs_wallet);
+        if(fAsset && pAssetId)
+            return GetAssetBalances(*pAssetId, pAddress).nAvailable;
+        for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
         {
-            int count = 0;
-            for (map<uint256, CWalletTx>::const_iterator it = mapWallet_tmp.begin(); it != mapWallet_tmp.end(); ++it)
-            {
-                boost::this_thread::interruption_point();
-                const CWalletTx* pcoin = &(*it).second;
-
-                if(pcoin->IsForbid())
-                    continue;
+            boost::this_thread::interruption_point();
+            const CWalletTx* pcoin = &(*it).second;
 
-                if (pcoin->IsTrusted())
-                    nTotal += pcoin->GetAvailableCredit(fAsset, pAssetId, pAddress, !fAsset);
+            if(pcoin->IsForbid())
+                continue;
 
-                //count++;
-                //if(count%g_sleepCount==0)
-                //    MilliSleep(g_sleepTime);
-            }
+            if (pcoin->IsTrusted())
+                nTotal += pcoin->GetAvailableCredit(fAsset, pAssetId, pAddress, !fAsset);
         }
     }
 
@@ -2846,8 +2836,7 @@ CAmount CWallet::GetAnonymizedBalance(bool bLock) const
 
     CAmount nTotal = 0;
 
-    if(bLock)
-        LOCK2(cs_main, cs_wallet);
+    LOCK2(cs_main, cs_wallet);
 
     std::set<uint256> setWalletTxesCounted;
     for (auto& outpoint : setWalletUTXO) {
@@ -2856,30 +2845,13 @@ CAmount CWallet::GetAnonymizedBalance(bool bLock) const
         if (setWalletTxesCounted.find(outpoint.hash) != setWalletTxesCounted.end()) continue;
         setWalletTxesCounted.insert(outpoint.hash);
 
-        if(bLock)
-        {
-            for (map<uint256, CWalletTx>::const_iterator it = mapWallet.find(outpoint.hash); it != mapWallet.end() && it->first == outpoint.hash; ++it) {
-                boost::this_thread::interruption_point();
-                const CWalletTx* pcoin = &(*it).second;
-                if(pcoin->IsForbid())
-                    continue;
-                if (pcoin->IsTrusted())
-                    nTotal += it->second.GetAnonymizedCredit();
-            }
-        }else
-        {
-            int count = 0;
-            for (map<uint256, CWalletTx>::const_iterator it = mapWallet_tmp.find(outpoint.hash); it != mapWallet_tmp.end() && it->first == outpoint.hash; ++it) {
-                boost::this_thread::interruption_point();
-                const CWalletTx* pcoin = &(*it).second;
-                if(pcoin->IsForbid())
-                    continue;
-                if (pcoin->IsTrusted())
-                    nTotal += it->second.GetAnonymizedCredit();
-                /*count++;
-                if(count%g_sleepCount==0)
-                    MilliSleep(g_sleepTime);*/
-            }
+        for (map<uint256, CWalletTx>::const_iterator it = mapWallet.find(outpoint.hash); it != mapWallet.end() && it->first == outpoint.hash; ++it) {
+            boost::this_thread::interruption_point();
+            const CWalletTx* pcoin = &(*it).second;
+            if(pcoin->IsForbid())
+                continue;
+            if (pcoin->IsTrusted())
+                nTotal += it->second.GetAnonymizedCredit();
         }
     }
 
@@ -2976,33 +2948,17 @@ CAmount CWallet::GetUnconfirmedBalance(const bool fAsset, const uint256* pAssetI
 {
     CAmount nTotal = 0;
     {
-        if(bLock)
-        {
-            LOCK2(cs_main, cs_wallet);
-            for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
-            {
-                boost::this_thread::interruption_point();
-                const CWalletTx* pcoin = &(*it).second;
-                if(pcoin->IsForbid())
-                    continue;
-                if (!pcoin->IsTrusted() && pcoin->GetDepthInMainChain() == 0 && pcoin->InMempool())
-                    nTotal += pcoin->GetAvailableCredit(fAsset, pAssetId, pAddress, !fAsset);
-            }
-        }else
+        LOCK2(cs_main, cs_wallet);
+        if(fAsset && pAssetId)
+            return GetAssetBalances(*pAssetId, pAddress).nUnconfirmed;
+        for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
         {
-            int count = 0;
-            for (map<uint256, CWalletTx>::const_iterator it = mapWallet_tmp.begin(); it != mapWallet_tmp.end(); ++it)
-            {
-                boost::this_thread::interruption_point();
-                const CWalletTx* pcoin = &(*it).second;
-                if(pcoin->IsForbid())
-                    continue;
-                if (!pcoin->IsTrusted() && pcoin->GetDepthInMainChain() == 0 && pcoin->InMempool())
-                    nTotal += pcoin->GetAvailableCredit(fAsset, pAssetId, pAddress, !fAsset);
-                //count++;
-                //if(count%g_sleepCount==0)
-                //    MilliSleep(g_sleepTime);
-            }
+            boost::this_thread::interruption_point();
+            const CWalletTx* pcoin = &(*it).second;
+            if(pcoin->IsForbid())
+                continue;
+            if (!pcoin->IsTrusted() && pcoin->GetDepthInMainChain() == 0 && pcoin->InMempool())
+                nTotal += pcoin->GetAvailableCredit(fAsset, pAssetId, pAddress, !fAsset);
         }
     }
     return nTotal;
@@ -3012,31 +2968,16 @@ CAmount CWallet::GetImmatureBalance(const bool fAsset, const uint256* pAssetId,
 {
     CAmount nTotal = 0;
     {
-        if(bLock)
-        {
-            LOCK2(cs_main, cs_wallet);
-            for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
-            {
-                boost::this_thread::interruption_point();
-                const CWalletTx* pcoin = &(*it).second;
-                if(pcoin->IsForbid())
-                    continue;
-                nTotal += pcoin->GetImmatureCredit(fAsset, pAssetId, pAddress, !fAsset);
-            }
-        }else
+        LOCK2(cs_main, cs_wallet);
+        if(fAsset && pAssetId)
+            return GetAssetBalances(*pAssetId, pAddress).nImmature;
+        for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
         {
-            int count = 0;
-            for (map<uint256, CWalletTx>::const_iterator it = mapWallet_tmp.begin(); it != mapWallet_tmp.end(); ++it)
-            {
-                boost::this_thread::interruption_point();
-                const CWalletTx* pcoin = &(*it).second;
-                if(pcoin->IsForbid())
-                    continue;
-                nTotal += pcoin->GetImmatureCredit(fAsset, pAssetId, pAddress, !fAsset);
-                //count++;
-                //if(count%g_sleepCount==0)
-                //    MilliSleep(g_sleepTime);
-            }
+            boost::this_thread::interruption_point();
+            const CWalletTx* pcoin = &(*it).second;
+            if(pcoin->IsForbid())
+                continue;
+            nTotal += pcoin->GetImmatureCredit(fAsset, pAssetId, pAddress, !fAsset);
         }
     }
     return nTotal;
@@ -3047,30 +2988,16 @@ CAmount CWallet::GetLockedBalance(const bool fAsset, const uint256* pAssetId, co
     CAmount nTotal = 0;
     int count = 0;
     {
-        if(bLock)
-        {
-            LOCK2(cs_main, cs_wallet);
-            for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
-            {
-                boost::this_thread::interruption_point();
-                const CWalletTx* pcoin = &(*it).second;
-                if(pcoin->IsForbid())
-                    continue;
-                nTotal += pcoin->GetLockedCredit(fAsset, pAssetId, pAddress);
-            }
-        }else
+        LOCK2(cs_main, cs_wallet);
+        if(fAsset && pAssetId)
+            return GetAssetBalances(*pAssetId, pAddress).nLocked;
+        for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
         {
-            for (map<uint256, CWalletTx>::const_iterator it = mapWallet_tmp.begin(); it != mapWallet_tmp.end(); ++it)
-            {
-                boost::this_thread::interruption_point();
-                const CWalletTx* pcoin = &(*it).second;
-                if(pcoin->IsForbid())
-                    continue;
-                nTotal += pcoin->GetLockedCredit(fAsset, pAssetId, pAddress);
-                //count++;
-                //if(count%g_sleepCount==0)
-                //    MilliSleep(g_sleepTime);
-            }
+            boost::this_thread::interruption_point();
+            const CWalletTx* pcoin = &(*it).second;
+            if(pcoin->IsForbid())
+                continue;
+            nTotal += pcoin->GetLockedCredit(fAsset, pAssetId, pAddress);
         }
     }
 
@@ -3081,26 +3008,13 @@ CAmount CWallet::GetWatchOnlyBalance(const bool fAsset, const uint256* pAssetId,
 {
     CAmount nTotal = 0;
     {
-		if (bLock)
-		{
-			LOCK2(cs_main, cs_wallet);
-			for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
-			{
-				boost::this_thread::interruption_point();
-				const CWalletTx* pcoin = &(*it).second;
-				if (pcoin->IsTrusted())
-					nTotal += pcoin->GetAvailableWatchOnlyCredit(fAsset, pAssetId, pAddress, !fAsset);
-			}
-		}
-		else
+		LOCK2(cs_main, cs_wallet);
+		for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
 		{
-			for (map<uint256, CWalletTx>::const_iterator it = mapWallet_tmp.begin(); it != mapWallet_tmp.end(); ++it)
-			{
-				boost::this_thread::interruption_point();
-				const CWalletTx* pcoin = &(*it).second;
-				if (pcoin->IsTrusted())
-					nTotal += pcoin->GetAvailableWatchOnlyCredit(fAsset, pAssetId, pAddress, !fAsset);
-			}
+			boost::this_thread::interruption_point();
+			const CWalletTx* pcoin = &(*it).second;
+			if (pcoin->IsTrusted())
+				nTotal += pcoin->GetAvailableWatchOnlyCredit(fAsset, pAssetId, pAddress, !fAsset);
 		}
     }
 
@@ -3111,26 +3025,13 @@ CAmount CWallet::GetUnconfirmedWatchOnlyBalance(const bool fAsset, const uint256
 {
     CAmount nTotal = 0;
     {
-		if (bLock)
-		{
-			LOCK2(cs_main, cs_wallet);
-			for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
-			{
-				boost::this_thread::interruption_point();
-				const CWalletTx* pcoin = &(*it).second;
-				if (!pcoin->IsTrusted() && pcoin->GetDepthInMainChain() == 0 && pcoin->InMempool())
-					nTotal += pcoin->GetAvailableWatchOnlyCredit(fAsset, pAssetId, pAddress, !fAsset);
-			}
-		}
-		else
+		LOCK2(cs_main, cs_wallet);
+		for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
 		{
-			for (map<uint256, CWalletTx>::const_iterator it = mapWallet_tmp.begin(); it != mapWallet_tmp.end(); ++it)
-			{
-				boost::this_thread::interruption_point();
-				const CWalletTx* pcoin = &(*it).second;
-				if (!pcoin->IsTrusted() && pcoin->GetDepthInMainChain() == 0 && pcoin->InMempool())
-					nTotal += pcoin->GetAvailableWatchOnlyCredit(fAsset, pAssetId, pAddress, !fAsset);
-			}
+			boost::this_thread::interruption_point();
+			const CWalletTx* pcoin = &(*it).second;
+			if (!pcoin->IsTrusted() && pcoin->GetDepthInMainChain() == 0 && pcoin->InMempool())
+				nTotal += pcoin->GetAvailableWatchOnlyCredit(fAsset, pAssetId, pAddress, !fAsset);
 		}
     }
     return nTotal;
@@ -3140,24 +3041,12 @@ CAmount CWallet::GetImmatureWatchOnlyBalance(const bool fAsset, const uint256* p
 {
     CAmount nTotal = 0;
     {
-		if (bLock)
-		{
-			LOCK2(cs_main, cs_wallet);
-			for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
-			{
-				boost::this_thread::interruption_point();
-				const CWalletTx* pcoin = &(*it).second;
-				nTotal += pcoin->GetImmatureWatchOnlyCredit(fAsset, pAssetId, pAddress, !fAsset);
-			}
-		}
-		else
+		LOCK2(cs_main, cs_wallet);
+		for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
 		{
-			for (map<uint256, CWalletTx>::const_iterator it = mapWallet_tmp.begin(); it != mapWallet_tmp.end(); ++it)
-			{
-				boost::this_thread::interruption_point();
-				const CWalletTx* pcoin = &(*it).second;
-				nTotal += pcoin->GetImmatureWatchOnlyCredit(fAsset, pAssetId, pAddress, !fAsset);
-			}
+			boost::this_thread::interruption_point();
+			const CWalletTx* pcoin = &(*it).second;
+			nTotal += pcoin->GetImmatureWatchOnlyCredit(fAsset, pAssetId, pAddress, !fAsset);
 		}
     }
     return nTotal;
@@ -3168,34 +3057,107 @@ CAmount CWallet::GetLockedWatchOnlyBalance(const bool fAsset, const uint256* pAs
     CAmount nTotal = 0;
 
     {
-        if(bLock)
+        LOCK2(cs_main, cs_wallet);
+        for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
         {
-            LOCK2(cs_main, cs_wallet);
-            for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
-            {
-                boost::this_thread::interruption_point();
-                const CWalletTx* pcoin = &(*it).second;
-                nTotal += pcoin->GetLockedWatchOnlyCredit(fAsset, pAssetId, pAddress);
-            }
+            boost::this_thread::interruption_point();
+            const CWalletTx* pcoin = &(*it).second;
+            nTotal += pcoin->GetLockedWatchOnlyCredit(fAsset, pAssetId, pAddress);
         }
-		else
+    }
+
+    return nTotal;
+}
+
+
+void CWallet::UpdateAssetBalances() const
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
+
+    uint256 hashTip = chainActive.Tip() ? chainActive.Tip()->GetBlockHash() : uint256();
+    unsigned int nMempoolUpdated = mempool.GetTransactionsUpdated();
+    if (fAssetBalancesCached && hashAssetBalancesTip == hashTip && nAssetBalancesHeight == g_nChainHeight && nAssetBalancesMempoolUpdated == nMempoolUpdated)
+        return;
+
+    // Same filters as GetAvailableCredit, GetLockedCredit and GetImmatureCredit, for all assets at once
+    mapAssetBalances.clear();
+    for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
+    {
+        boost::this_thread::interruption_point();
+        const CWalletTx& wtx = (*it).second;
+        if (wtx.IsForbid())
+            continue;
+
+        bool fImmature = wtx.IsCoinBase() && wtx.GetBlocksToMaturity() > 0;
+        bool fImmatureInMainChain = fImmature && wtx.IsInMainChain();
+        bool fTrusted = wtx.IsTrusted();
+        bool fUnconfirmed = !fTrusted && wtx.GetDepthInMainChain() == 0 && wtx.InMempool();
+        uint256 hashTx = wtx.GetHash();
+        for (unsigned int i = 0; i < wtx.vout.size(); i++)
         {
-            int count = 0;
-            for (map<uint256, CWalletTx>::const_iterator it = mapWallet_tmp.begin(); it != mapWallet_tmp.end(); ++it)
+            const CTxOut& txout = wtx.vout[i];
+            if (!txout.IsAsset())
+                continue;
+
+            CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+            if (!payload || !payload->IsAssetCmd() || !payload->fBody)
+                continue;
+
+            if (!(IsMine(txout) & ISMINE_SPENDABLE))
+                continue;
+
+            CAssetBalance delta;
+            if (fImmature)
             {
-                boost::this_thread::interruption_point();
-                const CWalletTx* pcoin = &(*it).second;
-                nTotal += pcoin->GetLockedWatchOnlyCredit(fAsset, pAssetId, pAddress);
-                count++;
-                if(count%g_sleepCount==0)
-                    MilliSleep(g_sleepTime);
+                if (fImmatureInMainChain)
+                    delta.nImmature = txout.nValue;
+            }
+            else if (!IsSpent(hashTx, i))
+            {
+                if (IsLockedTxOutByHeight(wtx.nTxHeight, txout, wtx.nVersion))
+                {
+                    if (payload->header.nAppCmd == TRANSFER_ASSET_CMD)
+                        delta.nLocked = txout.nValue;
+                }
+                else if (fTrusted)
+                    delta.nAvailable = txout.nValue;
+                else if (fUnconfirmed)
+                    delta.nUnconfirmed = txout.nValue;
+            }
+
+            CTxDestination dest;
+            bool fDest = ExtractDestination(txout.scriptPubKey, dest);
+            for (int j = 0; j < (fDest ? 2 : 1); j++)
+            {
+                CAssetBalance& balance = mapAssetBalances[std::make_pair(payload->assetId, j == 0 ? CTxDestination(CNoDestination()) : dest)];
+                balance.nAvailable += delta.nAvailable;
+                balance.nUnconfirmed += delta.nUnconfirmed;
+                balance.nImmature += delta.nImmature;
+                balance.nLocked += delta.nLocked;
             }
         }
     }
 
-    return nTotal;
+    fAssetBalancesCached = true;
+    hashAssetBalancesTip = hashTip;
+    nAssetBalancesHeight = g_nChainHeight;
+    nAssetBalancesMempoolUpdated = nMempoolUpdated;
 }
 
+CAssetBalance CWallet::GetAssetBalances(const uint256& assetId, const CBitcoinAddress* pAddress) const
+{
+    UpdateAssetBalances();
+
+    CTxDestination dest = CNoDestination();
+    if (pAddress && pAddress->IsValid())
+        dest = pAddress->Get();
+
+    AssetBalanceMap::const_iterator it = mapAssetBalances.find(std::make_pair(assetId, dest));
+    if (it == mapAssetBalances.end())
+        return CAssetBalance();
+    return it->second;
+}
 
 bool CWallet::GetAssetBalance(const uint256* pAssetId, bool bLock, CAmount &totalBalance, CAmount &unconfirmedBalance, CAmount &lockBalance) const
 {
@@ -3208,59 +3170,70 @@ bool CWallet::GetAssetBalance(const uint256* pAssetId, bool bLock, CAmount &tota
 	unconfirmedBalance = 0;
 	lockBalance = 0;
 
-	if (bLock)
-	{
-		LOCK2(cs_main, cs_wallet);
-		for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
-		{
-			boost::this_thread::interruption_point();
-			const CWalletTx* pcoin = &(*it).second;
+	LOCK2(cs_main, cs_wallet);
+	CAssetBalance balance = GetAssetBalances(*pAssetId);
+	totalBalance = balance.nAvailable;
+	unconfirmedBalance = balance.nUnconfirmed;
+	lockBalance = balance.nLocked;
+	
+	return true;
+}
 
-			if (pcoin->IsForbid())
-				continue;
+std::pair<bool, uint256> CWallet::GetCoinIndexKey(const CTxOut& txout, bool& fIndexed)
+{
+    fIndexed = true;
+    if(!txout.IsAsset())
+        return std::make_pair(false, uint256());
 
-			if (pcoin->IsTrusted())
-			{
-				totalBalance += pcoin->GetAvailableCredit(true, pAssetId, NULL, false);
-			}
-			else
-			{
-				if (pcoin->GetDepthInMainChain() == 0 && pcoin->InMempool())
-				{
-					unconfirmedBalance += pcoin->GetAvailableCredit(true, pAssetId, NULL, false);
-				}
-			}
+    CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+    if(!payload)
+    {
+        fIndexed = false;
+        return std::make_pair(true, uint256());
+    }
 
-			lockBalance += pcoin->GetLockedCredit(true, pAssetId, NULL);
-		}
-	}
-	else
-	{
-		for (map<uint256, CWalletTx>::const_iterator it = mapWallet_tmp.begin(); it != mapWallet_tmp.end(); ++it)
-		{
-			boost::this_thread::interruption_point();
-			const CWalletTx* pcoin = &(*it).second;
+    // same commands as the asset id filter in AvailableCoins, the others match any asset
+    const uint32_t& nAppCmd = payload->header.nAppCmd;
+    if(nAppCmd == ISSUE_ASSET_CMD || nAppCmd == ADD_ASSET_CMD || nAppCmd == TRANSFER_ASSET_CMD || nAppCmd == CHANGE_ASSET_CMD || nAppCmd == GET_CANDY_CMD)
+    {
+        if(!payload->fBody)
+            fIndexed = false;
+        return std::make_pair(true, payload->assetId);
+    }
+    return std::make_pair(true, uint256());
+}
 
-			if (pcoin->IsForbid())
-				continue;
+void CWallet::UpdateCoinIndex() const
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
 
-			if (pcoin->IsTrusted())
-			{
-				totalBalance += pcoin->GetAvailableCredit(true, pAssetId, NULL, false);
-			}
-			else
-			{
-				if (pcoin->GetDepthInMainChain() == 0 && pcoin->InMempool())
-				{
-					unconfirmedBalance += pcoin->GetAvailableCredit(true, pAssetId, NULL, false);
-				}
-			}
+    BOOST_FOREACH(const uint256& hash, setCoinIndexDirty)
+    {
+        map<uint256, CWalletTx>::const_iterator it = mapWallet.find(hash);
+        if(it == mapWallet.end())
+            continue;
 
-			lockBalance += pcoin->GetLockedCredit(true, pAssetId, NULL);
-		}
-	}
-	
-	return true;
+        const CWalletTx& wtx = (*it).second;
+        for(unsigned int i = 0; i < wtx.vout.size(); i++)
+        {
+            bool fIndexed = false;
+            std::pair<bool, uint256> key = GetCoinIndexKey(wtx.vout[i], fIndexed);
+            if(!fIndexed)
+                continue;
+
+            COutPoint outpoint(hash, i);
+            if(IsMine(wtx.vout[i]) != ISMINE_NO && !IsSpent(hash, i))
+                mapCoinIndex[key].insert(outpoint);
+            else
+            {
+                CoinIndexMap::iterator mi = mapCoinIndex.find(key);
+                if(mi != mapCoinIndex.end())
+                    mi->second.erase(outpoint);
+            }
+        }
+    }
+    setCoinIndexDirty.clear();
 }
 
 void CWallet::AvailableCoins(vector<COutput>& vCoins, bool fOnlyConfirmed, const CCoinControl *coinControl, bool fIncludeZeroValue, AvailableCoinsType nCoinType, bool fUseInstantSend, bool fContainLockedTxOut, const CBitcoinAddress* pFixedSrcAddress, const bool fAsset, const uint256* pAssetId) const
@@ -3271,11 +3244,30 @@ void CWallet::AvailableCoins(vector<COutput>& vCoins, bool fOnlyConfirmed, const
 
     {
         LOCK2(cs_main, cs_wallet);
-        for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
+
+        // Only visit the outputs indexed under the requested asset, or under SAFE
+        UpdateCoinIndex();
+        std::map<uint256, std::vector<unsigned int> > mapCandidates;
+        for(int k = 0; k < (fAsset ? 2 : 1); k++)
+        {
+            CoinIndexMap::const_iterator mi = mapCoinIndex.find(std::make_pair(fAsset, k == 0 && fAsset ? *pAssetId : uint256()));
+            if(mi == mapCoinIndex.end())
+                continue;
+            BOOST_FOREACH(const COutPoint& outpoint, mi->second)
+                mapCandidates[outpoint.hash].push_back(outpoint.n);
+        }
+
+        for (std::map<uint256, std::vector<unsigned int> >::iterator ci = mapCandidates.begin(); ci != mapCandidates.end(); ++ci)
         {
             boost::this_thread::interruption_point();
+            map<uint256, CWalletTx>::const_iterator it = mapWallet.find(ci->first);
+            if (it == mapWallet.end())
+                continue;
+
             const uint256& wtxid = it->first;
             const CWalletTx* pcoin = &(*it).second;
+            std::vector<unsigned int>& vOutputs = ci->second;
+            std::sort(vOutputs.begin(), vOutputs.end());
 
             if (!CheckFinalTx(*pcoin))
                 continue;
@@ -3318,7 +3310,7 @@ void CWallet::AvailableCoins(vector<COutput>& vCoins, bool fOnlyConfirmed, const
                     continue;
             }
 
-            for (unsigned int i = 0; i < pcoin->vout.size(); i++) {
+            BOOST_FOREACH(const unsigned int i, vOutputs) {
                 boost::this_thread::interruption_point();
                 if(!fContainLockedTxOut && IsLockedTxOutByHeight(nBlockHeight, pcoin->vout[i], pcoin->nVersion) && nCoinType != ONLY_1000)
                     continue;
@@ -3328,49 +3320,30 @@ void CWallet::AvailableCoins(vector<COutput>& vCoins, bool fOnlyConfirmed, const
 
                 if(fAsset)
                 {
-                    CAppHeader header;
-                    std::vector<unsigned char> vData;
-                    if(!ParseReserve(pcoin->vout[i].vReserve, header, vData))
+                    CAppPayloadRef payload = GetAppPayload(pcoin->vout[i].vReserve);
+                    if(!payload)
                         continue;
 
-                    if(header.nAppCmd == ISSUE_ASSET_CMD || header.nAppCmd == ADD_ASSET_CMD || header.nAppCmd == GET_CANDY_CMD)
+                    const uint32_t& nAppCmd = payload->header.nAppCmd;
+                    if(nAppCmd == ISSUE_ASSET_CMD || nAppCmd == ADD_ASSET_CMD || nAppCmd == GET_CANDY_CMD)
                     {
                         if(nDepth <= 0)
                             continue;
                     }
 
-                    if(header.nAppCmd == ISSUE_ASSET_CMD)
-                    {
-                        CAssetData assetData;
-                        if(!ParseIssueData(vData, assetData))
-                            continue;
-                        if(assetData.GetHash() != *pAssetId)
-                            continue;
-                    }
-                    else if(header.nAppCmd == ADD_ASSET_CMD || header.nAppCmd == TRANSFER_ASSET_CMD || header.nAppCmd == CHANGE_ASSET_CMD)
+                    if(nAppCmd == ISSUE_ASSET_CMD || nAppCmd == ADD_ASSET_CMD || nAppCmd == TRANSFER_ASSET_CMD || nAppCmd == CHANGE_ASSET_CMD || nAppCmd == GET_CANDY_CMD)
                     {
-                        CCommonData commonData;
-                        if(!ParseCommonData(vData, commonData))
-                            continue;
-                        if(commonData.assetId != *pAssetId)
-                            continue;
-                    }
-                    else if(header.nAppCmd == GET_CANDY_CMD)
-                    {
-                        CGetCandyData candyData;
-                        if(!ParseGetCandyData(vData, candyData))
-                            continue;
-                        if(candyData.assetId != *pAssetId)
+                        if(!payload->fBody || payload->assetId != *pAssetId)
                             continue;
                     }
                 }
                 else
                 {
-                    CAppHeader header;
-                    std::vector<unsigned char> vData;
-                    if(ParseReserve(pcoin->vout[i].vReserve, header, vData))
+                    CAppPayloadRef payload = GetAppPayload(pcoin->vout[i].vReserve);
+                    if(payload)
                     {
-                        if(header.nAppCmd == REGISTER_APP_CMD || header.nAppCmd == ADD_AUTH_CMD || header.nAppCmd == DELETE_AUTH_CMD || header.nAppCmd == CREATE_EXTEND_TX_CMD)
+                        const uint32_t& nAppCmd = payload->header.nAppCmd;
+                        if(nAppCmd == REGISTER_APP_CMD || nAppCmd == ADD_AUTH_CMD || nAppCmd == DELETE_AUTH_CMD || nAppCmd == CREATE_EXTEND_TX_CMD)
                         {
                             if(nDepth <= 0)
                                 continue;
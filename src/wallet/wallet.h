@@ -77,6 +77,11 @@ static const bool DEFAULT_WALLETBROADCAST = true;
 
 //! if set, all keys will be derived by using BIP39/BIP44
 static const bool DEFAULT_USE_HD_WALLET = false;
+//! -rescanthreads default, 0 = number of cores
+static const int DEFAULT_RESCAN_THREADS = 0;
+static const int MAX_RESCAN_THREADS = 16;
+//! Blocks each rescan thread reads ahead per batch
+static const int RESCAN_BLOCKS_PER_THREAD = 4;
 
 class CBlockIndex;
 class CCoinControl;
@@ -433,21 +438,7 @@ public:
     }
 
     //! make sure balances are recalculated
-    void MarkDirty()
-    {
-        fCreditCached = false;
-        fAvailableCreditCached = false;
-        fImmatureCreditCached = false;
-        fAnonymizedCreditCached = false;
-        fDenomUnconfCreditCached = false;
-        fDenomConfCreditCached = false;
-        fWatchDebitCached = false;
-        fWatchCreditCached = false;
-        fAvailableWatchCreditCached = false;
-        fImmatureWatchCreditCached = false;
-        fDebitCached = false;
-        fChangeCached = false;
-    }
+    void MarkDirty();
 
     void BindWallet(CWallet *pwalletIn)
     {
@@ -631,6 +622,35 @@ private:
 };
 
 
+/** State of the running or last ScanForWalletTransactions, see getrescaninfo */
+struct CRescanProgress
+{
+    bool fRunning;
+    int nThreads;
+    int nStartHeight;
+    int nStopHeight;
+    int nHeight;
+    int64_t nStartTime;
+    int64_t nEndTime;
+    int64_t nBlocks;
+    int64_t nTransactions;
+    int nFound;
+
+    CRescanProgress() : fRunning(false), nThreads(0), nStartHeight(-1), nStopHeight(-1), nHeight(-1),
+        nStartTime(0), nEndTime(0), nBlocks(0), nTransactions(0), nFound(0) {}
+};
+
+/** Spendable asset amounts of the wallet, per asset and optionally per address */
+struct CAssetBalance
+{
+    CAmount nAvailable;
+    CAmount nUnconfirmed;
+    CAmount nImmature;
+    CAmount nLocked;
+
+    CAssetBalance() : nAvailable(0), nUnconfirmed(0), nImmature(0), nLocked(0) {}
+};
+
 /**
  * A CWallet is an extension of a keystore, which also maintains a set of transactions and balances,
  * and provides the ability to create new transactions.
@@ -662,6 +682,35 @@ private:
     mutable bool fAnonymizableTallyCachedNonDenom;
     mutable std::vector<CompactTallyItem> vecAnonymizableTallyCachedNonDenom;
 
+    /**
+     * Asset balances of mapWallet keyed by (assetId, address), the totals of
+     * an asset are kept under CNoDestination. Rebuilt in a single pass when a
+     * wallet transaction changed or the tip, chain height or mempool moved.
+     */
+    typedef std::map<std::pair<uint256, CTxDestination>, CAssetBalance> AssetBalanceMap;
+    mutable AssetBalanceMap mapAssetBalances;
+    mutable bool fAssetBalancesCached;
+    mutable uint256 hashAssetBalancesTip;
+    mutable int nAssetBalancesHeight;
+    mutable unsigned int nAssetBalancesMempoolUpdated;
+    void UpdateAssetBalances() const;
+
+    mutable unsigned int nWalletGeneration;
+
+    /**
+     * Unspent outputs of mapWallet which are ours, partitioned by (fAsset, assetId).
+     * Asset outputs which match any asset in AvailableCoins are kept under a null
+     * assetId. Transactions marked dirty are reindexed on the next lookup.
+     */
+    typedef std::map<std::pair<bool, uint256>, std::set<COutPoint> > CoinIndexMap;
+    mutable CoinIndexMap mapCoinIndex;
+    mutable std::set<uint256> setCoinIndexDirty;
+    void UpdateCoinIndex() const;
+    static std::pair<bool, uint256> GetCoinIndexKey(const CTxOut& txout, bool& fIndexed);
+
+    mutable CCriticalSection cs_rescanProgress;
+    CRescanProgress rescanProgress;
+
     /**
      * Used to keep track of spent outpoints, and
      * detect and report conflicts (double-spends or
@@ -754,11 +803,13 @@ public:
         fAnonymizableTallyCachedNonDenom = false;
         vecAnonymizableTallyCached.clear();
         vecAnonymizableTallyCachedNonDenom.clear();
+        fAssetBalancesCached = false;
+        nAssetBalancesHeight = 0;
+        nAssetBalancesMempoolUpdated = 0;
+        nWalletGeneration = 1;
     }
 
     std::map<uint256, CWalletTx> mapWallet;
-    std::map<uint256, int> mapWallet_bk;
-    std::map<uint256, CWalletTx> mapWallet_tmp;
     std::list<CAccountingEntry> laccentries;
 
     typedef std::pair<CWalletTx*, CAccountingEntry*> TxPair;
@@ -890,6 +941,8 @@ public:
     void SyncTransaction(const CTransaction& tx, const CBlock* pblock);
     bool AddToWalletIfInvolvingMe(const CTransaction& tx, const CBlock* pblock, bool fUpdate);
     int ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate = false);
+    /** Does not need cs_main or cs_wallet, so it can be polled while a rescan holds them */
+    CRescanProgress GetRescanProgress() const;
     void ReacceptWalletTransactions();
     void ResendWalletTransactions(int64_t nBestBlockTime, CConnman* connman);
     std::vector<uint256> ResendWalletTransactionsBefore(int64_t nTime, CConnman* connman);
@@ -902,6 +955,21 @@ public:
     CAmount GetImmatureWatchOnlyBalance(const bool fAsset = false, const uint256* pAssetId = NULL, const CBitcoinAddress* pAddress = NULL,bool bLock=true) const;
     CAmount GetLockedWatchOnlyBalance(const bool fAsset = false, const uint256* pAssetId = NULL, const CBitcoinAddress* pAddress = NULL,bool bLock=true) const;
 	bool GetAssetBalance(const uint256* pAssetId, bool bLock, CAmount &totalBalance, CAmount &unconfirmedBalance, CAmount &lockBalance) const;
+    /** Balances of an asset, restricted to pAddress if it is valid, cs_main and cs_wallet must be held */
+    CAssetBalance GetAssetBalances(const uint256& assetId, const CBitcoinAddress* pAddress = NULL) const;
+    /** Invalidate the balance ledger and the coin index entry of a changed wallet transaction */
+    void MarkTxDirty(const uint256& hash) const
+    {
+        fAssetBalancesCached = false;
+        setCoinIndexDirty.insert(hash);
+        nWalletGeneration++;
+    }
+    /**
+     * Counter bumped whenever a wallet transaction was marked dirty, so pollers
+     * can skip unchanged wallets. Starts at 1, a poller caching 0 always reads
+     * the wallet once. cs_wallet must be held.
+     */
+    unsigned int GetWalletGeneration() const { return nWalletGeneration; }
 
     CAmount GetAnonymizableBalance(bool fSkipDenominated = false, bool fSkipUnconfirmed = true) const;
     CAmount GetAnonymizedBalance(bool bLock=true) const;
@@ -593,6 +593,21 @@ ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue,
                 return false;
             }
         }
+        else if (strType == "candyeligibility")
+        {
+            CCandyEligibility eligibility;
+            ssValue >> eligibility;
+            // salvagewallet reads the records into a dummy wallet
+            if (pwallet->fFileBacked)
+                LoadCandyEligibility(eligibility);
+        }
+        else if (strType == "candyeligibilitymarker")
+        {
+            std::pair<int, uint256> marker;
+            ssValue >> marker;
+            if (pwallet->fFileBacked)
+                LoadCandyEligibilityMarker(marker.first, marker.second);
+        }
         else if (strType == "hdchain")
         {
             CHDChain chain;
@@ -1162,6 +1177,24 @@ bool CWalletDB::EraseDestData(const std::string &address, const std::string &key
     return Erase(std::make_pair(std::string("destdata"), std::make_pair(address, key)));
 }
 
+bool CWalletDB::WriteCandyEligibility(const COutPoint& out, const CCandyEligibility& eligibility)
+{
+    nWalletDBUpdated++;
+    return Write(std::make_pair(std::string("candyeligibility"), out), eligibility);
+}
+
+bool CWalletDB::EraseCandyEligibility(const COutPoint& out)
+{
+    nWalletDBUpdated++;
+    return Erase(std::make_pair(std::string("candyeligibility"), out));
+}
+
+bool CWalletDB::WriteCandyEligibilityMarker(const int& nHeight, const uint256& hashKeys)
+{
+    nWalletDBUpdated++;
+    return Write(std::string("candyeligibilitymarker"), std::make_pair(nHeight, hashKeys));
+}
+
 bool CWalletDB::WriteHDChain(const CHDChain& chain)
 {
     nWalletDBUpdated++;
@@ -22,6 +22,8 @@ static const bool DEFAULT_FLUSHWALLET = true;
 class CAccount;
 class CAccountingEntry;
 struct CBlockLocator;
+struct CCandyEligibility;
+class COutPoint;
 class CKeyPool;
 class CMasterKey;
 class CScript;
@@ -124,6 +126,10 @@ public:
     /// Erase destination data tuple from wallet database
     bool EraseDestData(const std::string &address, const std::string &key);
 
+    bool WriteCandyEligibility(const COutPoint& out, const CCandyEligibility& eligibility);
+    bool EraseCandyEligibility(const COutPoint& out);
+    bool WriteCandyEligibilityMarker(const int& nHeight, const uint256& hashKeys);
+
     CAmount GetAccountCreditDebit(const std::string& strAccount);
     void ListAccountCreditDebit(const std::string& strAccount, std::list<CAccountingEntry>& acentries);
 
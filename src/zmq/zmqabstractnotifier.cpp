@@ -25,3 +25,8 @@ bool CZMQAbstractNotifier::NotifyTransactionLock(const CTransaction &/*transacti
 {
     return true;
 }
+
+bool CZMQAbstractNotifier::NotifyAppTransaction(const CTransaction &/*transaction*/, const CBlockIndex * /*pindex*/, ZMQAppTxEvent /*event*/)
+{
+    return true;
+}
@@ -12,6 +12,13 @@ class CZMQAbstractNotifier;
 
 typedef CZMQAbstractNotifier* (*CZMQNotifierFactory)();
 
+/** Why an asset or app transaction is notified */
+enum ZMQAppTxEvent {
+    ZMQ_APPTX_MEMPOOL = 0,
+    ZMQ_APPTX_CONNECTED = 1,
+    ZMQ_APPTX_DISCONNECTED = 2,
+};
+
 class CZMQAbstractNotifier
 {
 public:
@@ -35,6 +42,8 @@ public:
     virtual bool NotifyBlock(const CBlockIndex *pindex);
     virtual bool NotifyTransaction(const CTransaction &transaction);
     virtual bool NotifyTransactionLock(const CTransaction &transaction);
+    /** pindex is the block of transaction, NULL for ZMQ_APPTX_MEMPOOL */
+    virtual bool NotifyAppTransaction(const CTransaction &transaction, const CBlockIndex *pindex, ZMQAppTxEvent event);
 
 protected:
     void *psocket;
@@ -41,6 +41,11 @@ CZMQNotificationInterface* CZMQNotificationInterface::CreateWithArguments(const
     factories["pubrawblock"] = CZMQAbstractNotifier::Create<CZMQPublishRawBlockNotifier>;
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
     factories["pubrawtxlock"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionLockNotifier>;
+    factories["pubassettx"] = CZMQAbstractNotifier::Create<CZMQPublishAssetTransactionNotifier>;
+    factories["pubassetissue"] = CZMQAbstractNotifier::Create<CZMQPublishAssetIssueNotifier>;
+    factories["pubappregister"] = CZMQAbstractNotifier::Create<CZMQPublishAppRegisterNotifier>;
+    factories["pubcandyput"] = CZMQAbstractNotifier::Create<CZMQPublishCandyPutNotifier>;
+    factories["pubcandyget"] = CZMQAbstractNotifier::Create<CZMQPublishCandyGetNotifier>;
 
     for (std::map<std::string, CZMQNotifierFactory>::const_iterator i=factories.begin(); i!=factories.end(); ++i)
     {
@@ -179,3 +184,38 @@ void CZMQNotificationInterface::NotifyTransactionLock(const CTransaction &tx)
         }
     }
 }
+
+void CZMQNotificationInterface::NotifyAppTransaction(const CTransaction &tx, const CBlockIndex *pindex, ZMQAppTxEvent event)
+{
+    for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
+    {
+        CZMQAbstractNotifier *notifier = *i;
+        if (notifier->NotifyAppTransaction(tx, pindex, event))
+        {
+            i++;
+        }
+        else
+        {
+            notifier->Shutdown();
+            i = notifiers.erase(i);
+        }
+    }
+}
+
+void CZMQNotificationInterface::TransactionAddedToMempool(const CTransaction &tx)
+{
+    NotifyAppTransaction(tx, NULL, ZMQ_APPTX_MEMPOOL);
+}
+
+void CZMQNotificationInterface::BlockConnected(const CBlock &block, const CBlockIndex *pindex)
+{
+    BOOST_FOREACH(const CTransaction &tx, block.vtx)
+        NotifyAppTransaction(tx, pindex, ZMQ_APPTX_CONNECTED);
+}
+
+void CZMQNotificationInterface::BlockDisconnected(const CBlock &block, const CBlockIndex *pindex)
+{
+    // newest first, the reverse of the connect order
+    for (std::vector<CTransaction>::const_reverse_iterator it = block.vtx.rbegin(); it != block.vtx.rend(); ++it)
+        NotifyAppTransaction(*it, pindex, ZMQ_APPTX_DISCONNECTED);
+}
@@ -6,11 +6,11 @@
 #define BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 
 #include "validationinterface.h"
+#include "zmqabstractnotifier.h"
 #include <string>
 #include <map>
 
 class CBlockIndex;
-class CZMQAbstractNotifier;
 
 class CZMQNotificationInterface : public CValidationInterface
 {
@@ -27,10 +27,15 @@ protected:
     void SyncTransaction(const CTransaction &tx, const CBlock *pblock);
     void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload);
     void NotifyTransactionLock(const CTransaction &tx);
+    void TransactionAddedToMempool(const CTransaction &tx);
+    void BlockConnected(const CBlock &block, const CBlockIndex *pindex);
+    void BlockDisconnected(const CBlock &block, const CBlockIndex *pindex);
 
 private:
     CZMQNotificationInterface();
 
+    void NotifyAppTransaction(const CTransaction &tx, const CBlockIndex *pindex, ZMQAppTxEvent event);
+
     void *pcontext;
     std::list<CZMQAbstractNotifier*> notifiers;
 };
@@ -2,6 +2,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include "app/app.h"
 #include "chainparams.h"
 #include "streams.h"
 #include "zmqpublishnotifier.h"
@@ -16,6 +17,43 @@ static const char *MSG_HASHTXLOCK = "hashtxlock";
 static const char *MSG_RAWBLOCK   = "rawblock";
 static const char *MSG_RAWTX      = "rawtx";
 static const char *MSG_RAWTXLOCK = "rawtxlock";
+static const char *MSG_ASSETTX    = "assettx";
+static const char *MSG_ASSETISSUE = "assetissue";
+static const char *MSG_APPREGISTER = "appregister";
+static const char *MSG_CANDYPUT   = "candyput";
+static const char *MSG_CANDYGET   = "candyget";
+
+/** Body of the asset and app messages, one per matching output */
+struct CZMQAppTxRecord
+{
+    uint8_t nEvent;
+    int32_t nHeight;
+    uint256 blockHash;
+    COutPoint out;
+    CAppHeader header;
+    uint256 assetId;
+    CAmount nValue;
+    int64_t nUnlockedHeight;
+    std::string strAddress;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
+    {
+        READWRITE(nEvent);
+        READWRITE(nHeight);
+        READWRITE(blockHash);
+        READWRITE(out);
+        READWRITE(header.nVersion);
+        READWRITE(header.appId);
+        READWRITE(header.nAppCmd);
+        READWRITE(assetId);
+        READWRITE(nValue);
+        READWRITE(nUnlockedHeight);
+        READWRITE(strAddress);
+    }
+};
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -211,3 +249,90 @@ bool CZMQPublishRawTransactionLockNotifier::NotifyTransactionLock(const CTransac
     ss << transaction;
     return SendMessage(MSG_RAWTXLOCK, &(*ss.begin()), ss.size());
 }
+
+bool CZMQAbstractAppPublishNotifier::NotifyAppTransaction(const CTransaction &transaction, const CBlockIndex *pindex, ZMQAppTxEvent event)
+{
+    if (transaction.nVersion < SAFE_TX_VERSION_1)
+        return true;
+
+    uint256 hash = transaction.GetHash();
+    for (unsigned int i = 0; i < transaction.vout.size(); i++)
+    {
+        const CTxOut& txout = transaction.vout[i];
+        if (txout.IsSafeOnly())
+            continue;
+
+        CAppPayloadRef payload = GetAppPayload(txout.vReserve);
+        if (!payload || !IsMatch(*payload))
+            continue;
+
+        CZMQAppTxRecord record;
+        record.nEvent = (uint8_t)event;
+        record.nHeight = pindex ? pindex->nHeight : -1;
+        record.blockHash = pindex ? pindex->GetBlockHash() : uint256();
+        record.out = COutPoint(hash, i);
+        record.header = payload->header;
+        record.assetId = payload->assetId;
+        record.nValue = txout.nValue;
+        record.nUnlockedHeight = txout.nUnlockedHeight;
+        GetTxOutAddress(txout, &record.strAddress);
+
+        LogPrint("zmq", "zmq: Publish %s %s\n", GetCommand(), record.out.ToString());
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << record;
+        if (!SendMessage(GetCommand(), &(*ss.begin()), ss.size()))
+            return false;
+    }
+
+    return true;
+}
+
+const char* CZMQPublishAssetTransactionNotifier::GetCommand() const
+{
+    return MSG_ASSETTX;
+}
+
+bool CZMQPublishAssetTransactionNotifier::IsMatch(const CAppPayload &payload) const
+{
+    return payload.IsAssetCmd();
+}
+
+const char* CZMQPublishAssetIssueNotifier::GetCommand() const
+{
+    return MSG_ASSETISSUE;
+}
+
+bool CZMQPublishAssetIssueNotifier::IsMatch(const CAppPayload &payload) const
+{
+    return payload.header.nAppCmd == ISSUE_ASSET_CMD;
+}
+
+const char* CZMQPublishAppRegisterNotifier::GetCommand() const
+{
+    return MSG_APPREGISTER;
+}
+
+bool CZMQPublishAppRegisterNotifier::IsMatch(const CAppPayload &payload) const
+{
+    return payload.header.nAppCmd == REGISTER_APP_CMD;
+}
+
+const char* CZMQPublishCandyPutNotifier::GetCommand() const
+{
+    return MSG_CANDYPUT;
+}
+
+bool CZMQPublishCandyPutNotifier::IsMatch(const CAppPayload &payload) const
+{
+    return payload.header.nAppCmd == PUT_CANDY_CMD;
+}
+
+const char* CZMQPublishCandyGetNotifier::GetCommand() const
+{
+    return MSG_CANDYGET;
+}
+
+bool CZMQPublishCandyGetNotifier::IsMatch(const CAppPayload &payload) const
+{
+    return payload.header.nAppCmd == GET_CANDY_CMD;
+}
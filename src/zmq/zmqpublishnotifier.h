@@ -7,6 +7,7 @@
 
 #include "zmqabstractnotifier.h"
 
+class CAppPayload;
 class CBlockIndex;
 
 class CZMQAbstractPublishNotifier : public CZMQAbstractNotifier
@@ -64,4 +65,53 @@ public:
     bool NotifyTransactionLock(const CTransaction &transaction);
 };
 
+/**
+ * Publishes one record per asset or app output of a transaction that the
+ * topic matches, see doc/zmq.md for the record layout.
+ */
+class CZMQAbstractAppPublishNotifier : public CZMQAbstractPublishNotifier
+{
+protected:
+    virtual const char* GetCommand() const = 0;
+    virtual bool IsMatch(const CAppPayload &payload) const = 0;
+
+public:
+    bool NotifyAppTransaction(const CTransaction &transaction, const CBlockIndex *pindex, ZMQAppTxEvent event);
+};
+
+class CZMQPublishAssetTransactionNotifier : public CZMQAbstractAppPublishNotifier
+{
+protected:
+    const char* GetCommand() const;
+    bool IsMatch(const CAppPayload &payload) const;
+};
+
+class CZMQPublishAssetIssueNotifier : public CZMQAbstractAppPublishNotifier
+{
+protected:
+    const char* GetCommand() const;
+    bool IsMatch(const CAppPayload &payload) const;
+};
+
+class CZMQPublishAppRegisterNotifier : public CZMQAbstractAppPublishNotifier
+{
+protected:
+    const char* GetCommand() const;
+    bool IsMatch(const CAppPayload &payload) const;
+};
+
+class CZMQPublishCandyPutNotifier : public CZMQAbstractAppPublishNotifier
+{
+protected:
+    const char* GetCommand() const;
+    bool IsMatch(const CAppPayload &payload) const;
+};
+
+class CZMQPublishCandyGetNotifier : public CZMQAbstractAppPublishNotifier
+{
+protected:
+    const char* GetCommand() const;
+    bool IsMatch(const CAppPayload &payload) const;
+};
+
 #endif // BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H